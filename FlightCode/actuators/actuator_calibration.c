@@ -0,0 +1,185 @@
+/*! \file actuator_calibration.c
+ *	\brief Actuator calibration lookup table source code
+ *
+ *	\details Lookup tables of the PWM output and R/C input calibrations, and the startup check of the
+ *	calibrations of the aircraft configuration, see actuator_calibration.h.
+ *	\ingroup actuator_fcns
+ *
+ * \author University of Minnesota
+ * \author Aerospace Engineering and Mechanics
+ * \copyright Copyright 2015 Regents of the University of Minnesota. All rights reserved.
+ *
+ * $Id$
+ */
+
+#include "../globaldefs.h"
+#include AIRCRAFT_UP1DIR
+#include "../utils/misc.h"
+#include "actuator_calibration.h"
+
+#ifndef PWMIN_SCALING
+	#define PWMIN_SCALING	1
+#endif
+
+// local functions
+static int monotonic(const struct cal_table *t);
+
+// Checks of the aircraft configuration, in a scratch table
+#define CHECK_POLY(cal, s, xmin, xmax)	do { \
+		static const double c_[] = cal; \
+		if (cal_table_poly(&scratch, c_, sizeof(c_)/sizeof(c_[0]), s, xmin, xmax) != 0) \
+			send_status("actuator_calibration: " #cal " not monotonic over its range"); \
+	} while (0)
+#define CHECK_POINTS(tab)	do { \
+		static const double p_[][2] = tab; \
+		if (cal_table_points(&scratch, p_, sizeof(p_)/sizeof(p_[0])) != 0) \
+			send_status("actuator_calibration: " #tab " not a monotonic table"); \
+	} while (0)
+
+static struct cal_table scratch;
+
+int cal_table_poly(struct cal_table *t, const double *c, int n, double scale, double xmin, double xmax){
+	double dx = (xmax - xmin)/(CAL_TABLE_SIZE-1), x;
+	int i, k;
+
+	if (n < 1 || !(xmax > xmin))
+		return -1;
+
+	t->x0 = xmin;
+	t->inv_dx = 1.0/dx;
+	for (i = 0; i < CAL_TABLE_SIZE; i++){
+		x = (xmin + i*dx)/scale;
+		t->y[i] = c[0];
+		for (k = 1; k < n; k++)
+			t->y[i] = t->y[i]*x + c[k];
+	}
+	return monotonic(t);
+}
+
+int cal_table_points(struct cal_table *t, const double (*pts)[2], int n){
+	double dx, x;
+	int i, k = 0;
+
+	if (n < 2)
+		return -1;
+	for (i = 1; i < n; i++){
+		if (!(pts[i][0] > pts[i-1][0]))
+			return -1;
+	}
+
+	dx = (pts[n-1][0] - pts[0][0])/(CAL_TABLE_SIZE-1);
+	t->x0 = pts[0][0];
+	t->inv_dx = 1.0/dx;
+	for (i = 0; i < CAL_TABLE_SIZE; i++){
+		x = pts[0][0] + i*dx;
+		while (k < n-2 && x > pts[k+1][0])
+			k++;
+		t->y[i] = pts[k][1] + (x - pts[k][0])*(pts[k+1][1] - pts[k][1])/(pts[k+1][0] - pts[k][0]);
+	}
+	return monotonic(t);
+}
+
+void check_actuator_calibration(void){
+
+	// PWM outputs, surface command to counts
+#ifdef PWMOUT_DTHR_CAL
+	CHECK_POLY(PWMOUT_DTHR_CAL, 1.0, THROTTLE_MIN, THROTTLE_MAX);
+#endif
+#ifdef PWMOUT_DE_CAL
+	CHECK_POLY(PWMOUT_DE_CAL, 1.0, ELEVATOR_MIN, ELEVATOR_MAX);
+#endif
+#ifdef PWMOUT_DR_CAL
+	CHECK_POLY(PWMOUT_DR_CAL, 1.0, RUDDER_MIN, RUDDER_MAX);
+#endif
+#ifdef PWMOUT_DA_L_CAL
+	CHECK_POLY(PWMOUT_DA_L_CAL, 1.0, L_AILERON_MIN, L_AILERON_MAX);
+#endif
+#ifdef PWMOUT_DA_R_CAL
+	CHECK_POLY(PWMOUT_DA_R_CAL, 1.0, R_AILERON_MIN, R_AILERON_MAX);
+#endif
+#ifdef PWMOUT_DF_L_CAL
+	CHECK_POLY(PWMOUT_DF_L_CAL, 1.0, L_FLAP_MIN, L_FLAP_MAX);
+#endif
+#ifdef PWMOUT_DF_R_CAL
+	CHECK_POLY(PWMOUT_DF_R_CAL, 1.0, R_FLAP_MIN, R_FLAP_MAX);
+#endif
+
+	// R/C PWM inputs, counts to surface command
+#ifdef PWMIN_DTHR_CAL
+	CHECK_POLY(PWMIN_DTHR_CAL, 1.0, PWMIN_MIN_COUNT, PWMIN_MAX_COUNT);
+#endif
+#ifdef PWMIN_DE_CAL
+	CHECK_POLY(PWMIN_DE_CAL, PWMIN_SCALING, PWMIN_MIN_COUNT, PWMIN_MAX_COUNT);
+#endif
+#ifdef PWMIN_DR_CAL
+	CHECK_POLY(PWMIN_DR_CAL, PWMIN_SCALING, PWMIN_MIN_COUNT, PWMIN_MAX_COUNT);
+#endif
+#ifdef PWMIN_DA_L_CAL
+	CHECK_POLY(PWMIN_DA_L_CAL, PWMIN_SCALING, PWMIN_MIN_COUNT, PWMIN_MAX_COUNT);
+#endif
+#ifdef PWMIN_DA_R_CAL
+	CHECK_POLY(PWMIN_DA_R_CAL, PWMIN_SCALING, PWMIN_MIN_COUNT, PWMIN_MAX_COUNT);
+#endif
+#ifdef PWMIN_DF_L_CAL
+	CHECK_POLY(PWMIN_DF_L_CAL, PWMIN_SCALING, PWMIN_MIN_COUNT, PWMIN_MAX_COUNT);
+#endif
+#ifdef PWMIN_DF_R_CAL
+	CHECK_POLY(PWMIN_DF_R_CAL, PWMIN_SCALING, PWMIN_MIN_COUNT, PWMIN_MAX_COUNT);
+#endif
+
+	// Bench measured tables
+#ifdef PWMOUT_DTHR_TABLE
+	CHECK_POINTS(PWMOUT_DTHR_TABLE);
+#endif
+#ifdef PWMOUT_DE_TABLE
+	CHECK_POINTS(PWMOUT_DE_TABLE);
+#endif
+#ifdef PWMOUT_DR_TABLE
+	CHECK_POINTS(PWMOUT_DR_TABLE);
+#endif
+#ifdef PWMOUT_DA_L_TABLE
+	CHECK_POINTS(PWMOUT_DA_L_TABLE);
+#endif
+#ifdef PWMOUT_DA_R_TABLE
+	CHECK_POINTS(PWMOUT_DA_R_TABLE);
+#endif
+#ifdef PWMOUT_DF_L_TABLE
+	CHECK_POINTS(PWMOUT_DF_L_TABLE);
+#endif
+#ifdef PWMOUT_DF_R_TABLE
+	CHECK_POINTS(PWMOUT_DF_R_TABLE);
+#endif
+#ifdef PWMIN_DTHR_TABLE
+	CHECK_POINTS(PWMIN_DTHR_TABLE);
+#endif
+#ifdef PWMIN_DE_TABLE
+	CHECK_POINTS(PWMIN_DE_TABLE);
+#endif
+#ifdef PWMIN_DR_TABLE
+	CHECK_POINTS(PWMIN_DR_TABLE);
+#endif
+#ifdef PWMIN_DA_L_TABLE
+	CHECK_POINTS(PWMIN_DA_L_TABLE);
+#endif
+#ifdef PWMIN_DA_R_TABLE
+	CHECK_POINTS(PWMIN_DA_R_TABLE);
+#endif
+#ifdef PWMIN_DF_L_TABLE
+	CHECK_POINTS(PWMIN_DF_L_TABLE);
+#endif
+#ifdef PWMIN_DF_R_TABLE
+	CHECK_POINTS(PWMIN_DF_R_TABLE);
+#endif
+
+}
+
+/// 0 if the samples are strictly increasing or strictly decreasing, -1 otherwise.
+static int monotonic(const struct cal_table *t){
+	int i, up = (t->y[1] > t->y[0]);
+
+	for (i = 1; i < CAL_TABLE_SIZE; i++){
+		if (up ? !(t->y[i] > t->y[i-1]) : !(t->y[i] < t->y[i-1]))
+			return -1;
+	}
+	return 0;
+}
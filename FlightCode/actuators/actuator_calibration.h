@@ -0,0 +1,93 @@
+/*! \file actuator_calibration.h
+ *	\brief Actuator calibration lookup table interface header
+ *
+ *	\details Surface command to PWM output, and R/C PWM input to surface command, through lookup tables instead of
+ *	evaluating the calibration polynomials on every write and read. Each table holds CAL_TABLE_SIZE evenly spaced
+ *	samples, so a conversion with cal_lookup() is one index computation and one linear interpolation, with no search.
+ *
+ *	The PWM and R/C drivers of the flight computers are not part of this tree and still evaluate the polynomials:
+ *	until they build and look up these tables, this module has no effect on the flight. What it does now is check,
+ *	at startup, the calibrations in aircraft/XXX_config.h: PWMOUT_XX_CAL over the surface limits XX_MIN to XX_MAX,
+ *	and PWMIN_XX_CAL over PWMIN_MIN_COUNT to PWMIN_MAX_COUNT raw counts, applied to the reading divided by
+ *	PWMIN_SCALING for the surfaces and to the raw reading for the throttle, as the R/C input driver does.
+ *	A servo measured on the bench can also be given as a table of points:
+ *
+ *	\code
+ *	#define PWMOUT_DE_TABLE	{{-0.4363, 3120}, {-0.2, 3640}, {0.0, 4108}, {0.2, 4570}, {0.4363, 5010}}	// [rad], counts
+ *	#define PWMIN_DE_TABLE	{{2500, -0.4363}, {3000, 0.0}, {3600, 0.4363}}	// raw counts, [rad]
+ *	\endcode
+ *
+ *	with the first column increasing. A calibration that is not strictly monotonic over its range is reported with
+ *	a message.
+ *	\ingroup actuator_fcns
+ *
+ * \author University of Minnesota
+ * \author Aerospace Engineering and Mechanics
+ * \copyright Copyright 2015 Regents of the University of Minnesota. All rights reserved.
+ *
+ * $Id$
+ */
+
+#ifndef ACTUATOR_CALIBRATION_H_
+#define ACTUATOR_CALIBRATION_H_
+
+#define CAL_TABLE_SIZE	256		///< samples per table
+
+#ifndef PWMIN_MIN_COUNT
+	#define PWMIN_MIN_COUNT	2400	///< lowest raw R/C PWM reading covered by the input tables
+#endif
+#ifndef PWMIN_MAX_COUNT
+	#define PWMIN_MAX_COUNT	3800	///< highest raw R/C PWM reading covered by the input tables
+#endif
+
+/// Lookup table on evenly spaced breakpoints
+struct cal_table {
+	double x0;					///< first breakpoint
+	double inv_dx;				///< 1/breakpoint spacing
+	double y[CAL_TABLE_SIZE];	///< samples
+};
+
+/// Linear interpolation in a table, clamped to its ends.
+static inline double cal_lookup(const struct cal_table *t, double x){
+	double f = (x - t->x0)*t->inv_dx;
+	int i;
+
+	if (f <= 0.0)
+		return t->y[0];
+	if (f >= CAL_TABLE_SIZE-1)
+		return t->y[CAL_TABLE_SIZE-1];
+
+	i = (int)f;
+	return t->y[i] + (f - i)*(t->y[i+1] - t->y[i]);
+}
+
+/// Sample the polynomial c[0]*(x/scale)^(n-1) + ... + c[n-1] over [xmin, xmax].
+/*!
+ * \return 0 on success, -1 if the polynomial is not strictly monotonic over the range
+ * \ingroup actuator_fcns
+ */
+int cal_table_poly(struct cal_table *t,	///< pointer to table
+		const double *c,	///< coefficients, highest power first
+		int n,				///< number of coefficients
+		double scale,		///< divisor applied to x before evaluation
+		double xmin,		///< first breakpoint
+		double xmax			///< last breakpoint
+		);
+
+/// Resample measured points, linearly interpolated, over their range.
+/*!
+ * \return 0 on success, -1 if there are fewer than two points, x is not increasing or y is not strictly monotonic
+ * \ingroup actuator_fcns
+ */
+int cal_table_points(struct cal_table *t,	///< pointer to table
+		const double (*pts)[2],	///< points {x, y}
+		int n					///< number of points
+		);
+
+/// Check that the calibrations of the aircraft configuration are strictly monotonic, see the file description.
+/*!
+ * \ingroup actuator_fcns
+ */
+void check_actuator_calibration(void);
+
+#endif /* ACTUATOR_CALIBRATION_H_ */
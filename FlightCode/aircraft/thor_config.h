@@ -44,6 +44,20 @@
 #define R_FLAP_MAX	 	 0.4363	///< [rad], 25deg
 #define R_FLAP_MIN		-0.4363	///< [rad],-25deg
 
+// Gain schedule, see control/gain_schedule.h. Off by default: the gains of globaldefs.h are used at every airspeed.
+// Example only, not flight tested: the 17 m/s row holds the gains of globaldefs.h, the roll and pitch loop gains and
+// the pitch trim of the other rows are scaled with 1/dynamic pressure and the heading gain with airspeed. Each row:
+// roll, pitch, alt, v, head, base_pitch.
+/*
+#define SCHED_IAS_BP	{13.0, 17.0, 21.0, 25.0}	///< [m/s]
+#define SCHED_H_BP		{0.0}						///< [m]
+#define SCHED_GAINS		{ \
+	{{-1.0944, -0.3420, -0.1197}, {-1.5391, -0.5130, -0.1368}, {0.023, 0.0010}, {0.15, 0.040}, 1.147, 0.14923}, \
+	{{-0.6400, -0.2000, -0.0700}, {-0.9000, -0.3000, -0.0800}, {0.023, 0.0010}, {0.15, 0.040}, 1.500, 0.0872664}, \
+	{{-0.4194, -0.1311, -0.0459}, {-0.5898, -0.1966, -0.0524}, {0.023, 0.0010}, {0.15, 0.040}, 1.853, 0.05719}, \
+	{{-0.2959, -0.0925, -0.0324}, {-0.4162, -0.1387, -0.0370}, {0.023, 0.0010}, {0.15, 0.040}, 2.206, 0.04035}}
+*/
+
 // MPC5200 PWM output channel assignments
 #define PWMOUT_DTHR_CH  0 ///<  PWM output channel for throttle
 #define PWMOUT_DE_CH  	1 ///<  PWM output channel for elevator
@@ -18,6 +18,9 @@
 
 #include "../globaldefs.h"
 #include "control_interface.h"
+#include "control_allocation.h"
+#include "control_blocks.h"
+#include "gain_schedule.h"
 
 // ***********************************************************************************
 
@@ -26,57 +29,92 @@
 
 // ***********************************************************************************
 
-/// Definition of local functions: ****************************************************
-static double yaw_damper (double yawrate);
-static double roll_control (double phi_ref, double roll_angle, double rollrate, double delta_t);
-static double pitch_control(double the_ref, double pitch, double pitchrate, double delta_t);
+/// Instance context: the roll tracker and the theta tracker, PI with a damper on the body rate and clamping
+/// anti-windup, and the yaw damper
+struct baseline_control_state {
+	struct pid roll_pi;			///< roll tracker
+	struct pid pitch_pi;		///< theta tracker
+	struct biquad yaw_filter;	///< yaw damper
+	double roll_out;			///< roll tracker output before the roll damper, held over the frame
+	double pitch_out;			///< theta tracker output before the pitch damper, held over the frame
+	struct control_loops loops;	///< tracking loop signals of the last step, for the metrics
+	struct gain_set gains;		///< scheduled on airspeed and altitude every frame, see gain_schedule.h
+};
 
-// initialize pitch and roll angle tracking errors, integrators, and anti wind-up operators
-// 0 values correspond to the roll tracker, 1 values correspond to the theta tracker
-static double e[2] = {0,0};
-static double integrator[2] = {0,0};
-static short anti_windup[2]={1,1};   // integrates when anti_windup is 1
+/// Definition of local functions: ****************************************************
+static void get_baseline_control(void *state, double time, struct sensordata *sensorData_ptr, struct nav *navData_ptr, struct control *controlData_ptr);
+static void reset_baseline_control(void *state, struct control *controlData_ptr);
+static void inner_baseline_control(void *state, double delta_t, struct sensordata *sensorData_ptr, struct control *controlData_ptr);
+static void loops_baseline_control(const void *state, struct control_loops *loops_ptr);
+static double yaw_damper (struct baseline_control_state *s, double yawrate);
+static double roll_control (struct baseline_control_state *s, double phi_ref, double roll_angle, double delta_t);
+static double pitch_control(struct baseline_control_state *s, double the_ref, double pitch, double delta_t);
+
+/// Registration in the control law table, see control_laws.c
+const struct control_law baseline_control_law = {.name = "baseline_control", .state_size = sizeof(struct baseline_control_state),
+		.step = get_baseline_control, .reset = reset_baseline_control, .inner = inner_baseline_control, .loops = loops_baseline_control};
 
 /// ****************************************************************************************
-/// Yaw rate digital controller - parameters and variables
-
-//   y_yaw(z)      b[0] + b[1]*z^(-1)
-//   --------  =  --------------------
-//   u_yaw(z)      a[0] + a[1]*z^(-1)
-
-static const int k=1; 	//k = the order of the denominator of the Discrete Time Transfer
-				        //function. k is used for calculating current and past time step values
-static double u_yaw[2] = {0,0}; // input of filter { u(k), u(k-1) }
-static double y_yaw[2] = {0,0}; // output of filter { y(k), y(k-1) }
-static double a_yaw[2] = {1.0,-0.9608}; // Filter denominator coefficients
-static double b_yaw[2] = {0.065, -0.065}; // Filter numerator coefficients
-static double dr; // Delta rudder
-/// ****************************************************************************************
-static double da; // Delta aileron
-static double de; // Delta elevator
+/// Initial context: loop limits, with the gains set from the gain schedule every frame, and the yaw damper, a
+/// washout filter on the yaw rate, discretized at the inner loop rate on reset
+
+//   y_yaw(z)      b0 + b1*z^(-1)              k_YD*s
+//   --------  =  ----------------  =  c2d( ------------ , INNER_TIMESTEP )
+//   u_yaw(z)      1  + a1*z^(-1)            s + YD_WASHOUT
+
+#define YD_GAIN		0.065	// k_YD of Simulation/Controllers/baseline_gains.m
+#define YD_WASHOUT	2.0		// [rad/sec], -a_YD of Simulation/Controllers/baseline_gains.m
+
+static const struct baseline_control_state initial_state = {
+	.roll_pi = {.umin = -AILERON_AUTH_MAX, .umax = AILERON_AUTH_MAX},							// roll tracker
+	.pitch_pi = {.umin = -ELEVATOR_AUTH_MAX-ELEVATOR_TRIM, .umax = ELEVATOR_AUTH_MAX-ELEVATOR_TRIM},	// theta tracker
+};
 /// *****************************************************************************************
+
+/// Return control outputs based on references and feedback signals.
+static void get_baseline_control(void *state, double time, struct sensordata *sensorData_ptr, struct nav *navData_ptr, struct control *controlData_ptr) {
+	struct baseline_control_state *s = state;
 	double phi   = navData_ptr->phi;
-	double theta = navData_ptr->the - base_pitch_cmd; //subtract theta trim value to convert to delta coordinates
+	double theta;
+    double phi_cmd = controlData_ptr->phi_cmd;
+    double theta_cmd = controlData_ptr->theta_cmd;
+
+	get_gain_schedule(sensorData_ptr->adData_ptr->ias_filt, sensorData_ptr->adData_ptr->h_filt, &s->gains);
+	theta = navData_ptr->the - s->gains.base_pitch; //subtract theta trim value to convert to delta coordinates
+
+    s->pitch_out = pitch_control(s, theta_cmd, theta, TIMESTEP); // Elevator deflection before the pitch damper [rad]
+    s->roll_out = roll_control(s, phi_cmd, phi, TIMESTEP); 		// Roll, before the roll damper [rad]
+
+	// tracking loop signals, for the metrics
+	s->loops.ref[LOOP_ROLL]  = phi_cmd;
+	s->loops.e[LOOP_ROLL]    = phi_cmd - phi;
+	s->loops.ref[LOOP_PITCH] = theta_cmd;
+	s->loops.e[LOOP_PITCH]   = theta_cmd - theta;
+}
+
+/// Inner loop: the dampers on the body rates, at the time step delta_t, and the allocation to the surfaces.
+static void inner_baseline_control(void *state, double delta_t, struct sensordata *sensorData_ptr, struct control *controlData_ptr) {
+	struct baseline_control_state *s = state;
 	double p     = sensorData_ptr->imuData_ptr->p; // Roll rate
 	double q     = sensorData_ptr->imuData_ptr->q; // Pitch rate
 	double r     = sensorData_ptr->imuData_ptr->r; // Yaw rate
 
-    double phi_cmd = controlData_ptr->phi_cmd;
-    double theta_cmd = controlData_ptr->theta_cmd;
-
-    controlData_ptr->de = pitch_control(theta_cmd, theta, q, TIMESTEP); // Elevator deflection [rad]
-    controlData_ptr->dr = yaw_damper(r); 								// Rudder deflection [rad]
-    controlData_ptr->da_r = roll_control(phi_cmd, phi, p, TIMESTEP); 		// Right Aileron deflection [rad]
-	controlData_ptr->da_l = -controlData_ptr->da_r; 					// Left aileron deflection [rad]
+    controlData_ptr->de = pid_inner(&s->pitch_pi, s->pitch_out, q, delta_t);	// Elevator deflection [rad]
+    controlData_ptr->dr = yaw_damper(s, r); 								// Rudder deflection [rad]
+    controlData_ptr->da_r = pid_inner(&s->roll_pi, s->roll_out, p, delta_t);	// Roll, as right Aileron deflection [rad]
 	controlData_ptr->dthr = 0; // throttle
-	controlData_ptr->df_l = 0; // left flap
-	controlData_ptr->df_r = 0; // right flap
-	
-#if(defined(AIRCRAFT_BALDR) || defined(HIL_SIM))
-	controlData_ptr->df_l = controlData_ptr->de; // left flap = left elevator
-	controlData_ptr->df_r = controlData_ptr->dr; // right flap = top rudder
-#endif
 
+	allocate_controls(controlData_ptr);	// mix to all surfaces, see control_allocation.h
+}
+
+/// Tracking loops: the roll and theta trackers.
+static void loops_baseline_control(const void *state, struct control_loops *loops_ptr) {
+	const struct baseline_control_state *s = state;
+
+	*loops_ptr = s->loops;
+	loops_ptr->sat[LOOP_ROLL]  = s->roll_pi.hold;
+	loops_ptr->sat[LOOP_PITCH] = s->pitch_pi.hold;
+	loops_ptr->closed = (1 << LOOP_ROLL) | (1 << LOOP_PITCH);
 }
 
 
@@ -105,56 +143,19 @@ static double de; // Delta elevator
            |                                   ----------------      |
             ---------------------------------------------------------     */
 
-double yaw_damper (double yawrate)
+static double yaw_damper (struct baseline_control_state *s, double yawrate)
 {
-// Discrete time filter equation at time step k
-// y_yaw(k) = b0*u(k) + b1*u(k-1) - a1*y(k-1)
-    
-    
-	u_yaw[k] = yawrate;  //current time step input (r)
-
-	// Filter:
-	// y_yaw(k) = b0*u(k) 	+	   b1*u(k-1)   		 + - a1*y(k-1)
-	y_yaw[k] = b_yaw[0]*u_yaw[k] + b_yaw[1]*u_yaw[k-1] - a_yaw[1]*y_yaw[k-1];
-
-	// Update past time step input/output for next frame
-	u_yaw[k-1] = u_yaw[k];
-	y_yaw[k-1] = y_yaw[k];
-
-
-    //Output rudder command
-    dr = y_yaw[k];
-
-
-    // Saturation
-	if (fabs(dr) > RUDDER_AUTH_MAX) {
-		dr = sign(dr)*RUDDER_AUTH_MAX;		// yawdamper authority limited to +/-25 deg
-	}
-	return dr;
+	// rudder from the washed out yaw rate, authority limited to +/-25 deg
+	return saturate(biquad_step(&s->yaw_filter, yawrate), -RUDDER_AUTH_MAX, RUDDER_AUTH_MAX);
 }
 
 
 
-static double roll_control (double phi_ref, double roll_angle, double rollrate, double delta_t)
+static double roll_control (struct baseline_control_state *s, double phi_ref, double roll_angle, double delta_t)
 {
-	// ROLL tracking controller implemented here
-
-
-	// roll attitude tracker
-	e[0] = phi_ref - roll_angle;
-	integrator[0] += e[0]*delta_t*anti_windup[0]; //roll error integral (rad)
-
-	    //proportional term + integral term              - roll damper term
-	da  = roll_gain[0]*e[0] + roll_gain[1]*integrator[0] - roll_gain[2]*rollrate;
-
-	//eliminate windup
-	if      (da >= AILERON_AUTH_MAX && e[0] > 0) {anti_windup[0] = 1; da = AILERON_AUTH_MAX;}
-	else if (da >= AILERON_AUTH_MAX && e[0] < 0) {anti_windup[0] = 0; da = AILERON_AUTH_MAX;}  //stop integrating
-	else if (da <= -AILERON_AUTH_MAX && e[0] > 0) {anti_windup[0] = 0; da = -AILERON_AUTH_MAX;}  //stop integrating
-	else if (da <= -AILERON_AUTH_MAX && e[0] < 0) {anti_windup[0] = 1; da = -AILERON_AUTH_MAX;}
-	else {anti_windup[0] = 1;}
-
-    return da;
+	// roll attitude tracker: proportional term + integral term, the roll damper term is subtracted in the inner loop
+	pid_gains(&s->roll_pi, s->gains.roll[0], s->gains.roll[1], s->gains.roll[2]);
+	return pid_outer(&s->roll_pi, phi_ref - roll_angle, delta_t);
 }
 
 
@@ -165,7 +166,6 @@ static double roll_control (double phi_ref, double roll_angle, double rollrate,
 
 
 
-
 // Pitch get_control law: angles in radians. Rates in rad/s. Time in seconds
 /*                                                  __________
                    _______________                 |          |  theta
@@ -178,37 +178,23 @@ theta_cmd  _      |               |       _   de   |          |---------
            |                               -------| Pitch Damper |<-    |
            |                                      |______________|      |
             ------------------------------------------------------------     */
-static double pitch_control(double the_ref, double pitch, double pitchrate, double delta_t)
+static double pitch_control(struct baseline_control_state *s, double the_ref, double pitch, double delta_t)
 {
-	// pitch attitude tracker
-	e[1] = the_ref - pitch;
-	integrator[1] += e[1]*delta_t*anti_windup[1]; //pitch error integral
-
-       // proportional term + integral term               - pitch damper term
-    de = pitch_gain[0]*e[1] + pitch_gain[1]*integrator[1] - pitch_gain[2]*pitchrate;    // Elevator output
-
-	//eliminate wind-up
-	if      (de >= ELEVATOR_AUTH_MAX-ELEVATOR_TRIM && e[1] < 0) {anti_windup[1] = 0; de = ELEVATOR_AUTH_MAX-ELEVATOR_TRIM;}  //stop integrating
-	else if (de >= ELEVATOR_AUTH_MAX-ELEVATOR_TRIM && e[1] > 0) {anti_windup[1] = 1; de = ELEVATOR_AUTH_MAX-ELEVATOR_TRIM;}
-	else if (de <= -ELEVATOR_AUTH_MAX-ELEVATOR_TRIM && e[1] < 0) {anti_windup[1] = 1; de = -ELEVATOR_AUTH_MAX-ELEVATOR_TRIM;}
-	else if (de <= -ELEVATOR_AUTH_MAX-ELEVATOR_TRIM && e[1] > 0) {anti_windup[1] = 0; de = -ELEVATOR_AUTH_MAX-ELEVATOR_TRIM;}  //stop integrating
-	else {anti_windup[1] = 1;}
-
-	return de;  //rad
+	// pitch attitude tracker: proportional term + integral term, the pitch damper term is subtracted in the inner loop
+	pid_gains(&s->pitch_pi, s->gains.pitch[0], s->gains.pitch[1], s->gains.pitch[2]);
+	return pid_outer(&s->pitch_pi, the_ref - pitch, delta_t);  //rad
 }
 
 
 
 
 
-
 // Reset parameters to initial values
-extern void reset_control(struct control *controlData_ptr){
+static void reset_baseline_control(void *state, struct control *controlData_ptr){
+	struct baseline_control_state *s = state;
 
-	integrator[0] = integrator[1] = 0;
-	anti_windup[0] = anti_windup[1] = 1;
-	e[0] = e[1] = 0;
-	u_yaw[0] = u_yaw[1] = y_yaw[0] = y_yaw[1] = 0;
+	*s = initial_state;
+	biquad_washout(&s->yaw_filter, YD_GAIN, YD_WASHOUT, INNER_TIMESTEP);
 
 	controlData_ptr->dthr = 0; // throttle
 	controlData_ptr->de   = 0; // elevator
@@ -0,0 +1,218 @@
+/*! \file control_allocation.c
+ *	\brief Control allocation source code
+ *
+ *	\details Weighted least squares allocation of the virtual commands to the surfaces, with redistribution of
+ *	saturated and failed surfaces, see control_allocation.h.
+ *	\ingroup control_fcns
+ *
+ * \author University of Minnesota
+ * \author Aerospace Engineering and Mechanics
+ * \copyright Copyright 2015 Regents of the University of Minnesota. All rights reserved.
+ *
+ * $Id$
+ */
+
+#include "../globaldefs.h"
+#include AIRCRAFT_UP1DIR
+#include "control_interface.h"
+#include "control_allocation.h"
+
+// Default effectiveness: rows roll, pitch, yaw, thrust; columns dthr, de, dr, da_l, da_r, df_l, df_r
+#ifndef ALLOC_EFFECTIVENESS
+	#if(defined(AIRCRAFT_BALDR) || defined(HIL_SIM))
+		// left flap = left elevator, right flap = top rudder
+		#define ALLOC_EFFECTIVENESS	{ \
+			{0.0, 0.0, 0.0, -0.5, 0.5, 0.0, 0.0}, \
+			{0.0, 0.5, 0.0,  0.0, 0.0, 0.5, 0.0}, \
+			{0.0, 0.0, 0.5,  0.0, 0.0, 0.0, 0.5}, \
+			{1.0, 0.0, 0.0,  0.0, 0.0, 0.0, 0.0}}
+	#else
+		#define ALLOC_EFFECTIVENESS	{ \
+			{0.0, 0.0, 0.0, -0.5, 0.5, 0.0, 0.0}, \
+			{0.0, 1.0, 0.0,  0.0, 0.0, 0.0, 0.0}, \
+			{0.0, 0.0, 1.0,  0.0, 0.0, 0.0, 0.0}, \
+			{1.0, 0.0, 0.0,  0.0, 0.0, 0.0, 0.0}}
+	#endif
+#endif
+
+#ifndef ALLOC_WEIGHTS
+	#define ALLOC_WEIGHTS	{1.0, 1.0, 1.0, 1.0, 1.0, 1.0, 1.0}	///< cost of a unit deflection of each surface
+#endif
+
+// Default limits, relative to trim: the output limits of the control laws
+#ifndef ALLOC_MIN
+	#define ALLOC_MIN	{THROTTLE_AUTH_MIN-THROTTLE_TRIM, -ELEVATOR_AUTH_MAX-ELEVATOR_TRIM, -RUDDER_AUTH_MAX, \
+		-AILERON_AUTH_MAX, -AILERON_AUTH_MAX, -ELEVATOR_AUTH_MAX-ELEVATOR_TRIM, -RUDDER_AUTH_MAX}
+#endif
+#ifndef ALLOC_MAX
+	#define ALLOC_MAX	{THROTTLE_AUTH_MAX-THROTTLE_TRIM, ELEVATOR_AUTH_MAX-ELEVATOR_TRIM, RUDDER_AUTH_MAX, \
+		AILERON_AUTH_MAX, AILERON_AUTH_MAX, ELEVATOR_AUTH_MAX-ELEVATOR_TRIM, RUDDER_AUTH_MAX}
+#endif
+
+#define ALLOC_ALL	((1 << ALLOC_NS) - 1)	// mask of all surfaces
+#define ALLOC_TOL	1e-9					// pivot below which a virtual command is out of reach of the free surfaces
+
+// local functions
+static void pseudo_inverse(int mask, double P[ALLOC_NS][ALLOC_NV]);
+
+static const double B[ALLOC_NV][ALLOC_NS] = ALLOC_EFFECTIVENESS;
+static const double weight[ALLOC_NS] = ALLOC_WEIGHTS;
+static const double umin[ALLOC_NS] = ALLOC_MIN;
+static const double umax[ALLOC_NS] = ALLOC_MAX;
+
+static double pinv[ALLOC_ALL+1][ALLOC_NS][ALLOC_NV];	// weighted pseudo-inverse of each subset of free surfaces
+static double stuck[ALLOC_NS];							// positions of the failed surfaces
+static int failed;										// mask of the failed surfaces
+static short ready;
+
+void init_control_allocation(void){
+	int mask;
+
+	for (mask = 0; mask <= ALLOC_ALL; mask++)
+		pseudo_inverse(mask, pinv[mask]);
+
+	failed = 0;
+	ready = 1;
+}
+
+void allocate_controls(struct control *controlData_ptr){
+	double v[ALLOC_NV], vr[ALLOC_NV], u[ALLOC_NS];
+	int fixed, free, i, j, iter;
+	short sat;
+
+	if (!ready)
+		init_control_allocation();
+
+	v[ALLOC_ROLL]   = controlData_ptr->da_r;
+	v[ALLOC_PITCH]  = controlData_ptr->de;
+	v[ALLOC_YAW]    = controlData_ptr->dr;
+	v[ALLOC_THRUST] = controlData_ptr->dthr;
+
+	fixed = failed;
+	for (j = 0; j < ALLOC_NS; j++)
+		u[j] = stuck[j];
+
+	// cascaded generalized inverse: clamp the surfaces over their limits and redistribute over the rest
+	for (iter = 0; iter < ALLOC_NS; iter++){
+		free = ALLOC_ALL & ~fixed;
+
+		// virtual commands left to the free surfaces
+		for (i = 0; i < ALLOC_NV; i++){
+			vr[i] = v[i];
+			for (j = 0; j < ALLOC_NS; j++){
+				if (fixed & (1 << j))
+					vr[i] -= B[i][j]*u[j];
+			}
+		}
+
+		sat = 0;
+		for (j = 0; j < ALLOC_NS; j++){
+			if (!(free & (1 << j)))
+				continue;
+			u[j] = 0.0;
+			for (i = 0; i < ALLOC_NV; i++)
+				u[j] += pinv[free][j][i]*vr[i];
+
+			if (u[j] > umax[j]){
+				u[j] = umax[j];
+				fixed |= 1 << j;
+				sat = 1;
+			}
+			else if (u[j] < umin[j]){
+				u[j] = umin[j];
+				fixed |= 1 << j;
+				sat = 1;
+			}
+		}
+		if (!sat)
+			break;
+	}
+
+	controlData_ptr->dthr = u[ALLOC_DTHR];	// throttle
+	controlData_ptr->de   = u[ALLOC_DE];	// elevator
+	controlData_ptr->dr   = u[ALLOC_DR];	// rudder
+	controlData_ptr->da_l = u[ALLOC_DA_L];	// left aileron
+	controlData_ptr->da_r = u[ALLOC_DA_R];	// right aileron
+	controlData_ptr->df_l = u[ALLOC_DF_L];	// left flap
+	controlData_ptr->df_r = u[ALLOC_DF_R];	// right flap
+}
+
+void set_surface_failure(int surface, double position){
+	if (surface < 0 || surface >= ALLOC_NS)
+		return;
+	stuck[surface] = position;
+	failed |= 1 << surface;
+}
+
+void clear_surface_failure(int surface){
+	if (surface < 0 || surface >= ALLOC_NS)
+		return;
+	stuck[surface] = 0.0;
+	failed &= ~(1 << surface);
+}
+
+/// P = W^-1*Bm'*(Bm*W^-1*Bm')^-1 for the columns of B in mask. The normal matrix is factored as L*D*L'; a virtual
+/// command the free surfaces cannot reach gives a zero pivot and is dropped, so P never blows up.
+static void pseudo_inverse(int mask, double P[ALLOC_NS][ALLOC_NV]){
+	double BW[ALLOC_NV][ALLOC_NS], M[ALLOC_NV][ALLOC_NV], L[ALLOC_NV][ALLOC_NV], d[ALLOC_NV];
+	double Minv[ALLOC_NV][ALLOC_NV], y[ALLOC_NV];
+	int i, j, k, c;
+
+	// B*W^-1 restricted to the free surfaces, and the normal matrix
+	for (i = 0; i < ALLOC_NV; i++){
+		for (j = 0; j < ALLOC_NS; j++)
+			BW[i][j] = (mask & (1 << j)) ? B[i][j]/weight[j] : 0.0;
+	}
+	for (i = 0; i < ALLOC_NV; i++){
+		for (k = 0; k < ALLOC_NV; k++){
+			M[i][k] = 0.0;
+			for (j = 0; j < ALLOC_NS; j++)
+				M[i][k] += BW[i][j]*((mask & (1 << j)) ? B[k][j] : 0.0);
+		}
+	}
+
+	// L*D*L' factorization
+	for (j = 0; j < ALLOC_NV; j++){
+		d[j] = M[j][j];
+		for (k = 0; k < j; k++)
+			d[j] -= L[j][k]*L[j][k]*d[k];
+		if (d[j] < ALLOC_TOL)
+			d[j] = 0.0;
+
+		L[j][j] = 1.0;
+		for (i = j+1; i < ALLOC_NV; i++){
+			L[i][j] = 0.0;
+			if (d[j] == 0.0)
+				continue;
+			L[i][j] = M[i][j];
+			for (k = 0; k < j; k++)
+				L[i][j] -= L[i][k]*L[j][k]*d[k];
+			L[i][j] /= d[j];
+		}
+	}
+
+	// inverse, one column at a time
+	for (c = 0; c < ALLOC_NV; c++){
+		for (i = 0; i < ALLOC_NV; i++){
+			y[i] = (i == c) ? 1.0 : 0.0;
+			for (k = 0; k < i; k++)
+				y[i] -= L[i][k]*y[k];
+		}
+		for (i = 0; i < ALLOC_NV; i++)
+			y[i] = (d[i] == 0.0) ? 0.0 : y[i]/d[i];
+		for (i = ALLOC_NV-1; i >= 0; i--){
+			for (k = i+1; k < ALLOC_NV; k++)
+				y[i] -= L[k][i]*y[k];
+		}
+		for (i = 0; i < ALLOC_NV; i++)
+			Minv[i][c] = y[i];
+	}
+
+	for (j = 0; j < ALLOC_NS; j++){
+		for (c = 0; c < ALLOC_NV; c++){
+			P[j][c] = 0.0;
+			for (i = 0; i < ALLOC_NV; i++)
+				P[j][c] += BW[i][j]*Minv[i][c];
+		}
+	}
+}
@@ -0,0 +1,71 @@
+/*! \file control_allocation.h
+ *	\brief Control allocation interface header
+ *
+ *	\details Maps the virtual commands of a control law, roll, pitch, yaw and thrust, to all surfaces of the aircraft.
+ *	A law writes its virtual commands in the surface fields it always used: da_r for roll, as a right aileron
+ *	equivalent deflection, de for pitch, dr for yaw and dthr for thrust, then calls allocate_controls(), which
+ *	overwrites all seven surface commands.
+ *
+ *	The effectiveness matrix B gives the virtual command produced by a unit deflection of each surface, v = B*u, and
+ *	is set per aircraft in aircraft/XXX_config.h with ALLOC_EFFECTIVENESS, one row per virtual command, one column per
+ *	surface in the order of enum alloc_surface. The default splits roll evenly over the ailerons, and on Baldr pitch
+ *	and yaw over the split elevator and rudder, so it reproduces the surface mixing the laws used to do themselves.
+ *	The surface commands are the weighted least squares solution u = W^-1*B'*(B*W^-1*B')^-1*v, with W the diagonal
+ *	of ALLOC_WEIGHTS.
+ *
+ *	A surface that would exceed its limit is clamped and the virtual command it no longer provides is redistributed
+ *	over the free surfaces, repeating until all are within limits. A failed surface is held at its stuck position and
+ *	treated the same way. The weighted pseudo-inverse of every subset of free surfaces is computed when the
+ *	allocation is initialized, so clamping and reconfiguration after a surface failure select a precomputed matrix
+ *	instead of solving one in the frame.
+ *	\ingroup control_fcns
+ *
+ * \author University of Minnesota
+ * \author Aerospace Engineering and Mechanics
+ * \copyright Copyright 2015 Regents of the University of Minnesota. All rights reserved.
+ *
+ * $Id$
+ */
+
+#ifndef CONTROL_ALLOCATION_H_
+#define CONTROL_ALLOCATION_H_
+
+/// Virtual commands
+enum alloc_virtual {ALLOC_ROLL, ALLOC_PITCH, ALLOC_YAW, ALLOC_THRUST, ALLOC_NV};
+
+/// Surfaces, in the order of the surface commands of struct control
+enum alloc_surface {ALLOC_DTHR, ALLOC_DE, ALLOC_DR, ALLOC_DA_L, ALLOC_DA_R, ALLOC_DF_L, ALLOC_DF_R, ALLOC_NS};
+
+/// Load the effectiveness matrix, weights and limits of the aircraft configuration and precompute the pseudo-inverses.
+/// Clears all surface failures. Called by allocate_controls() if not called before.
+/*!
+ * \ingroup control_fcns
+ */
+void init_control_allocation(void);
+
+/// Map the virtual commands in controlData to all surface commands.
+/*!
+ * \sa init_control_allocation()
+ * \ingroup control_fcns
+ */
+void allocate_controls(struct control *controlData_ptr	///< pointer to controlData structure
+		);
+
+/// Mark a surface failed, stuck at a known position, and redistribute its share over the others from the next frame.
+/*!
+ * \sa clear_surface_failure()
+ * \ingroup control_fcns
+ */
+void set_surface_failure(int surface,	///< surface, enum alloc_surface
+		double position		///< [rad], or [ND] for the throttle, stuck position relative to trim
+		);
+
+/// Return a failed surface to the allocation.
+/*!
+ * \sa set_surface_failure()
+ * \ingroup control_fcns
+ */
+void clear_surface_failure(int surface	///< surface, enum alloc_surface
+		);
+
+#endif /* CONTROL_ALLOCATION_H_ */
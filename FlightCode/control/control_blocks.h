@@ -0,0 +1,187 @@
+/*! \file control_blocks.h
+ *	\brief Discrete time control blocks
+ *
+ *	\details Fixed size blocks the control laws are composed from: biquads in direct form II transposed and
+ *	cascades of them, PI/PID loops with clamping or back-calculation anti-windup, rate limiters and saturations.
+ *	Each block is a struct holding its coefficients and state, stepped by a static inline function, so a law pays
+ *	no call overhead and allocates nothing. Direct form II transposed keeps two states per section and has good
+ *	round-off behavior for the lightly damped, low cutoff filters used at 50 Hz. A PI loop with a rate damper can
+ *	be split between the rate groups, the tracker at the outer loop rate and the damper at the inner loop rate.
+ *	\ingroup control_fcns
+ *
+ * \author University of Minnesota
+ * \author Aerospace Engineering and Mechanics
+ * \copyright Copyright 2015 Regents of the University of Minnesota. All rights reserved.
+ *
+ * $Id$
+ */
+
+#ifndef CONTROL_BLOCKS_H_
+#define CONTROL_BLOCKS_H_
+
+#include <math.h>
+
+#define SOS_MAX_SECTIONS	4	///< capacity of a second order section cascade
+
+/// Biquad, y(z)/u(z) = (b0 + b1 z^-1 + b2 z^-2)/(1 + a1 z^-1 + a2 z^-2). A first order filter has b2 = a2 = 0.
+struct biquad {
+	double b0, b1, b2;	///< numerator coefficients
+	double a1, a2;		///< denominator coefficients, a0 normalized to 1
+	double z1, z2;		///< states
+};
+
+/// Cascade of second order sections
+struct sos {
+	struct biquad sec[SOS_MAX_SECTIONS];	///< sections in order
+	int n;									///< number of sections
+};
+
+/// PI loop with a rate damper, u = kp*e + ki*integral(e) - kd*rate; a PID when rate is the error rate.
+struct pid {
+	double kp, ki, kd;	///< proportional, integral and damping gains
+	double umin, umax;	///< limits of the output the integrator drives, for the anti-windup
+	double kaw;			///< [1/sec], back-calculation gain, 0 for clamping (conditional integration)
+	double integ;		///< error integral
+	short hold;			///< 1 while clamping holds the integrator
+	double e;			///< error of the last outer step, for the anti-windup of the inner steps
+};
+
+/// Rate limiter
+struct rate_limiter {
+	double rmax;		///< rate limit, per second
+	double y;			///< output
+	short init;			///< 0 until the first input, which is passed through
+};
+
+/// Limit x to [lo, hi].
+static inline double saturate(double x, double lo, double hi){
+	return (x > hi) ? hi : ((x < lo) ? lo : x);
+}
+
+/// Set the coefficients of a biquad from b[3] and a[3], normalizing by a[0], and clear its states.
+static inline void biquad_set(struct biquad *f, const double *b, const double *a){
+	f->b0 = b[0]/a[0];
+	f->b1 = b[1]/a[0];
+	f->b2 = b[2]/a[0];
+	f->a1 = a[1]/a[0];
+	f->a2 = a[2]/a[0];
+	f->z1 = f->z2 = 0.0;
+}
+
+/// Set a biquad to the washout k*s/(s + wc), discretized with a zero order hold at time step dt as c2d() does, and
+/// clear its states. Called again for each rate the filter runs at.
+static inline void biquad_washout(struct biquad *f, double k, double wc, double dt){
+	f->b0 = k;
+	f->b1 = -k;
+	f->b2 = 0.0;
+	f->a1 = -exp(-wc*dt);
+	f->a2 = 0.0;
+	f->z1 = f->z2 = 0.0;
+}
+
+/// Clear the states of a biquad.
+static inline void biquad_reset(struct biquad *f){
+	f->z1 = f->z2 = 0.0;
+}
+
+/// One step of a biquad.
+static inline double biquad_step(struct biquad *f, double u){
+	double y = f->b0*u + f->z1;
+
+	f->z1 = f->b1*u - f->a1*y + f->z2;
+	f->z2 = f->b2*u - f->a2*y;
+	return y;
+}
+
+/// Clear the states of a cascade.
+static inline void sos_reset(struct sos *f){
+	int i;
+
+	for (i = 0; i < f->n; i++)
+		biquad_reset(&f->sec[i]);
+}
+
+/// One step of a cascade.
+static inline double sos_step(struct sos *f, double u){
+	int i;
+
+	for (i = 0; i < f->n; i++)
+		u = biquad_step(&f->sec[i], u);
+	return u;
+}
+
+/// Set the gains of a PI/PID loop, keeping its integrator; the laws call this every frame so scheduled gains apply.
+static inline void pid_gains(struct pid *c, double kp, double ki, double kd){
+	c->kp = kp;
+	c->ki = ki;
+	c->kd = kd;
+}
+
+/// Clear the integrator of a PI/PID loop.
+static inline void pid_reset(struct pid *c){
+	c->integ = 0.0;
+	c->hold = 0;
+}
+
+/// Integrate the error, unless clamping holds the integrator, and return the unlimited output.
+/*!
+ * Use with pid_antiwindup() when the integrator drives a limit further down a cascade; otherwise use pid_step().
+ */
+static inline double pid_output(struct pid *c, double e, double rate, double dt){
+	if (!c->hold)
+		c->integ += e*dt;
+	return c->kp*e + c->ki*c->integ - c->kd*rate;
+}
+
+/// Anti-windup against the limits [umin, umax], given the unlimited output u the integrator drives.
+/*!
+ * Clamping holds the integrator for the next step while u is at a limit and the error would drive it further
+ * past; back-calculation bleeds the integrator by kaw times the excess instead.
+ * \return u limited to [umin, umax]
+ */
+static inline double pid_antiwindup(struct pid *c, double e, double u, double dt){
+	double us = saturate(u, c->umin, c->umax);
+
+	if (c->kaw > 0.0 && c->ki != 0.0)
+		c->integ += c->kaw*(us - u)/c->ki*dt;
+	else
+		c->hold = (u >= c->umax && c->ki*e > 0.0) || (u <= c->umin && c->ki*e < 0.0);
+	return us;
+}
+
+/// One step of a PI/PID loop limited to [umin, umax].
+static inline double pid_step(struct pid *c, double e, double rate, double dt){
+	return pid_antiwindup(c, e, pid_output(c, e, rate, dt), dt);
+}
+
+/// Outer rate part of a PI loop with a rate damper: integrate the error and return kp*e + ki*integral(e).
+/*!
+ * The damper term and the limits are applied by pid_inner() at the inner loop rate, on the latest body rate.
+ */
+static inline double pid_outer(struct pid *c, double e, double dt){
+	c->e = e;
+	if (!c->hold)
+		c->integ += e*dt;
+	return c->kp*e + c->ki*c->integ;
+}
+
+/// Inner rate part of a PI loop with a rate damper: subtract kd*rate from the outer output u and limit it.
+/*!
+ * \return u - kd*rate limited to [umin, umax], with the anti-windup against the error of the last outer step
+ */
+static inline double pid_inner(struct pid *c, double u, double rate, double dt){
+	return pid_antiwindup(c, c->e, u - c->kd*rate, dt);
+}
+
+/// One step of a rate limiter.
+static inline double rate_limiter_step(struct rate_limiter *f, double u, double dt){
+	if (!f->init){
+		f->init = 1;
+		f->y = u;
+	}
+	else
+		f->y += saturate(u - f->y, -f->rmax*dt, f->rmax*dt);
+	return f->y;
+}
+
+#endif /* CONTROL_BLOCKS_H_ */
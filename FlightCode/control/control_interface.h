@@ -14,8 +14,120 @@
 #ifndef CONTROL_INTERFACE_H_
 #define CONTROL_INTERFACE_H_
 
+#include <stddef.h>
+
+/// Tracking loops a control law can close, for the onboard metrics of control_metrics.h
+enum control_loop {LOOP_ROLL, LOOP_PITCH, LOOP_HEADING, LOOP_ALTITUDE, LOOP_SPEED, LOOP_N};
+
+/// Tracking loop signals reported by a control law
+struct control_loops {
+	double ref[LOOP_N];		///< reference of each loop: [rad], [rad], [rad], [m], [m/sec]
+	double e[LOOP_N];		///< tracking error of each loop, reference - feedback, same units
+	short sat[LOOP_N];		///< 1 while the anti-windup of the loop holds its integrator at a limit
+	int closed;				///< mask of the loops the law closes, bit 1 << loop
+};
+
+/// Control law, registered in the law table of control_laws.c.
+/*!
+ * A law keeps all of its internal states in an instance context of state_size bytes, passed to step and reset, so
+ * several instances of one or more laws can run side by side. The active law is selected by name with CONTROL_LAW
+ * and an optional shadow law with CONTROL_SHADOW_LAW, both set in aircraft/XXX_config.h or on the compiler command line.
+ *
+ * A law runs in two rate groups. The step runs once per frame, at TIMESTEP: the attitude trackers and the outer
+ * guidance loops. The inner step runs INNER_LOOP_STEPS times per frame, at INNER_TIMESTEP, the first time right after
+ * the step: the rate dampers on the IMU body rates and the allocation to the surfaces. A law without an inner step
+ * sets the surfaces in its step and runs entirely at the frame rate.
+ * \ingroup control_fcns
+ */
+struct control_law {
+	const char *name;		///< name the law is selected by
+	size_t state_size;		///< [bytes], size of an instance context
+	/// one step of the law, same arguments as get_control() after the context
+	void (*step)(void *state, double time, struct sensordata *sensorData_ptr, struct nav *navData_ptr,
+			struct control *controlData_ptr);
+	/// reset of the law, same arguments as reset_control() after the context
+	void (*reset)(void *state, struct control *controlData_ptr);
+	/// one inner step of the law, at the time step delta_t, NULL for a law run entirely at the frame rate
+	void (*inner)(void *state, double delta_t, struct sensordata *sensorData_ptr, struct control *controlData_ptr);
+	/// tracking loop signals of the last step, NULL for a law without tracking loops
+	void (*loops)(const void *state, struct control_loops *loops_ptr);
+	/// 1 if the law takes psi_cmd as the heading error to the course on gndtrk_cmd, the convention of the waypoint
+	/// guidance laws, 0 if psi_cmd is a heading or the law tracks no heading
+	int psi_error;
+};
+
+/// Instance of a control law
+struct control_instance {
+	const struct control_law *law;	///< law, NULL if the instance is not in use
+	void *state;					///< instance context
+};
+
+/// Look up a registered control law by name.
+/*!
+ * \return pointer to the law, NULL if no law of that name is registered
+ * \ingroup control_fcns
+ */
+extern const struct control_law *find_control_law(const char *name	///< law name
+);
+
+/// Create an instance of a registered control law, with its context allocated and reset.
+/*!
+ * \return 0 on success, -1 if the law is not registered or its context could not be allocated
+ * \sa step_control_instance(), close_control_instance()
+ * \ingroup control_fcns
+ */
+extern int init_control_instance(struct control_instance *inst,	///< pointer to the instance
+		const char *name,					///< law name
+		struct control *controlData_ptr		///< pointer to controlData structure, reset with the law
+);
+
+/// One step of a control law instance, followed by its first inner step. Does nothing if the instance is not in use.
+/*!
+ * \ingroup control_fcns
+ */
+extern void step_control_instance(struct control_instance *inst,	///< pointer to the instance
+		double time, 						///< [sec], time since in autopilot mode
+		struct sensordata *sensorData_ptr,	///< pointer to sensorData structure
+		struct nav *navData_ptr,			///< pointer to navData structure
+		struct control *controlData_ptr		///< pointer to controlData structure
+);
+
+/// One inner step of a control law instance. Does nothing if the instance is not in use or its law has no inner step.
+/*!
+ * \ingroup control_fcns
+ */
+extern void step_inner_control_instance(struct control_instance *inst,	///< pointer to the instance
+		struct sensordata *sensorData_ptr,	///< pointer to sensorData structure
+		struct control *controlData_ptr		///< pointer to controlData structure
+);
+
+/// Reset a control law instance. Does nothing if the instance is not in use.
+/*!
+ * \ingroup control_fcns
+ */
+extern void reset_control_instance(struct control_instance *inst,	///< pointer to the instance
+		struct control *controlData_ptr		///< pointer to controlData structure
+);
+
+/// Free the context of a control law instance and mark it not in use.
+/*!
+ * \ingroup control_fcns
+ */
+extern void close_control_instance(struct control_instance *inst	///< pointer to the instance
+);
+
+/// Create the active control law instance, and the shadow instance if CONTROL_SHADOW_LAW is set.
+/*!
+ * Called by get_control() or reset_control() if not called before.
+ * \return 0 on success, -1 if the active law is not registered
+ * \ingroup control_fcns
+ */
+extern int init_control(struct control *controlData_ptr	///< pointer to controlData structure
+);
+
 /// Standard function to call the control law
 /*!
+ * Steps the active control law instance.
  * \sa reset_control()
  * \ingroup control_fcns
  */
@@ -25,14 +137,82 @@ extern void get_control(double time, 			///< [sec], time since in autopilot mode
 		struct control *controlData_ptr		///< pointer to controlData structure
 );
 
+/// Inner step of the active control law, between frames
+/*!
+ * Call INNER_LOOP_STEPS-1 times per frame after get_control(), each time with fresh IMU body rates, and set the
+ * actuators after each call. The offsets added to the law outputs since get_control(), the trim biases, system ID
+ * excitation and surface faults, are held over the frame. Does nothing for a law without an inner step.
+ * \sa get_control()
+ * \ingroup control_fcns
+ */
+extern void get_inner_control(struct sensordata *sensorData_ptr,	///< pointer to sensorData structure
+		struct control *controlData_ptr		///< pointer to controlData structure
+);
+
+/// Tracking loop signals of the active control law, after get_control()
+/*!
+ * \return 0 on success, -1 if the active law reports no tracking loops; loops_ptr->closed is 0 then
+ * \ingroup control_fcns
+ */
+extern int get_control_loops(struct control_loops *loops_ptr	///< pointer to loop signals structure
+);
+
+/// Heading command convention of the active control law, see struct control_law.
+/*!
+ * \return 1 if the active law takes psi_cmd as a heading error, 0 otherwise or without an active law
+ * \ingroup control_fcns
+ */
+extern int get_control_psi_error(void);
+
+/// Whether a shadow control law runs, see CONTROL_SHADOW_LAW.
+/*!
+ * \return 1 once init_control() has created the shadow instance, 0 otherwise
+ * \ingroup control_fcns
+ */
+extern int get_control_shadow(void);
+
 /// Standard function to reset internal states of the control law
 /*!
+ * Resets the active control law instance.
  * \sa get_control()
  * \ingroup control_fcns
  */
 extern void reset_control(struct control * controlData_ptr	///< pointer to controlData structure
 );
 
+/// Step the shadow control law on its own copy of the control data, for comparison with the active law.
+/*!
+ * Call after the actuators are set, with shadowData_ptr holding the commands the active law was given this frame;
+ * the shadow outputs are written there and never reach the actuators. Runs the outer loops and the first inner
+ * step, as get_control() does. Does nothing without a shadow law.
+ * \sa get_shadow_inner_control(), reset_shadow_control()
+ * \ingroup control_fcns
+ */
+extern void get_shadow_control(double time, 	///< [sec], time since in autopilot mode
+		struct sensordata *sensorData_ptr,	///< pointer to sensorData structure
+		struct nav *navData_ptr,			///< pointer to navData structure
+		struct control *shadowData_ptr		///< pointer to the shadow copy of the controlData structure
+);
+
+/// One further inner step of the shadow control law.
+/*!
+ * Call INNER_LOOP_STEPS-1 times per frame after get_shadow_control(), next to get_inner_control(), so the shadow rate
+ * dampers run on the same fresh IMU body rates as the active ones. Does nothing without a shadow law.
+ * \sa get_shadow_control()
+ * \ingroup control_fcns
+ */
+extern void get_shadow_inner_control(struct sensordata *sensorData_ptr,	///< pointer to sensorData structure
+		struct control *shadowData_ptr		///< pointer to the shadow copy of the controlData structure
+);
+
+/// Reset the shadow control law.
+/*!
+ * \sa get_shadow_control()
+ * \ingroup control_fcns
+ */
+extern void reset_shadow_control(struct control *shadowData_ptr	///< pointer to the shadow copy of the controlData structure
+);
+
 ///Standard function to add trim biases to the control law outputs. Implemented in control_functions.c
 /*!
  * \sa get_control(), reset_control(), subtract_trim_bias()
@@ -0,0 +1,215 @@
+/*! \file control_laws.c
+ *	\brief Control law table and dispatcher source code
+ *
+ *	\details Registry of the control laws linked into the flight code, and the standard get_control() and
+ *	reset_control() entry points, which step the instance of the law selected by CONTROL_LAW. A second instance of the
+ *	law selected by CONTROL_SHADOW_LAW, if any, runs in shadow mode: it sees the same commands and feedback as the
+ *	active law, its outputs are only logged, so a candidate law can be compared against the active one in flight.
+ *	get_inner_control() runs the inner steps of the active law between frames, see struct control_law.
+ *	\ingroup control_fcns
+ *
+ * \author University of Minnesota
+ * \author Aerospace Engineering and Mechanics
+ * \copyright Copyright 2015 Regents of the University of Minnesota. All rights reserved.
+ *
+ * $Id$
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "../globaldefs.h"
+#include AIRCRAFT_UP1DIR
+#include "../utils/misc.h"
+#include "control_interface.h"
+
+#ifndef CONTROL_LAW
+	#define CONTROL_LAW			"baseline_control"	///< name of the active law
+#endif
+#ifndef CONTROL_SHADOW_LAW
+	#define CONTROL_SHADOW_LAW	""					///< name of the shadow law, "" for none
+#endif
+
+// Registered laws, defined in their own source files
+extern const struct control_law baseline_control_law;
+extern const struct control_law heading_tracker_law;
+extern const struct control_law waypoint_tracker_law;
+extern const struct control_law student_control_law;
+extern const struct control_law ss_control_law;
+extern const struct control_law manual_control_law;
+extern const struct control_law empty_control_law;
+#ifdef RTW_GRT_CONTROL
+extern const struct control_law rtw_grt_control_law;
+#endif
+
+static const struct control_law *const law_table[] = {
+	&baseline_control_law,
+	&heading_tracker_law,
+	&waypoint_tracker_law,
+	&student_control_law,
+	&ss_control_law,
+	&manual_control_law,
+	&empty_control_law,
+#ifdef RTW_GRT_CONTROL
+	&rtw_grt_control_law,	// only with the Simulink generated code linked in; one instance at most
+#endif
+};
+
+// local functions
+static void zero_outputs(struct control *controlData_ptr);
+
+static struct control_instance active, shadow;
+static struct control lawData;	// outputs of the last step of the active law, before the offsets added since
+static short ready;
+
+const struct control_law *find_control_law(const char *name){
+	int i;
+
+	for (i = 0; i < (int)(sizeof(law_table)/sizeof(law_table[0])); i++){
+		if (strcmp(law_table[i]->name, name) == 0)
+			return law_table[i];
+	}
+	return NULL;
+}
+
+int init_control_instance(struct control_instance *inst, const char *name, struct control *controlData_ptr){
+	const struct control_law *law = find_control_law(name);
+
+	inst->law = NULL;
+	inst->state = NULL;
+	if (law == NULL)
+		return -1;
+
+	// one byte at least, so a law without states still gets a distinct context
+	if ((inst->state = calloc(1, law->state_size > 0 ? law->state_size : 1)) == NULL)
+		return -1;
+	inst->law = law;
+	law->reset(inst->state, controlData_ptr);
+	return 0;
+}
+
+void step_control_instance(struct control_instance *inst, double time, struct sensordata *sensorData_ptr,
+		struct nav *navData_ptr, struct control *controlData_ptr){
+	if (inst->law == NULL)
+		return;
+	inst->law->step(inst->state, time, sensorData_ptr, navData_ptr, controlData_ptr);
+	step_inner_control_instance(inst, sensorData_ptr, controlData_ptr);
+}
+
+void step_inner_control_instance(struct control_instance *inst, struct sensordata *sensorData_ptr,
+		struct control *controlData_ptr){
+	if (inst->law != NULL && inst->law->inner != NULL)
+		inst->law->inner(inst->state, INNER_TIMESTEP, sensorData_ptr, controlData_ptr);
+}
+
+void reset_control_instance(struct control_instance *inst, struct control *controlData_ptr){
+	if (inst->law != NULL)
+		inst->law->reset(inst->state, controlData_ptr);
+}
+
+void close_control_instance(struct control_instance *inst){
+	free(inst->state);
+	inst->state = NULL;
+	inst->law = NULL;
+}
+
+int init_control(struct control *controlData_ptr){
+	struct control shadowData;
+	char msg[96];
+
+	if (ready)
+		return 0;
+	ready = 1;
+
+	if (init_control_instance(&active, CONTROL_LAW, controlData_ptr) != 0){
+		snprintf(msg, sizeof(msg), "control: law %s is not registered, control outputs held at zero", CONTROL_LAW);
+		send_status(msg);
+		return -1;
+	}
+	if (CONTROL_SHADOW_LAW[0] != '\0'){
+		memcpy(&shadowData, controlData_ptr, sizeof(shadowData));
+		if (init_control_instance(&shadow, CONTROL_SHADOW_LAW, &shadowData) != 0){
+			snprintf(msg, sizeof(msg), "control: shadow law %s is not registered, shadow disabled", CONTROL_SHADOW_LAW);
+			send_status(msg);
+		}
+	}
+	return 0;
+}
+
+void get_control(double time, struct sensordata *sensorData_ptr, struct nav *navData_ptr, struct control *controlData_ptr){
+	if (!ready)
+		init_control(controlData_ptr);
+	if (active.law != NULL)
+		step_control_instance(&active, time, sensorData_ptr, navData_ptr, controlData_ptr);
+	else
+		zero_outputs(controlData_ptr);
+	lawData = *controlData_ptr;
+}
+
+void get_inner_control(struct sensordata *sensorData_ptr, struct control *controlData_ptr){
+	struct control innerData = lawData;
+
+	if (active.law == NULL || active.law->inner == NULL)
+		return;	// surfaces held over the frame
+	step_inner_control_instance(&active, sensorData_ptr, &innerData);
+
+	// new law outputs, with the offsets added since the step held
+	controlData_ptr->dthr += innerData.dthr - lawData.dthr;	// throttle
+	controlData_ptr->de   += innerData.de   - lawData.de;	// elevator
+	controlData_ptr->dr   += innerData.dr   - lawData.dr;	// rudder
+	controlData_ptr->da_l += innerData.da_l - lawData.da_l;	// left aileron
+	controlData_ptr->da_r += innerData.da_r - lawData.da_r;	// right aileron
+	controlData_ptr->df_l += innerData.df_l - lawData.df_l;	// left flap
+	controlData_ptr->df_r += innerData.df_r - lawData.df_r;	// right flap
+	lawData = innerData;
+}
+
+int get_control_loops(struct control_loops *loops_ptr){
+	memset(loops_ptr, 0, sizeof(*loops_ptr));
+	if (active.law == NULL || active.law->loops == NULL)
+		return -1;
+	active.law->loops(active.state, loops_ptr);
+	return 0;
+}
+
+int get_control_psi_error(void){
+	return (active.law != NULL) ? active.law->psi_error : 0;
+}
+
+int get_control_shadow(void){
+	return (shadow.law != NULL);
+}
+
+void reset_control(struct control *controlData_ptr){
+	if (!ready)
+		init_control(controlData_ptr);
+	if (active.law != NULL)
+		reset_control_instance(&active, controlData_ptr);
+	else
+		zero_outputs(controlData_ptr);
+	lawData = *controlData_ptr;
+}
+
+void get_shadow_control(double time, struct sensordata *sensorData_ptr, struct nav *navData_ptr, struct control *shadowData_ptr){
+	step_control_instance(&shadow, time, sensorData_ptr, navData_ptr, shadowData_ptr);
+}
+
+void get_shadow_inner_control(struct sensordata *sensorData_ptr, struct control *shadowData_ptr){
+	step_inner_control_instance(&shadow, sensorData_ptr, shadowData_ptr);
+}
+
+void reset_shadow_control(struct control *shadowData_ptr){
+	reset_control_instance(&shadow, shadowData_ptr);
+}
+
+/// Surface commands of a missing law.
+static void zero_outputs(struct control *controlData_ptr){
+	controlData_ptr->dthr = 0; // throttle
+	controlData_ptr->de   = 0; // elevator
+	controlData_ptr->dr   = 0; // rudder
+	controlData_ptr->da_l = 0; // left aileron
+	controlData_ptr->da_r = 0; // right aileron
+	controlData_ptr->df_l = 0; // left flap
+	controlData_ptr->df_r = 0; // right flap
+}
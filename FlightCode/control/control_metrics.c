@@ -0,0 +1,173 @@
+/*! \file control_metrics.c
+ *	\brief Onboard control performance metrics source code
+ *
+ *	\details Running tracking statistics and step settling times of each engagement, see control_metrics.h.
+ *	\ingroup control_fcns
+ *
+ * \author University of Minnesota
+ * \author Aerospace Engineering and Mechanics
+ * \copyright Copyright 2015 Regents of the University of Minnesota. All rights reserved.
+ *
+ * $Id$
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include "../globaldefs.h"
+#include AIRCRAFT_UP1DIR
+#include "control_interface.h"
+#include "control_metrics.h"
+
+/// Step in progress on one loop
+struct step {
+	short pending;		///< 1 while the step is being timed
+	short inside;		///< 1 if the feedback was within the band at the last frame
+	double cmd;			///< new command
+	double band;		///< settling band
+	double t_step;		///< [sec], time of the step
+	double t_out;		///< [sec], last time the feedback was outside the band
+};
+
+// local functions
+static double cmd_of(int loop, struct control *controlData_ptr);
+static double loop_diff(int loop, double a, double b);
+static void close_step(int loop);
+
+static const char *const loop_name[LOOP_N] = {"roll", "pitch", "heading", "altitude", "speed"};
+static const double step_min[LOOP_N] = METRICS_STEP_MIN;
+static const double settle_min[LOOP_N] = METRICS_SETTLE_MIN;
+
+static struct loop_metrics metrics[LOOP_N];
+static struct step steps[LOOP_N];
+static double last_cmd[LOOP_N];
+static int closed;			// mask of the loops the active law closed this engagement
+static short have_cmd;		// 0 until the first commands of the engagement
+
+void reset_control_metrics(void){
+	memset(metrics, 0, sizeof(metrics));
+	memset(steps, 0, sizeof(steps));
+	closed = 0;
+	have_cmd = 0;
+}
+
+void get_control_steps(double time, struct control *controlData_ptr){
+	double cmd, d;
+	int k;
+
+	for (k = 0; k < LOOP_N; k++){
+		if (k == LOOP_HEADING && get_control_psi_error())
+			continue;	// psi_cmd is a heading error, not a heading
+		cmd = cmd_of(k, controlData_ptr);
+		d = fabs(loop_diff(k, cmd, last_cmd[k]));
+		last_cmd[k] = cmd;
+		if (!have_cmd || d < step_min[k])
+			continue;
+
+		close_step(k);
+		metrics[k].steps++;
+		steps[k].pending = 1;
+		steps[k].inside = 0;
+		steps[k].cmd = cmd;
+		steps[k].band = mymax(METRICS_SETTLE_FRAC*d, settle_min[k]);
+		steps[k].t_step = time;
+		steps[k].t_out = time;
+	}
+	have_cmd = 1;
+}
+
+void get_control_metrics(double time){
+	struct control_loops loops;
+	struct loop_metrics *m;
+	double e;
+	int k;
+
+	if (get_control_loops(&loops) != 0)
+		return;
+	if (get_control_psi_error())
+		loops.closed &= ~(1 << LOOP_HEADING);	// its reference is the error itself, with no heading feedback
+	closed |= loops.closed;
+
+	for (k = 0; k < LOOP_N; k++){
+		if (!(loops.closed & (1 << k)))
+			continue;
+		m = &metrics[k];
+		e = fabs(loops.e[k]);
+
+		m->n++;
+		m->sum_e2 += e*e;
+		if (e > m->max_e)
+			m->max_e = e;
+		if (loops.sat[k])
+			m->n_sat++;
+
+		// settling of the feedback, ref - e, on the new command
+		if (steps[k].pending){
+			steps[k].inside = (fabs(loop_diff(k, steps[k].cmd, loops.ref[k] - loops.e[k])) <= steps[k].band);
+			if (!steps[k].inside)
+				steps[k].t_out = time;
+		}
+	}
+}
+
+int report_control_metrics(int loop, unsigned short run_num, char *msg, int size){
+	const struct loop_metrics *m;
+	int n;
+
+	if (loop < 0 || loop >= LOOP_N || !(closed & (1 << loop)) || metrics[loop].n == 0)
+		return 0;
+	close_step(loop);
+	m = &metrics[loop];
+
+	n = snprintf(msg, size, "Run %d %s: rms %.4g max %.4g sat %.1f%% steps %d settled %d",
+			run_num, loop_name[loop], sqrt(m->sum_e2/m->n), m->max_e, 100.0*m->n_sat/m->n, m->steps, m->settled);
+	if (m->settled > 0 && n < size)
+		n += snprintf(msg + n, size - n, " ts %.2f/%.2f s", m->sum_ts/m->settled, m->max_ts);
+	return (n < size) ? n : size - 1;
+}
+
+const struct loop_metrics *get_loop_metrics(int loop){
+	if (loop < 0 || loop >= LOOP_N)
+		return NULL;
+	return &metrics[loop];
+}
+
+/// Guidance command of a loop.
+static double cmd_of(int loop, struct control *controlData_ptr){
+	switch (loop){
+	case LOOP_ROLL:		return controlData_ptr->phi_cmd;
+	case LOOP_PITCH:	return controlData_ptr->theta_cmd;
+	case LOOP_HEADING:	return controlData_ptr->psi_cmd;
+	case LOOP_ALTITUDE:	return controlData_ptr->h_cmd;
+	default:			return controlData_ptr->ias_cmd;
+	}
+}
+
+/// a - b, the shorter way round for the heading.
+static double loop_diff(int loop, double a, double b){
+	double d = a - b;
+
+	if (loop == LOOP_HEADING)
+		d -= PI2*floor((d + PI)/PI2);
+	return d;
+}
+
+/// Add the settling time of a pending step to the statistics of its loop.
+static void close_step(int loop){
+	struct step *s = &steps[loop];
+	struct loop_metrics *m = &metrics[loop];
+	double ts;
+
+	if (!s->pending)
+		return;
+	s->pending = 0;
+	if (!s->inside)
+		return;		// unsettled
+
+	ts = s->t_out - s->t_step;
+	m->settled++;
+	m->sum_ts += ts;
+	if (ts > m->max_ts)
+		m->max_ts = ts;
+}
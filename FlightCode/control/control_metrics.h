@@ -0,0 +1,93 @@
+/*! \file control_metrics.h
+ *	\brief Onboard control performance metrics interface header
+ *
+ *	\details Tracking statistics of each autopilot engagement, computed in flight from the tracking loop signals the
+ *	active control law reports, see struct control_loops. For each loop the law closes: RMS and maximum of the
+ *	tracking error, and the fraction of frames its anti-windup holds the integrator at a limit. All are running
+ *	accumulators, O(1) per frame whatever the length of the engagement.
+ *
+ *	A guidance command that jumps by at least METRICS_STEP_MIN in one frame starts a step, detected on the raw
+ *	command, before the reference filter shapes it. The step settles once the loop feedback stays within the settling
+ *	band of the new command, METRICS_SETTLE_FRAC of the step size but no less than METRICS_SETTLE_MIN; the settling
+ *	time runs from the step to the last frame outside the band. A step still outside the band at the next step or at
+ *	the end of the engagement counts as unsettled. Loop and command pair by name: roll and phi_cmd, pitch and
+ *	theta_cmd, heading and psi_cmd, altitude and h_cmd, speed and ias_cmd. The heading loop is left out for a law that
+ *	takes psi_cmd as a heading error (see get_control_psi_error()), which has no heading feedback to measure. The
+ *	thresholds can be set per aircraft in aircraft/XXX_config.h, in the order of enum control_loop.
+ *
+ *	The statistics are reported with send_status() when the autopilot is disengaged.
+ *	\ingroup control_fcns
+ *
+ * \author University of Minnesota
+ * \author Aerospace Engineering and Mechanics
+ * \copyright Copyright 2015 Regents of the University of Minnesota. All rights reserved.
+ *
+ * $Id$
+ */
+
+#ifndef CONTROL_METRICS_H_
+#define CONTROL_METRICS_H_
+
+#ifndef METRICS_STEP_MIN
+	#define METRICS_STEP_MIN	{0.0436, 0.0436, 0.0873, 5.0, 1.0}		///< [rad], [rad], [rad], [m], [m/sec], 2.5 deg, 5 deg
+#endif
+#ifndef METRICS_SETTLE_MIN
+	#define METRICS_SETTLE_MIN	{0.0087, 0.0087, 0.0175, 1.0, 0.5}		///< [rad], [rad], [rad], [m], [m/sec], 0.5 deg, 1 deg
+#endif
+#ifndef METRICS_SETTLE_FRAC
+	#define METRICS_SETTLE_FRAC	0.05	///< settling band, fraction of the step size
+#endif
+
+/// Statistics of one tracking loop over an engagement
+struct loop_metrics {
+	long n;				///< number of frames
+	double sum_e2;		///< sum of the squared tracking errors
+	double max_e;		///< maximum absolute tracking error
+	long n_sat;			///< number of frames the anti-windup holds the integrator
+	int steps;			///< number of steps
+	int settled;		///< number of steps that settled
+	double sum_ts;		///< [sec], sum of the settling times
+	double max_ts;		///< [sec], longest settling time
+};
+
+/// Clear the statistics, at autopilot engagement.
+/*!
+ * \ingroup control_fcns
+ */
+void reset_control_metrics(void);
+
+/// Detect steps in the guidance commands. Call between get_guidance() and get_reference_filter().
+/*!
+ * \ingroup control_fcns
+ */
+void get_control_steps(double time,			///< [sec], time since in autopilot mode
+		struct control *controlData_ptr		///< pointer to controlData structure
+		);
+
+/// Accumulate the statistics of the tracking loops of the active law. Call after get_control().
+/*!
+ * \ingroup control_fcns
+ */
+void get_control_metrics(double time		///< [sec], time since in autopilot mode
+		);
+
+/// Close the last step of a loop and format its statistics, at autopilot disengagement.
+/*!
+ * \return length of the message, 0 if the active law did not close the loop this engagement
+ * \ingroup control_fcns
+ */
+int report_control_metrics(int loop,	///< tracking loop, enum control_loop
+		unsigned short run_num,			///< engagement counter, for the message
+		char *msg,						///< message buffer
+		int size						///< [bytes], size of the message buffer
+		);
+
+/// Statistics of a tracking loop, for logging.
+/*!
+ * \return pointer to the statistics, NULL for an invalid loop
+ * \ingroup control_fcns
+ */
+const struct loop_metrics *get_loop_metrics(int loop	///< tracking loop, enum control_loop
+		);
+
+#endif /* CONTROL_METRICS_H_ */
@@ -18,8 +18,16 @@
 #include "../globaldefs.h"
 #include "control_interface.h" 
 
+// local functions
+static void get_empty_control(void *state, double time, struct sensordata *sensorData_ptr, struct nav *navData_ptr, struct control *controlData_ptr);
+static void reset_empty_control(void *state, struct control *controlData_ptr);
+
+/// Registration in the control law table, see control_laws.c. Add the internal states of a new law to an instance context, see baseline_control.c.
+const struct control_law empty_control_law = {.name = "empty_control", .state_size = 0, .step = get_empty_control, .reset = reset_empty_control,
+		.inner = NULL, .loops = NULL};
+
 /// Return control outputs based on references and feedback signals.
-extern void get_control(double time, struct sensordata *sensorData_ptr, struct nav *navData_ptr, struct control *controlData_ptr) {
+static void get_empty_control(void *state, double time, struct sensordata *sensorData_ptr, struct nav *navData_ptr, struct control *controlData_ptr) {
 
     // Control law: ***********************************************************
     // Here: get_control surface outputs.
@@ -39,7 +47,7 @@ extern void get_control(double time, struct sensordata *sensorData_ptr, struct n
 }
 
 // Reset of controller
-extern void reset_control(struct control *controlData_ptr){
+static void reset_empty_control(void *state, struct control *controlData_ptr){
 	// Here: code to reset the controller
 	controlData_ptr->dthr = 0; // throttle
 	controlData_ptr->de   = 0; // elevator
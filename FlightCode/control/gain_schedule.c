@@ -0,0 +1,160 @@
+/*! \file gain_schedule.c
+ *	\brief Gain scheduling source code
+ *
+ *	\details Bilinear lookup of the control law gains on indicated airspeed and altitude, see gain_schedule.h.
+ *	\ingroup control_fcns
+ *
+ * \author University of Minnesota
+ * \author Aerospace Engineering and Mechanics
+ * \copyright Copyright 2015 Regents of the University of Minnesota. All rights reserved.
+ *
+ * $Id$
+ */
+
+#include "../globaldefs.h"
+#include AIRCRAFT_UP1DIR
+#include "../utils/misc.h"
+#include "gain_schedule.h"
+
+// local functions
+static void load_constant(void);
+
+static struct sched_axis ias_axis, h_axis;
+static struct gain_set table[SCHED_MAX_BP*SCHED_MAX_BP];	// altitude major
+static short ready;
+
+int sched_axis_init(struct sched_axis *a, const double *x, int n){
+	int i;
+
+	if (n < 1 || n > SCHED_MAX_BP)
+		return -1;
+
+	a->n = n;
+	a->i = 0;
+	for (i = 0; i < n; i++){
+		a->x[i] = x[i];
+		if (i > 0){
+			if (x[i] <= x[i-1])
+				return -1;
+			a->inv_dx[i-1] = 1.0/(x[i] - x[i-1]);
+		}
+	}
+	a->inv_dx[n-1] = 0.0;
+	return 0;
+}
+
+int sched_lookup(struct sched_axis *a, double x, double *frac){
+	int i = a->i;
+
+	if (a->n < 2){
+		*frac = 0.0;
+		return 0;
+	}
+
+	// clamp to the ends of the table
+	if (x <= a->x[0]){
+		a->i = 0;
+		*frac = 0.0;
+		return 0;
+	}
+	if (x >= a->x[a->n-1]){
+		a->i = a->n-2;
+		*frac = 1.0;
+		return a->n-2;
+	}
+
+	// step from the last bracket; x[0] < x < x[n-1] keeps i within [0, n-2]
+	while (x < a->x[i])
+		i--;
+	while (x >= a->x[i+1])
+		i++;
+
+	a->i = i;
+	*frac = (x - a->x[i])*a->inv_dx[i];
+	return i;
+}
+
+void init_gain_schedule(void){
+#if defined(SCHED_IAS_BP) && defined(SCHED_H_BP) && defined(SCHED_GAINS)
+	static const double ias_bp[] = SCHED_IAS_BP;
+	static const struct gain_set gains[] = SCHED_GAINS;
+	static const double h_bp[] = SCHED_H_BP;
+	int n_ias = sizeof(ias_bp)/sizeof(ias_bp[0]);
+	int n_h = sizeof(h_bp)/sizeof(h_bp[0]);
+	int i;
+
+	if (n_ias*n_h != (int)(sizeof(gains)/sizeof(gains[0])) || sched_axis_init(&ias_axis, ias_bp, n_ias) != 0
+			|| sched_axis_init(&h_axis, h_bp, n_h) != 0){
+		send_status("gain_schedule: table does not match its breakpoints, constant gains used");
+		load_constant();
+	}
+	else{
+		for (i = 0; i < n_ias*n_h; i++)
+			table[i] = gains[i];
+	}
+#else
+	load_constant();
+#endif
+	ready = 1;
+}
+
+void get_gain_schedule(double ias, double h, struct gain_set *gs){
+	const struct gain_set *g00, *g01, *g10, *g11;
+	double fi, fj, w00, w01, w10, w11;
+	int i, j, di, dj;
+
+	if (!ready)
+		init_gain_schedule();
+
+	i = sched_lookup(&ias_axis, ias, &fi);
+	j = sched_lookup(&h_axis, h, &fj);
+	di = (ias_axis.n > 1) ? 1 : 0;
+	dj = (h_axis.n > 1) ? ias_axis.n : 0;
+
+	// corners of the cell: g<altitude><airspeed>
+	g00 = &table[j*ias_axis.n + i];
+	g01 = g00 + di;
+	g10 = g00 + dj;
+	g11 = g10 + di;
+
+	w00 = (1.0 - fj)*(1.0 - fi);
+	w01 = (1.0 - fj)*fi;
+	w10 = fj*(1.0 - fi);
+	w11 = fj*fi;
+
+#define BLEND(f)	gs->f = w00*g00->f + w01*g01->f + w10*g10->f + w11*g11->f
+	BLEND(roll[0]);
+	BLEND(roll[1]);
+	BLEND(roll[2]);
+	BLEND(pitch[0]);
+	BLEND(pitch[1]);
+	BLEND(pitch[2]);
+	BLEND(alt[0]);
+	BLEND(alt[1]);
+	BLEND(v[0]);
+	BLEND(v[1]);
+	BLEND(head);
+	BLEND(base_pitch);
+#undef BLEND
+}
+
+/// One point table of the constant gains of globaldefs.h.
+static void load_constant(void){
+	double zero = 0.0;
+
+	sched_axis_init(&ias_axis, &zero, 1);
+	sched_axis_init(&h_axis, &zero, 1);
+
+	table[0].roll[0] = roll_gain[0];
+	table[0].roll[1] = roll_gain[1];
+	table[0].roll[2] = roll_gain[2];
+	table[0].pitch[0] = pitch_gain[0];
+	table[0].pitch[1] = pitch_gain[1];
+	table[0].pitch[2] = pitch_gain[2];
+	table[0].alt[0] = alt_gain[0];
+	table[0].alt[1] = alt_gain[1];
+	table[0].v[0] = v_gain[0];
+	table[0].v[1] = v_gain[1];
+	table[0].head = head_gain;
+	table[0].base_pitch = base_pitch_cmd;
+}
@@ -0,0 +1,85 @@
+/*! \file gain_schedule.h
+ *	\brief Gain scheduling interface header
+ *
+ *	\details Control law gains and pitch trim scheduled on indicated airspeed and altitude. The schedule is a 2D table
+ *	of gain sets over airspeed and altitude breakpoints, set in aircraft/XXX_config.h:
+ *
+ *	\code
+ *	#define SCHED_IAS_BP	{13.0, 17.0, 21.0}	// [m/s], increasing
+ *	#define SCHED_H_BP		{0.0, 300.0}		// [m], increasing
+ *	#define SCHED_GAINS		{ {...}, {...}, ... }	// struct gain_set per breakpoint pair, altitude major
+ *	\endcode
+ *
+ *	An aircraft without a schedule gets a one point table holding the constant gains of globaldefs.h, so its laws
+ *	behave as before. Lookups are bilinear and clamp to the ends of the table. Each axis keeps the bracket of its last
+ *	lookup and steps from there, so the search costs O(1) for the slowly varying inputs of consecutive frames; the
+ *	reciprocal breakpoint spacings are precomputed when the table is loaded.
+ *	\ingroup control_fcns
+ *
+ * \author University of Minnesota
+ * \author Aerospace Engineering and Mechanics
+ * \copyright Copyright 2015 Regents of the University of Minnesota. All rights reserved.
+ *
+ * $Id$
+ */
+
+#ifndef GAIN_SCHEDULE_H_
+#define GAIN_SCHEDULE_H_
+
+#define SCHED_MAX_BP	8	///< maximum number of breakpoints per axis
+
+/// Gains of the control laws at one flight condition, in the layout of the constants in globaldefs.h
+struct gain_set {
+	double roll[3];		///< PI gains for roll tracker and roll damper
+	double pitch[3];	///< PI gains for theta tracker and pitch damper
+	double alt[2];		///< PI gains for altitude tracker
+	double v[2];		///< PI gains for speed tracker
+	double head;		///< P gain for heading tracker
+	double base_pitch;	///< [rad], pitch trim, subtracted from theta to convert to delta coordinates
+};
+
+/// Breakpoint axis with a cached bracket
+struct sched_axis {
+	int n;						///< number of breakpoints
+	double x[SCHED_MAX_BP];		///< breakpoints, increasing
+	double inv_dx[SCHED_MAX_BP];	///< 1/(x[i+1] - x[i])
+	int i;						///< bracket of the last lookup, x[i] <= x < x[i+1]
+};
+
+/// Set up a breakpoint axis.
+/*!
+ * \return 0 on success, -1 if there are too many breakpoints or they are not increasing
+ * \ingroup control_fcns
+ */
+int sched_axis_init(struct sched_axis *a,	///< pointer to axis
+		const double *x,	///< breakpoints, increasing
+		int n				///< number of breakpoints, 1 to SCHED_MAX_BP
+		);
+
+/// Locate a value on an axis, starting from the bracket of the last lookup.
+/*!
+ * \return index i of the bracket x[i] <= x <= x[i+1], with *frac the fraction of the way to x[i+1] clamped to [0, 1];
+ * 0 with *frac = 0 for a one point axis
+ * \ingroup control_fcns
+ */
+int sched_lookup(struct sched_axis *a,	///< pointer to axis
+		double x,		///< value
+		double *frac	///< fraction within the bracket
+		);
+
+/// Load the schedule of the aircraft configuration. Called by get_gain_schedule() if not called before.
+/*!
+ * \ingroup control_fcns
+ */
+void init_gain_schedule(void);
+
+/// Gains at a flight condition.
+/*!
+ * \ingroup control_fcns
+ */
+void get_gain_schedule(double ias,	///< [m/s], indicated airspeed
+		double h,				///< [m], altitude
+		struct gain_set *gs		///< scheduled gains
+		);
+
+#endif /* GAIN_SCHEDULE_H_ */
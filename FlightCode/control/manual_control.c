@@ -18,8 +18,16 @@
 #include "../globaldefs.h"
 #include "control_interface.h" 
 
+// local functions
+static void get_manual_control(void *state, double time, struct sensordata *sensorData_ptr, struct nav *navData_ptr, struct control *controlData_ptr);
+static void reset_manual_control(void *state, struct control *controlData_ptr);
+
+/// Registration in the control law table, see control_laws.c. The law has no internal states.
+const struct control_law manual_control_law = {.name = "manual_control", .state_size = 0, .step = get_manual_control, .reset = reset_manual_control,
+		.inner = NULL, .loops = NULL};
+
 /// Return control outputs based on references and feedback signals.
-extern void get_control(double time, struct sensordata *sensorData_ptr, struct nav *navData_ptr, struct control *controlData_ptr) {
+static void get_manual_control(void *state, double time, struct sensordata *sensorData_ptr, struct nav *navData_ptr, struct control *controlData_ptr) {
 
 	controlData_ptr->dthr = controlData_ptr->dthr_in; // throttle
     controlData_ptr->de = controlData_ptr->de_in; // Elevator deflection [rad]
@@ -31,7 +39,7 @@ extern void get_control(double time, struct sensordata *sensorData_ptr, struct n
 }
 
 // Reset of controller
-extern void reset_control(struct control *controlData_ptr){
+static void reset_manual_control(void *state, struct control *controlData_ptr){
 	// Here: code to reset the controller
 	controlData_ptr->dthr = 0; // throttle
 	controlData_ptr->de   = 0; // elevator
@@ -0,0 +1,122 @@
+/*! \file reference_filter.c
+ *	\brief Guidance command shaping source code
+ *
+ *	\details Rate and acceleration limited prefilters on the guidance commands, see reference_filter.h.
+ *	\ingroup control_fcns
+ *
+ * \author University of Minnesota
+ * \author Aerospace Engineering and Mechanics
+ * \copyright Copyright 2015 Regents of the University of Minnesota. All rights reserved.
+ *
+ * $Id$
+ */
+
+#include <math.h>
+
+#include "../globaldefs.h"
+#include AIRCRAFT_UP1DIR
+#include "control_interface.h"
+#include "reference_filter.h"
+
+// local functions
+static void shape(struct ref_filter *f, double *cmd, double y0);
+static void restore(const struct ref_filter *f, double *cmd);
+
+// psi_cmd is not wrapped: heading laws may command an unwrapped heading, several turns for continuous circles
+static struct ref_filter psi_filter = {0.0, 0.0, 0.0, REF_PSI_RATE, REF_PSI_ACC, 0, 0};
+static struct ref_filter h_filter = {0.0, 0.0, 0.0, REF_H_RATE, REF_H_ACC, 0, 0};
+static struct ref_filter ias_filter = {0.0, 0.0, 0.0, REF_IAS_RATE, REF_IAS_ACC, 0, 0};
+
+void init_ref_filter(struct ref_filter *f, double rate_max, double acc_max, short wrap){
+	f->rate_max = rate_max;
+	f->acc_max = acc_max;
+	f->wrap = wrap;
+	reset_ref_filter(f);
+}
+
+void reset_ref_filter(struct ref_filter *f){
+	f->y = 0.0;
+	f->yd = 0.0;
+	f->u = 0.0;
+	f->init = 0;
+}
+
+double ref_filter(struct ref_filter *f, double u, double dt){
+	double e, v, dv, a;
+
+	if (f->init == 0 || f->rate_max <= 0.0){
+		f->y = u;
+		f->yd = 0.0;
+		f->init = 1;
+		return u;
+	}
+
+	e = u - f->y;
+	if (f->wrap){
+		if (e > PI) e -= PI2;
+		else if (e < -PI) e += PI2;
+	}
+
+	// fastest rate from which the acceleration limit still stops on the command in whole steps, within the rate
+	// limit and without passing the command in one step
+	if (f->acc_max > 0.0){
+		a = 0.5*f->acc_max*dt;
+		v = sqrt(a*a + 2.0*f->acc_max*fabs(e)) - a;
+	}
+	else
+		v = f->rate_max;
+	if (v > f->rate_max) v = f->rate_max;
+	if (v*dt > fabs(e)) v = fabs(e)/dt;
+	if (e < 0.0) v = -v;
+
+	dv = v - f->yd;
+	if (f->acc_max > 0.0){
+		if (dv > f->acc_max*dt) dv = f->acc_max*dt;
+		else if (dv < -f->acc_max*dt) dv = -f->acc_max*dt;
+	}
+	f->yd += dv;
+	f->y += f->yd*dt;
+
+	if (f->wrap){
+		if (f->y > PI) f->y -= PI2;
+		else if (f->y <= -PI) f->y += PI2;
+	}
+	return f->y;
+}
+
+void get_reference_filter(struct sensordata *sensorData_ptr, struct control *controlData_ptr){
+	// a heading error is already relative to the aircraft, shaping it would lag the loop
+	if (!get_control_psi_error())
+		shape(&psi_filter, &controlData_ptr->psi_cmd, 0.0);
+	shape(&h_filter, &controlData_ptr->h_cmd, 0.0);
+	shape(&ias_filter, &controlData_ptr->ias_cmd, sensorData_ptr->adData_ptr->ias_filt);
+}
+
+void restore_reference_filter(struct control *controlData_ptr){
+	restore(&psi_filter, &controlData_ptr->psi_cmd);
+	restore(&h_filter, &controlData_ptr->h_cmd);
+	restore(&ias_filter, &controlData_ptr->ias_cmd);
+}
+
+void reset_reference_filter(void){
+	reset_ref_filter(&psi_filter);
+	reset_ref_filter(&h_filter);
+	reset_ref_filter(&ias_filter);
+}
+
+/// Shape one raw command in place. A filter not yet started starts from y0, as if it had been holding the aircraft there.
+static void shape(struct ref_filter *f, double *cmd, double y0){
+	if (f->init == 0 && f->rate_max > 0.0){
+		f->y = y0;
+		f->yd = 0.0;
+		f->init = 1;
+	}
+	f->u = *cmd;
+	*cmd = ref_filter(f, *cmd, TIMESTEP);
+}
+
+/// Put the last raw command back in place of the shaped one; nothing to restore before the filter has started.
+static void restore(const struct ref_filter *f, double *cmd){
+	if (f->init)
+		*cmd = f->u;
+}
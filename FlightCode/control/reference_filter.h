@@ -0,0 +1,116 @@
+/*! \file reference_filter.h
+ *	\brief Guidance command shaping interface header
+ *
+ *	\details Second order rate and acceleration limited prefilters that shape the guidance commands psi_cmd, h_cmd
+ *	and ias_cmd between get_guidance() and get_control(), so a step from a guidance law (a waypoint switch, a new
+ *	pattern segment) reaches the control law as a ramp the aircraft can follow instead of saturating its integrators.
+ *	Each filter moves its output no faster than the rate limit and changes that rate no faster than the acceleration
+ *	limit, and brakes so it stops on the command without overshoot. The default limits below can be overridden
+ *	per aircraft in aircraft/XXX_config.h; a rate limit of 0 passes the channel through unchanged.
+ *
+ *	After the autopilot is engaged each filter starts from the aircraft state, in the command convention of the
+ *	heading and waypoint trackers: the heading and altitude relative to the engage point, 0, and the filtered
+ *	airspeed. The guidance commands are then reached as ramps, whenever the law first writes them. The shaped
+ *	commands are swapped back for the raw ones before each get_guidance(), so a law that sets a command once, or
+ *	reads back its own previous command, only ever sees raw commands. psi_cmd is shaped
+ *	unwrapped, as a heading law may command several turns, and passes through unchanged for a control law that
+ *	takes it as a heading error (see get_control_psi_error()).
+ *	\ingroup control_fcns
+ *
+ * \author University of Minnesota
+ * \author Aerospace Engineering and Mechanics
+ * \copyright Copyright 2015 Regents of the University of Minnesota. All rights reserved.
+ *
+ * $Id$
+ */
+
+#ifndef REFERENCE_FILTER_H_
+#define REFERENCE_FILTER_H_
+
+// Default limits, for aircraft configurations that do not set their own
+#ifndef REF_PSI_RATE
+	#define REF_PSI_RATE	0.5236	///< [rad/sec], 30 deg/sec
+#endif
+#ifndef REF_PSI_ACC
+	#define REF_PSI_ACC		1.0		///< [rad/sec^2]
+#endif
+#ifndef REF_H_RATE
+	#define REF_H_RATE		3.0		///< [m/sec]
+#endif
+#ifndef REF_H_ACC
+	#define REF_H_ACC		1.0		///< [m/sec^2]
+#endif
+#ifndef REF_IAS_RATE
+	#define REF_IAS_RATE	1.0		///< [m/sec^2]
+#endif
+#ifndef REF_IAS_ACC
+	#define REF_IAS_ACC		1.0		///< [m/sec^3]
+#endif
+
+/// Rate and acceleration limited prefilter
+struct ref_filter {
+	double y;			///< shaped command
+	double yd;			///< rate of the shaped command
+	double u;			///< last raw command, kept by get_reference_filter()
+	double rate_max;	///< rate limit, 0 to pass the input through
+	double acc_max;		///< acceleration limit, 0 for a rate limit only
+	short wrap;			///< 1 for an angle in (-PI, PI], shaped along the shorter way round
+	short init;			///< 0 until the first input, which is passed through
+};
+
+/// Set the limits of a prefilter and reset it.
+/*!
+ * \sa ref_filter(), reset_ref_filter()
+ * \ingroup control_fcns
+ */
+void init_ref_filter(struct ref_filter *f,	///< pointer to prefilter
+		double rate_max,	///< rate limit, 0 to pass the input through
+		double acc_max,		///< acceleration limit, 0 for a rate limit only
+		short wrap			///< 1 for an angle in (-PI, PI]
+		);
+
+/// Reset a prefilter, so its next input is passed through and becomes its initial state.
+/*!
+ * \ingroup control_fcns
+ */
+void reset_ref_filter(struct ref_filter *f	///< pointer to prefilter
+		);
+
+/// Advance a prefilter by one step.
+/*!
+ * \return shaped command
+ * \ingroup control_fcns
+ */
+double ref_filter(struct ref_filter *f,	///< pointer to prefilter
+		double u,		///< raw command
+		double dt		///< [sec], time step
+		);
+
+/// Shape psi_cmd, h_cmd and ias_cmd in place. Call between get_guidance() and get_control().
+/*!
+ * The first call after a reset starts the filters from the aircraft state.
+ * \sa restore_reference_filter(), reset_reference_filter()
+ * \ingroup control_fcns
+ */
+void get_reference_filter(struct sensordata *sensorData_ptr,	///< pointer to sensorData structure
+		struct control *controlData_ptr		///< pointer to controlData structure
+		);
+
+/// Put the raw commands of the previous frame back in psi_cmd, h_cmd and ias_cmd. Call just before get_guidance().
+/*!
+ * A command the guidance law does not write this frame is then shaped from its last raw value, not from the
+ * shaped value left by the previous frame.
+ * \sa get_reference_filter()
+ * \ingroup control_fcns
+ */
+void restore_reference_filter(struct control *controlData_ptr	///< pointer to controlData structure
+		);
+
+/// Reset the command prefilters, so they start from the aircraft state on the next get_reference_filter().
+/*!
+ * \sa get_reference_filter()
+ * \ingroup control_fcns
+ */
+void reset_reference_filter(void);
+
+#endif /* REFERENCE_FILTER_H_ */
@@ -21,8 +21,17 @@ void MdlUpdate(int_T tid);
 void MdlOutputs(int_T tid);
 void MdlStart(void);
 
+// local functions
+static void get_rtw_grt_control(void *state, double time, struct sensordata *sensorData_ptr, struct nav *navData_ptr, struct control *controlData_ptr);
+static void reset_rtw_grt_control(void *state, struct control *controlData_ptr);
 
-void get_control(double time, struct sensordata *sensorData_ptr, struct nav *navData_ptr, struct control *controlData_ptr){
+/// Registration in the control law table, see control_laws.c. The generated model keeps its states in global
+/// variables, so there is at most one instance of this law.
+const struct control_law rtw_grt_control_law = {.name = "rtw_grt_control", .state_size = 0, .step = get_rtw_grt_control, .reset = reset_rtw_grt_control,
+		.inner = NULL, .loops = NULL};
+
+
+static void get_rtw_grt_control(void *state, double time, struct sensordata *sensorData_ptr, struct nav *navData_ptr, struct control *controlData_ptr){
 
 	// Populate the reference commands and feedback inputs for the Simulink diagram.
 	// See ../../Documentation/UAV_controllaw_ICD.xlsx for details.
@@ -80,7 +89,7 @@ void get_control(double time, struct sensordata *sensorData_ptr, struct nav *nav
 	controlData_ptr->df_r = rtY.control_cmd[6]; // right flap
 }
 
-void reset_control(struct control *controlData_ptr){
+static void reset_rtw_grt_control(void *state, struct control *controlData_ptr){
 	// Reset internal states to initial condition
 	MdlStart();
 	
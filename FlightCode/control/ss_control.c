@@ -0,0 +1,217 @@
+/*! \file ss_control.c
+ *	\brief State space controller source code
+ *
+ *	\details Native state space controller, see ss_control.h. The built-in matrices are the LQI design of
+ *	Simulation/Controllers/lqr_control.mdl: integral of the theta error, pitch rate and theta to the elevator, and
+ *	integral of the phi error, roll rate, yaw rate and phi to the ailerons and rudder. Other designs of the same
+ *	signal layout are loaded from SS_CONTROL_FILE, so a new gain set flies without the Real Time Workshop code of
+ *	rtw_grt_control.c.
+ *
+ *	\ingroup control_fcns
+ *
+ *	\author University of Minnesota
+ *	\author Aerospace Engineering and Mechanics
+ *	\copyright Copyright 2015 Regents of the University of Minnesota. All rights reserved.
+ *
+ * $Id$
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "../globaldefs.h"
+#include AIRCRAFT_UP1DIR
+#include "../utils/misc.h"
+#include "control_interface.h"
+#include "control_allocation.h"
+#include "control_blocks.h"
+#include "gain_schedule.h"
+#include "ss_control.h"
+
+// Signal layout
+enum {U_THETA_CMD, U_THETA, U_Q, U_PHI_CMD, U_PHI, U_P, U_R};	// inputs
+enum {Y_DE, Y_DA, Y_DR};										// outputs
+
+/// Instance context
+struct ss_control_state {
+	double x[SS_NX];		///< controller states
+	struct gain_set gains;	///< for the pitch trim, scheduled on airspeed and altitude every frame
+	struct control_loops loops;	///< tracking loop signals of the last step, for the metrics
+};
+
+// local functions
+static void get_ss_control(void *state, double time, struct sensordata *sensorData_ptr, struct nav *navData_ptr, struct control *controlData_ptr);
+static void reset_ss_control(void *state, struct control *controlData_ptr);
+static void loops_ss_control(const void *state, struct control_loops *loops_ptr);
+
+/// Registration in the control law table, see control_laws.c
+const struct control_law ss_control_law = {.name = "ss_control", .state_size = sizeof(struct ss_control_state),
+		.step = get_ss_control, .reset = reset_ss_control,
+		.inner = NULL, .loops = loops_ss_control};	// discrete at TIMESTEP, runs at the frame rate
+
+/// Built-in LQI design, used when SS_CONTROL_FILE is missing or invalid. Gains from Simulation/SIL_Sim/setup.m:
+/// K_pitch = [K_thetaerr K_q K_theta], K_roll = [K_phierr K_p K_r K_phi] for the aileron and rudder rows.
+static const struct ss_model builtin_model = {
+	// A: forward Euler integrators
+	{{1.0, 0.0},
+	 {0.0, 1.0}},
+	// B: theta_cmd, theta, q, phi_cmd, phi, p, r
+	{{TIMESTEP, -TIMESTEP, 0.0, 0.0, 0.0, 0.0, 0.0},
+	 {0.0, 0.0, 0.0, TIMESTEP, -TIMESTEP, 0.0, 0.0}},
+	// C
+	{{-0.240144526553189, 0.0},
+	 {0.0, -0.6679},
+	 {0.0, -0.1355}},
+	// D
+	{{0.0, 0.287138908852059, 0.079132432193614, 0.0, 0.0, 0.0, 0.0},
+	 {0.0, 0.0, 0.0, 0.0, 0.3631, 0.0243, 0.0251},
+	 {0.0, 0.0, 0.0, 0.0, 0.0710, 0.0004, 0.0284}}
+};
+
+static struct ss_model model;	// shared by all instances, loaded once
+static short loaded;
+
+/// Return control outputs based on references and feedback signals.
+static void get_ss_control(void *state, double time, struct sensordata *sensorData_ptr, struct nav *navData_ptr, struct control *controlData_ptr) {
+	struct ss_control_state *s = state;
+	double u[SS_NU], y[SS_NY], x0[SS_NX];
+	double de, da, dr;
+	int i;
+
+	get_gain_schedule(sensorData_ptr->adData_ptr->ias_filt, sensorData_ptr->adData_ptr->h_filt, &s->gains);
+
+	u[U_THETA_CMD] = controlData_ptr->theta_cmd;
+	u[U_THETA] = navData_ptr->the - s->gains.base_pitch;	// subtract theta trim value to convert to delta coordinates
+	u[U_Q] = sensorData_ptr->imuData_ptr->q;
+	u[U_PHI_CMD] = controlData_ptr->phi_cmd;
+	u[U_PHI] = navData_ptr->phi;
+	u[U_P] = sensorData_ptr->imuData_ptr->p;
+	u[U_R] = sensorData_ptr->imuData_ptr->r;
+
+	for (i = 0; i < SS_NX; i++)
+		x0[i] = s->x[i];
+	ss_step(&model, s->x, u, y);
+
+	de = saturate(y[Y_DE], -ELEVATOR_AUTH_MAX-ELEVATOR_TRIM, ELEVATOR_AUTH_MAX-ELEVATOR_TRIM);
+	da = saturate(y[Y_DA], -AILERON_AUTH_MAX, AILERON_AUTH_MAX);
+	dr = saturate(y[Y_DR], -RUDDER_AUTH_MAX, RUDDER_AUTH_MAX);
+
+	// anti-windup: hold the states while an output is saturated
+	if (de != y[Y_DE] || da != y[Y_DA] || dr != y[Y_DR]){
+		for (i = 0; i < SS_NX; i++)
+			s->x[i] = x0[i];
+	}
+
+	// tracking loop signals, for the metrics
+	s->loops.ref[LOOP_ROLL]  = u[U_PHI_CMD];
+	s->loops.e[LOOP_ROLL]    = u[U_PHI_CMD] - u[U_PHI];
+	s->loops.sat[LOOP_ROLL]  = (da != y[Y_DA] || dr != y[Y_DR]);
+	s->loops.ref[LOOP_PITCH] = u[U_THETA_CMD];
+	s->loops.e[LOOP_PITCH]   = u[U_THETA_CMD] - u[U_THETA];
+	s->loops.sat[LOOP_PITCH] = (de != y[Y_DE]);
+	s->loops.closed = (1 << LOOP_ROLL) | (1 << LOOP_PITCH);
+
+	controlData_ptr->de = de;		// Elevator deflection [rad]
+	controlData_ptr->dr = dr;		// Rudder deflection [rad]
+	controlData_ptr->da_r = da;		// Roll, as right Aileron deflection [rad]
+	controlData_ptr->dthr = 0; // throttle
+
+	allocate_controls(controlData_ptr);	// mix to all surfaces, see control_allocation.h
+}
+
+/// Tracking loops: theta and phi.
+static void loops_ss_control(const void *state, struct control_loops *loops_ptr) {
+	const struct ss_control_state *s = state;
+
+	*loops_ptr = s->loops;
+}
+
+// Reset of controller
+static void reset_ss_control(void *state, struct control *controlData_ptr){
+	struct ss_control_state *s = state;
+	char msg[96];
+	int i;
+
+	if (!loaded){
+		loaded = 1;
+		model = builtin_model;
+		if (load_ss_model(&model, SS_CONTROL_FILE) != 0){
+			snprintf(msg, sizeof(msg), "ss_control: %s missing or invalid, built-in LQI design used", SS_CONTROL_FILE);
+			send_status(msg);
+		}
+	}
+
+	for (i = 0; i < SS_NX; i++)
+		s->x[i] = 0.0;
+	memset(&s->loops, 0, sizeof(s->loops));
+
+	controlData_ptr->dthr = 0; // throttle
+	controlData_ptr->de   = 0; // elevator
+	controlData_ptr->dr   = 0; // rudder
+	controlData_ptr->da_l = 0; // left aileron
+	controlData_ptr->da_r = 0; // right aileron
+	controlData_ptr->df_l = 0; // left flap
+	controlData_ptr->df_r = 0; // right flap
+}
+
+int load_ss_model(struct ss_model *m, const char *filename){
+	static const int nrows[4] = {SS_NX, SS_NX, SS_NY, SS_NY};
+	static const int ncols[4] = {SS_NX, SS_NU, SS_NX, SS_NU};
+	struct ss_model tmp;
+	double *mat[4];
+	int rows[4] = {0, 0, 0, 0};
+	FILE *fp;
+	char line[512], name[16], *p, *end;
+	double ts = 0.0, *row;
+	int n, k, j, ok = 1;
+
+	if ((fp = fopen(filename, "r")) == NULL)
+		return -1;
+
+	mat[0] = &tmp.A[0][0];
+	mat[1] = &tmp.B[0][0];
+	mat[2] = &tmp.C[0][0];
+	mat[3] = &tmp.D[0][0];
+
+	while (ok && fgets(line, sizeof(line), fp) != NULL){
+		if (sscanf(line, "%15s%n", name, &n) != 1 || name[0] == '#')
+			continue;	// blank line or comment
+
+		if (strcmp(name, "timestep") == 0){
+			ts = strtod(line + n, NULL);
+			continue;
+		}
+		if (name[1] != '\0' || name[0] < 'A' || name[0] > 'D')
+			continue;
+		k = name[0] - 'A';
+
+		if (rows[k] >= nrows[k]){
+			ok = 0;		// too many rows
+			break;
+		}
+		row = mat[k] + rows[k]*ncols[k];
+		p = line + n;
+		for (j = 0; j < ncols[k]; j++){
+			row[j] = strtod(p, &end);
+			if (end == p){
+				ok = 0;	// short row
+				break;
+			}
+			p = end;
+		}
+		rows[k]++;
+	}
+	fclose(fp);
+
+	for (k = 0; k < 4; k++){
+		if (rows[k] != nrows[k])
+			ok = 0;
+	}
+	if (!ok || fabs(ts - TIMESTEP) > 1e-9)
+		return -1;
+
+	*m = tmp;
+	return 0;
+}
@@ -0,0 +1,79 @@
+/*! \file ss_control.h
+ *	\brief State space controller interface header
+ *
+ *	\details Discrete state space controller of fixed size,
+ *
+ *	\code
+ *	x[k+1] = A*x[k] + B*u[k]
+ *	  y[k] = C*x[k] + D*u[k]
+ *	\endcode
+ *
+ *	with the dimensions set at compile time by the signal layout of ss_control.c, so the matrices are plain arrays
+ *	and every loop of the kernel has a constant trip count the compiler unrolls. The matrices are computed offline,
+ *	see write_ss_control_file.m, and loaded from SS_CONTROL_FILE when the law is first reset, falling back to the
+ *	built-in LQI design of Simulation/Controllers/lqr_control.mdl.
+ *	\ingroup control_fcns
+ *
+ * \author University of Minnesota
+ * \author Aerospace Engineering and Mechanics
+ * \copyright Copyright 2015 Regents of the University of Minnesota. All rights reserved.
+ *
+ * $Id$
+ */
+
+#ifndef SS_CONTROL_H_
+#define SS_CONTROL_H_
+
+#ifndef SS_CONTROL_FILE
+	#define SS_CONTROL_FILE	"ss_control.txt"	///< matrices of the controller, one row per line, see write_ss_control_file.m
+#endif
+
+// Controller dimensions, fixed by the signal layout of ss_control.c
+#define SS_NX	2	///< number of states: integrals of the theta and phi tracking errors
+#define SS_NU	7	///< number of inputs: theta_cmd, theta, q, phi_cmd, phi, p, r
+#define SS_NY	3	///< number of outputs: de, da, dr
+
+/// State space model, row major
+struct ss_model {
+	double A[SS_NX][SS_NX];		///< state matrix
+	double B[SS_NX][SS_NU];		///< input matrix
+	double C[SS_NY][SS_NX];		///< output matrix
+	double D[SS_NY][SS_NU];		///< feedthrough matrix
+};
+
+/// One step of the controller: outputs from the current state, then the state update.
+static inline void ss_step(const struct ss_model *m, double *x, const double *u, double *y){
+	double xn[SS_NX];
+	int i, j;
+
+	for (i = 0; i < SS_NY; i++){
+		y[i] = 0.0;
+		for (j = 0; j < SS_NX; j++)
+			y[i] += m->C[i][j]*x[j];
+		for (j = 0; j < SS_NU; j++)
+			y[i] += m->D[i][j]*u[j];
+	}
+
+	for (i = 0; i < SS_NX; i++){
+		xn[i] = 0.0;
+		for (j = 0; j < SS_NX; j++)
+			xn[i] += m->A[i][j]*x[j];
+		for (j = 0; j < SS_NU; j++)
+			xn[i] += m->B[i][j]*u[j];
+	}
+	for (i = 0; i < SS_NX; i++)
+		x[i] = xn[i];
+}
+
+/// Load the matrices of a controller from a file.
+/*!
+ * The file holds the keyword "timestep" with the sample time the matrices were discretized at, then one line per
+ * matrix row: the matrix name A, B, C or D followed by the row; '#' starts a comment.
+ * \return 0 on success, -1 if the file is missing, a row is missing or incomplete, or the sample time is not TIMESTEP
+ * \ingroup control_fcns
+ */
+int load_ss_model(struct ss_model *m,	///< pointer to the model, unchanged on failure
+		const char *filename		///< file name
+		);
+
+#endif /* SS_CONTROL_H_ */
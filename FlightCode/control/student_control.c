@@ -16,6 +16,8 @@
 #include <math.h>
 #include "../globaldefs.h"
 #include "control_interface.h"
+#include "control_allocation.h"
+#include "control_blocks.h"
 
 
 // ***********************************************************************************
@@ -28,44 +30,52 @@
 // ***********************************************************************************
 
 
-/// Definition of local functions and variables: *******************************************
-static double yaw_damper (double yawrate);
-static double roll_control (double phi_ref, double roll_angle, double rollrate, double delta_t);
-static double pitch_control(double the_ref, double pitch, double pitchrate, double delta_t);
-
-static double dr; // Delta rudder    
-static double da; // Delta aileron
-static double de; // Delta elevator
-
+/// Instance context: keep every state of the controller here, so several instances can run side by side
+struct student_control_state {
+	struct pid roll_pi;			///< roll tracker
+	struct pid pitch_pi;		///< theta tracker
+	struct biquad yaw_filter;	///< yaw damper
+	double roll_out;			///< roll tracker output before the roll damper, held over the frame
+	double pitch_out;			///< theta tracker output before the pitch damper, held over the frame
+	struct control_loops loops;	///< tracking loop signals of the last step, for the metrics
+};
 
+/// Definition of local functions and variables: *******************************************
+static void get_student_control(void *state, double time, struct sensordata *sensorData_ptr, struct nav *navData_ptr, struct control *controlData_ptr);
+static void reset_student_control(void *state, struct control *controlData_ptr);
+static void inner_student_control(void *state, double delta_t, struct sensordata *sensorData_ptr, struct control *controlData_ptr);
+static void loops_student_control(const void *state, struct control_loops *loops_ptr);
+static double yaw_damper (struct student_control_state *s, double yawrate);
+static double roll_control (struct student_control_state *s, double phi_ref, double roll_angle, double delta_t);
+static double pitch_control(struct student_control_state *s, double the_ref, double pitch, double delta_t);
 
-// Initialize pitch and roll angle tracking errors, integrators, and anti wind-up operators
-// 0 values correspond to the roll tracker, 1 values correspond to the theta tracker
-static double e[2] = {0,0};
-static double integrator[2] = {0,0};
-static short anti_windup[2]={1,1};   // integrates when anti_windup is 1
+/// Registration in the control law table, see control_laws.c
+const struct control_law student_control_law = {.name = "student_control", .state_size = sizeof(struct student_control_state),
+		.step = get_student_control, .reset = reset_student_control, .inner = inner_student_control, .loops = loops_student_control};
 
 
 
 /// ****************************************************************************************
-/// Yaw rate digital controller - parameters and variables
+/// Initial context: roll tracker and theta tracker loops, PI with a damper on the body rate and clamping anti-windup,
+/// and the yaw damper, a washout filter on the yaw rate, discretized at the inner loop rate on reset
+
+//   y_yaw(z)      b0 + b1*z^(-1)              k_YD*s
+//   --------  =  ----------------  =  c2d( ------------ , INNER_TIMESTEP )
+//   u_yaw(z)      1  + a1*z^(-1)            s + YD_WASHOUT
 
-//   y_yaw(z)      b[0] + b[1]*z^(-1)
-//   --------  =  --------------------
-//   u_yaw(z)      a[0] + a[1]*z^(-1)
+#define YD_GAIN		0.065	// k_YD of Simulation/Controllers/baseline_gains.m
+#define YD_WASHOUT	2.0		// [rad/sec], -a_YD of Simulation/Controllers/baseline_gains.m
 
-static const int k=1; 	//k = the order of the denominator of the Discrete Time Transfer
-				        //function. k is used for calculating current and past time step values
-static double u_yaw[2] = {0,0}; // input of filter { u(k), u(k-1) }
-static double y_yaw[2] = {0,0}; // output of filter { y(k), y(k-1) }
-static double a_yaw[2] = {1.0,-0.9608}; // Filter denominator coefficients
-static double b_yaw[2] = {0.065, -0.065}; // Filter numerator coefficients
+static const struct student_control_state initial_state = {
+	.roll_pi = {.umin = -AILERON_AUTH_MAX, .umax = AILERON_AUTH_MAX},							// roll tracker
+	.pitch_pi = {.umin = -ELEVATOR_AUTH_MAX-ELEVATOR_TRIM, .umax = ELEVATOR_AUTH_MAX-ELEVATOR_TRIM},	// theta tracker
+};
 
 
 /// ****************************************************************************************
 /// Roll and pitch angle digital controller - parameters and variables
-static double roll_gain[3]  = {-0.64,-0.20,-0.07};  // PI gains for roll tracker and roll damper
-static double pitch_gain[3] = {-0.90,-0.30,-0.08};  // PI gains for theta tracker and pitch damper
+static double student_roll_gain[3]  = {-0.64,-0.20,-0.07};  // PI gains for roll tracker and roll damper
+static double student_pitch_gain[3] = {-0.90,-0.30,-0.08};  // PI gains for theta tracker and pitch damper
 
 /// *****************************************************************************************
 
@@ -80,27 +90,50 @@ static double pitch_gain[3] = {-0.90,-0.30,-0.08};  // PI gains for theta tracke
 /// *****************************************************************************************
 /// *****************************************************************************************
 // BEGIN MAIN CONTROL FUNCTION
-extern void get_control(double time, struct sensordata *sensorData_ptr, struct nav *navData_ptr, struct control *controlData_ptr) {
+static void get_student_control(void *state, double time, struct sensordata *sensorData_ptr, struct nav *navData_ptr, struct control *controlData_ptr) {
 /// Return control outputs based on references and feedback signals.
+	struct student_control_state *s = state;
 
 
 	double base_pitch_cmd= 0.0872664;  // (Thor Trim value) use 5 deg (0.0872664 rad) for flight, use 3.082 deg (0.0537910 rad) in sim
 	double phi   = navData_ptr->phi;
 	double theta = navData_ptr->the - base_pitch_cmd; //subtract theta trim value to convert to delta coordinates
+    double phi_cmd = controlData_ptr->phi_cmd;
+    double theta_cmd = controlData_ptr->theta_cmd;
+
+    s->pitch_out = pitch_control(s, theta_cmd, theta, TIMESTEP); // Elevator deflection before the pitch damper [rad]
+    s->roll_out = roll_control(s, phi_cmd, phi, TIMESTEP);    // Roll, before the roll damper [rad]
+
+	// tracking loop signals, for the metrics
+	s->loops.ref[LOOP_ROLL]  = phi_cmd;
+	s->loops.e[LOOP_ROLL]    = phi_cmd - phi;
+	s->loops.ref[LOOP_PITCH] = theta_cmd;
+	s->loops.e[LOOP_PITCH]   = theta_cmd - theta;
+}
+
+/// Inner loop: the dampers on the body rates, at the time step delta_t, and the allocation to the surfaces.
+static void inner_student_control(void *state, double delta_t, struct sensordata *sensorData_ptr, struct control *controlData_ptr) {
+	struct student_control_state *s = state;
 	double p     = sensorData_ptr->imuData_ptr->p; // Roll rate
 	double q     = sensorData_ptr->imuData_ptr->q; // Pitch rate
 	double r     = sensorData_ptr->imuData_ptr->r; // Yaw rate
 
-    double phi_cmd = controlData_ptr->phi_cmd;
-    double theta_cmd = controlData_ptr->theta_cmd;
-
-    controlData_ptr->de = pitch_control(theta_cmd, theta, q, TIMESTEP); // Elevator deflection [rad]
-    controlData_ptr->dr = yaw_damper(r); 								// Rudder deflection [rad]
-    controlData_ptr->da_r = roll_control(phi_cmd, phi, p, TIMESTEP);    // Right Aileron deflection [rad]
-	controlData_ptr->da_l = -controlData_ptr->da_r; 					// Left aileron deflection [rad]
+    controlData_ptr->de = pid_inner(&s->pitch_pi, s->pitch_out, q, delta_t);	// Elevator deflection [rad]
+    controlData_ptr->dr = yaw_damper(s, r); 								// Rudder deflection [rad]
+    controlData_ptr->da_r = pid_inner(&s->roll_pi, s->roll_out, p, delta_t);	// Roll, as right Aileron deflection [rad]
 	controlData_ptr->dthr = 0; // throttle
-	controlData_ptr->df_l = 0; // left flap
-	controlData_ptr->df_r = 0; // right flap
+
+	allocate_controls(controlData_ptr);	// mix to all surfaces, see control_allocation.h
+}
+
+/// Tracking loops: the roll and theta trackers.
+static void loops_student_control(const void *state, struct control_loops *loops_ptr) {
+	const struct student_control_state *s = state;
+
+	*loops_ptr = s->loops;
+	loops_ptr->sat[LOOP_ROLL]  = s->roll_pi.hold;
+	loops_ptr->sat[LOOP_PITCH] = s->pitch_pi.hold;
+	loops_ptr->closed = (1 << LOOP_ROLL) | (1 << LOOP_PITCH);
 }
 // END MAIN CONTROL FUNCTION
 /// *****************************************************************************************
@@ -131,56 +164,21 @@ extern void get_control(double time, struct sensordata *sensorData_ptr, struct n
            |                                   ----------------      |
             ---------------------------------------------------------     */
 
-double yaw_damper (double yawrate)
+static double yaw_damper (struct student_control_state *s, double yawrate)
 {
-// Discrete time filter equation at time step k
-// y_yaw(k) = b0*u(k) + b1*u(k-1) - a1*y(k-1)
-    
-    
-	u_yaw[k] = yawrate;  //current time step input (r)
-
-	// Filter:
-	// y_yaw(k) = b0*u(k) 	+	   b1*u(k-1)   		 + - a1*y(k-1)
-	y_yaw[k] = b_yaw[0]*u_yaw[k] + b_yaw[1]*u_yaw[k-1] - a_yaw[1]*y_yaw[k-1];
-
-	// Update past time step input/output for next frame
-	u_yaw[k-1] = u_yaw[k];
-	y_yaw[k-1] = y_yaw[k];
-
-
-    //Output rudder command
-    dr = y_yaw[k];
-
-
-    // Saturation
-	if (fabs(dr) > RUDDER_AUTH_MAX) {
-		dr = sign(dr)*RUDDER_AUTH_MAX;		// yawdamper authority limited to +/-25 deg
-	}
-	return dr;
+	// rudder from the washed out yaw rate, authority limited to +/-25 deg
+	return saturate(biquad_step(&s->yaw_filter, yawrate), -RUDDER_AUTH_MAX, RUDDER_AUTH_MAX);
 }
 
 
 
-static double roll_control (double phi_ref, double roll_angle, double rollrate, double delta_t)
+static double roll_control (struct student_control_state *s, double phi_ref, double roll_angle, double delta_t)
 {
 	// ROLL tracking controller implemented here
 
-
-	// roll attitude tracker
-	e[0] = phi_ref - roll_angle;
-	integrator[0] += e[0]*delta_t*anti_windup[0]; //roll error integral (rad)
-
-	    //proportional term + integral term              - roll damper term
-	da  = roll_gain[0]*e[0] + roll_gain[1]*integrator[0] - roll_gain[2]*rollrate;
-
-	//eliminate windup
-	if      (da >= AILERON_AUTH_MAX && e[0] > 0) {anti_windup[0] = 1; da = AILERON_AUTH_MAX;}
-	else if (da >= AILERON_AUTH_MAX && e[0] < 0) {anti_windup[0] = 0; da = AILERON_AUTH_MAX;}  //stop integrating
-	else if (da <= -AILERON_AUTH_MAX && e[0] > 0) {anti_windup[0] = 0; da = -AILERON_AUTH_MAX;}  //stop integrating
-	else if (da <= -AILERON_AUTH_MAX && e[0] < 0) {anti_windup[0] = 1; da = -AILERON_AUTH_MAX;}
-	else {anti_windup[0] = 1;}
-
-    return da;
+	// roll attitude tracker: proportional term + integral term, the roll damper term is subtracted in the inner loop
+	pid_gains(&s->roll_pi, student_roll_gain[0], student_roll_gain[1], student_roll_gain[2]);
+	return pid_outer(&s->roll_pi, phi_ref - roll_angle, delta_t);
 }
 
 
@@ -191,7 +189,6 @@ static double roll_control (double phi_ref, double roll_angle, double rollrate,
 
 
 
-
 // Pitch get_control law: angles in radians. Rates in rad/s. Time in seconds
 /*                                                  __________
                    _______________                 |          |  theta
@@ -204,28 +201,21 @@ theta_cmd  _      |               |       _   de   |          |---------
            |                               -------| Pitch Damper |<-    |
            |                                      |______________|      |
             ------------------------------------------------------------     */
-static double pitch_control(double the_ref, double pitch, double pitchrate, double delta_t)
+static double pitch_control(struct student_control_state *s, double the_ref, double pitch, double delta_t)
 {
-	// pitch attitude tracker
-	e[1] = the_ref - pitch;
-	integrator[1] += e[1]*delta_t*anti_windup[1]; //pitch error integral
-
-       // proportional term + integral term               - pitch damper term
-    de = pitch_gain[0]*e[1] + pitch_gain[1]*integrator[1] - pitch_gain[2]*pitchrate;    // Elevator output
-
-	//eliminate wind-up
-	if      (de >= ELEVATOR_AUTH_MAX-ELEVATOR_TRIM && e[1] < 0) {anti_windup[1] = 0; de = ELEVATOR_AUTH_MAX-ELEVATOR_TRIM;}  //stop integrating
-	else if (de >= ELEVATOR_AUTH_MAX-ELEVATOR_TRIM && e[1] > 0) {anti_windup[1] = 1; de = ELEVATOR_AUTH_MAX-ELEVATOR_TRIM;}
-	else if (de <= -ELEVATOR_AUTH_MAX-ELEVATOR_TRIM && e[1] < 0) {anti_windup[1] = 1; de = -ELEVATOR_AUTH_MAX-ELEVATOR_TRIM;}
-	else if (de <= -ELEVATOR_AUTH_MAX-ELEVATOR_TRIM && e[1] > 0) {anti_windup[1] = 0; de = -ELEVATOR_AUTH_MAX-ELEVATOR_TRIM;}  //stop integrating
-	else {anti_windup[1] = 1;}
-
-	return de;  //rad
+	// pitch attitude tracker: proportional term + integral term, the pitch damper term is subtracted in the inner loop
+	pid_gains(&s->pitch_pi, student_pitch_gain[0], student_pitch_gain[1], student_pitch_gain[2]);
+	return pid_outer(&s->pitch_pi, the_ref - pitch, delta_t);  //rad
 }
 
 // Reset of controller
-extern void reset_control(struct control *controlData_ptr){
+static void reset_student_control(void *state, struct control *controlData_ptr){
+	struct student_control_state *s = state;
+
 	// Here: code to reset the controller
+	*s = initial_state;
+	biquad_washout(&s->yaw_filter, YD_GAIN, YD_WASHOUT, INNER_TIMESTEP);
+
 	controlData_ptr->dthr = 0; // throttle
 	controlData_ptr->de   = 0; // elevator
 	controlData_ptr->dr   = 0; // rudder
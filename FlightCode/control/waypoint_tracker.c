@@ -20,6 +20,9 @@
 
 #include "../globaldefs.h"
 #include "control_interface.h"
+#include "control_allocation.h"
+#include "control_blocks.h"
+#include "gain_schedule.h"
 
 
 
@@ -34,40 +37,60 @@
 
 
 
+/// Instance context: the roll tracker, the theta tracker, the altitude tracker and the speed tracker, PI with clamping
+/// anti-windup, the yaw damper, and the heading and altitude snapshots
+struct waypoint_tracker_state {
+	struct pid roll_pi;			///< roll tracker
+	struct pid pitch_pi;		///< theta tracker
+	struct pid alt_pi;			///< altitude tracker, held against the elevator limits of the theta tracker it drives
+	struct pid speed_pi;		///< speed tracker
+	struct biquad yaw_filter;	///< yaw damper
+	struct gain_set gains;		///< scheduled on airspeed and altitude every frame, see gain_schedule.h
+	double psi0;				///< [rad], initial heading
+	double h0;					///< [m], initial altitude
+	double psi_prev;			///< [rad], previous psi measurement
+	int wrapCtr;				///< phase wrapping counter
+	double roll_out;			///< roll tracker output before the roll damper, held over the frame
+	double pitch_out;			///< theta tracker output before the pitch damper, held over the frame
+	double dthr_out;			///< speed tracker output, held over the frame
+	struct control_loops loops;	///< tracking loop signals of the last step, for the metrics
+};
+
 /// Definition of local functions: ****************************************************
-static double yaw_damper (double yawrate);
-static double heading_control (double head_ref, double head_angle, double roll_angle, double rollrate, double delta_t);
-static double altitude_control(double alt_ref, double altitude, double pitch, double pitchrate, double delta_t);
-static double speed_control(double speed_ref, double airspeed, double delta_t);
-static double phase_wrapper(double psi, double psiDelta);
+static void get_waypoint_tracker(void *state, double time, struct sensordata *sensorData_ptr, struct nav *navData_ptr, struct control *controlData_ptr);
+static void reset_waypoint_tracker(void *state, struct control *controlData_ptr);
+static void inner_waypoint_tracker(void *state, double delta_t, struct sensordata *sensorData_ptr, struct control *controlData_ptr);
+static void loops_waypoint_tracker(const void *state, struct control_loops *loops_ptr);
+static double yaw_damper (struct waypoint_tracker_state *s, double yawrate);
+static double pitch_damper(struct waypoint_tracker_state *s, double pitchrate, double delta_t);
+static double heading_control (struct waypoint_tracker_state *s, double head_ref, double head_angle, double roll_angle, double delta_t);
+static double altitude_control(struct waypoint_tracker_state *s, double alt_ref, double altitude, double pitch, double delta_t);
+static double speed_control(struct waypoint_tracker_state *s, double speed_ref, double airspeed, double delta_t);
+static double phase_wrapper(struct waypoint_tracker_state *s, double psi, double psiDelta);
 static double lp_filter(double signal, double *u, double *y); //USE FOR SIL ONLY
 
-// initialize pitch and roll angle tracking errors, integrators, and anti wind-up operators
-// 0 values correspond to the roll tracker, 1 values correspond to the theta tracker, 2 values to altitude tracker, 3 to speed tracker
-static double e[5] = {0,0,0,0,0};
-static double integrator[4] = {0,0,0,0};
-static short anti_windup[4]={1,1,1,1};   // integrates when anti_windup is 1
-/// ****************************************************************************************
-/// Phase wrapper variables
-static int wrapCtr = 0;
-/// ****************************************************************************************
-/// Yaw rate digital controller - parameters and variables
-
-//   y_yaw(z)      b[0] + b[1]*z^(-1)
-//   --------  =  --------------------
-//   u_yaw(z)      a[0] + a[1]*z^(-1)
-
-static const int k=1; 	//k = the order of the denominator of the Discrete Time Transfer
-				        //function. k is used for calculating current and past time step values
-static double u_yaw[2] = {0,0}; // input of filter { u(k), u(k-1) }
-static double y_yaw[2] = {0,0}; // output of filter { y(k), y(k-1) }
-static double a_yaw[2] = {1.0,-0.9608}; // Filter denominator coefficients
-static double b_yaw[2] = {0.065, -0.065}; // Filter numerator coefficients
-static double dr; // Delta rudder
+/// Registration in the control law table, see control_laws.c
+const struct control_law waypoint_tracker_law = {.name = "waypoint_tracker", .state_size = sizeof(struct waypoint_tracker_state),
+		.step = get_waypoint_tracker, .reset = reset_waypoint_tracker, .inner = inner_waypoint_tracker,
+		.loops = loops_waypoint_tracker, .psi_error = 1};	// psi_cmd is the heading error
+
 /// ****************************************************************************************
-static double da; // Delta aileron
-static double de; // Delta elevator
-static double dthr; // Delta throttle
+/// Initial context: loop limits, with the gains set from the gain schedule every frame, and the yaw damper, a
+/// washout filter on the yaw rate, discretized at the inner loop rate on reset
+
+//   y_yaw(z)      b0 + b1*z^(-1)              k_YD*s
+//   --------  =  ----------------  =  c2d( ------------ , INNER_TIMESTEP )
+//   u_yaw(z)      1  + a1*z^(-1)            s + YD_WASHOUT
+
+#define YD_GAIN		0.065	// k_YD of Simulation/Controllers/baseline_gains.m
+#define YD_WASHOUT	2.0		// [rad/sec], -a_YD of Simulation/Controllers/baseline_gains.m
+
+static const struct waypoint_tracker_state initial_state = {
+	.roll_pi = {.umin = -AILERON_AUTH_MAX, .umax = AILERON_AUTH_MAX},							// roll tracker
+	.pitch_pi = {.umin = -ELEVATOR_AUTH_MAX-ELEVATOR_TRIM, .umax = ELEVATOR_AUTH_MAX-ELEVATOR_TRIM},	// theta tracker
+	.alt_pi = {.umin = -ELEVATOR_AUTH_MAX-ELEVATOR_TRIM, .umax = ELEVATOR_AUTH_MAX-ELEVATOR_TRIM},	// altitude tracker
+	.speed_pi = {.umin = THROTTLE_AUTH_MIN-THROTTLE_TRIM, .umax = THROTTLE_AUTH_MAX-THROTTLE_TRIM},	// speed tracker
+};
 
 
 // USE FOR SIL ONLY
@@ -80,16 +103,17 @@ static double y_speed[2] = {0,0}; //output of altitude low pass filter { y(k), y
 
 
 /// Return control outputs based on references and feedback signals.
-extern void get_control(double time, struct sensordata *sensorData_ptr, struct nav *navData_ptr, struct control *controlData_ptr) {
+static void get_waypoint_tracker(void *state, double time, struct sensordata *sensorData_ptr, struct nav *navData_ptr, struct control *controlData_ptr) {
+	struct waypoint_tracker_state *s = state;
 
 	// PLACE OPTIONAL PHI BIAS HERE
 	//navData_ptr->phi += DEG*pi/180;
 	double phi   = navData_ptr->phi;					    // Roll angle
-	double theta = navData_ptr->the - base_pitch_cmd; 	    // Pitch angle: subtract theta trim value to convert to delta coordinates
-	double psi	 = atan2(navData_ptr->ve,navData_ptr->vn);  // Ground Track Heading angle
-	double p     = sensorData_ptr->imuData_ptr->p; 		    // Roll rate
-	double q     = sensorData_ptr->imuData_ptr->q;		    // Pitch rate
-	double r     = sensorData_ptr->imuData_ptr->r; 		    // Yaw rate
+	double theta;
+	double psi	 = navData_ptr->trig.gndtrk;  // Ground Track Heading angle, from the nav trig cache
+
+	get_gain_schedule(sensorData_ptr->adData_ptr->ias_filt, sensorData_ptr->adData_ptr->h_filt, &s->gains);
+	theta = navData_ptr->the - s->gains.base_pitch; // Pitch angle: subtract theta trim value to convert to delta coordinates
 
 
     // Filter altitude and airspeed signals USE FOR SIL ONLY
@@ -98,34 +122,62 @@ extern void get_control(double time, struct sensordata *sensorData_ptr, struct n
     
     // Snapshots
 	if(time <= 50*TIMESTEP){
-		controlData_ptr->signal_1 = psi;  // store initial HEADING on dummy variable signal_1
-		controlData_ptr->signal_0 = sensorData_ptr->adData_ptr->h_filt;   	// store initial ALTITUDE on dummy variable signal_0
+		s->psi0 = psi;								// store initial HEADING
+		s->h0 = sensorData_ptr->adData_ptr->h_filt;	// store initial ALTITUDE
 	}
 
 	// Phase wrap
-	controlData_ptr->signal_2 = phase_wrapper(psi, controlData_ptr->signal_3 - psi);		// Store the wrapped psi value
-	controlData_ptr->signal_3 = psi;
-    controlData_ptr->de   = altitude_control(controlData_ptr->h_cmd, sensorData_ptr->adData_ptr->h_filt - controlData_ptr->signal_0, theta, q, TIMESTEP);
-    controlData_ptr->dr   = yaw_damper(r);
-    controlData_ptr->da_r = heading_control(controlData_ptr->psi_cmd, 0, phi, p, TIMESTEP);  // heading angle error given as command
-	controlData_ptr->da_l = -controlData_ptr->da_r;
-	controlData_ptr->dthr = speed_control(controlData_ptr->ias_cmd, sensorData_ptr->adData_ptr->ias_filt, TIMESTEP);
-	controlData_ptr->df_l = 0;
-	controlData_ptr->df_r = 0;
+	controlData_ptr->signal_2 = phase_wrapper(s, psi, s->psi_prev - psi);		// Store the wrapped psi value
+	s->psi_prev = psi;
+
+	// Snapshots and previous psi on dummy variables, for logging
+	controlData_ptr->signal_0 = s->h0;
+	controlData_ptr->signal_1 = s->psi0;
+	controlData_ptr->signal_3 = s->psi_prev;
+    s->pitch_out = altitude_control(s, controlData_ptr->h_cmd, sensorData_ptr->adData_ptr->h_filt - s->h0, theta, TIMESTEP);
+    s->roll_out  = heading_control(s, controlData_ptr->psi_cmd, 0, phi, TIMESTEP);  // heading angle error given as command
+	s->dthr_out = speed_control(s, controlData_ptr->ias_cmd, sensorData_ptr->adData_ptr->ias_filt, TIMESTEP);
+}
+
+/// Inner loop: the dampers on the body rates, at the time step delta_t, and the allocation to the surfaces.
+static void inner_waypoint_tracker(void *state, double delta_t, struct sensordata *sensorData_ptr, struct control *controlData_ptr) {
+	struct waypoint_tracker_state *s = state;
+	double p     = sensorData_ptr->imuData_ptr->p; 		    // Roll rate
+	double q     = sensorData_ptr->imuData_ptr->q;		    // Pitch rate
+	double r     = sensorData_ptr->imuData_ptr->r; 		    // Yaw rate
+
+    controlData_ptr->de   = pitch_damper(s, q, delta_t);
+    controlData_ptr->dr   = yaw_damper(s, r);
+    controlData_ptr->da_r = pid_inner(&s->roll_pi, s->roll_out, p, delta_t);
+	controlData_ptr->dthr = s->dthr_out;
+
+	allocate_controls(controlData_ptr);	// mix to all surfaces, see control_allocation.h
+}
+
+/// Tracking loops: the heading, altitude and speed trackers, and the roll and theta trackers they drive.
+static void loops_waypoint_tracker(const void *state, struct control_loops *loops_ptr) {
+	const struct waypoint_tracker_state *s = state;
+
+	*loops_ptr = s->loops;
+	loops_ptr->sat[LOOP_ROLL]     = s->roll_pi.hold;
+	loops_ptr->sat[LOOP_PITCH]    = s->pitch_pi.hold;
+	loops_ptr->sat[LOOP_ALTITUDE] = s->alt_pi.hold;
+	loops_ptr->sat[LOOP_SPEED]    = s->speed_pi.hold;
+	loops_ptr->closed = (1 << LOOP_N) - 1;
 }
 
 // PhaseWrap code to calculate actual heading angle
-double phase_wrapper(double psi, double psiDelta)
+static double phase_wrapper(struct waypoint_tracker_state *s, double psi, double psiDelta)
 {
 		 double psiActual;
 
 		 if(psiDelta > 3.14159){		//passing from quadrant two to three
-			wrapCtr++;
+			s->wrapCtr++;
 		 }
 		 if(psiDelta < -3.14159){		//passing from quadrant three to two
-			wrapCtr--;
+			s->wrapCtr--;
 		 }
-		 psiActual = psi + wrapCtr*2*3.1415926;
+		 psiActual = psi + s->wrapCtr*2*3.1415926;
 		 return psiActual;
 }
 
@@ -145,131 +197,80 @@ double lp_filter(double signal, double *u, double *y)
 }
 
 
-// Discrete time filter equation at time step k
-// y_yaw(k) = b0*u(k) + b1*u(k-1) - a1*y(k-1)
-
-double yaw_damper (double yawrate)
+static double yaw_damper (struct waypoint_tracker_state *s, double yawrate)
 {
-
-	u_yaw[k] = yawrate;  //current time step input (r)
-
-	// Filter:
-	// y_yaw(k) = b0*u(k) 	+	   b1*u(k-1)   		 + - a1*y(k-1)
-	y_yaw[k] = b_yaw[0]*u_yaw[k] + b_yaw[1]*u_yaw[k-1] - a_yaw[1]*y_yaw[k-1];
-
-	// Update past time step input/output for next frame
-	u_yaw[k-1] = u_yaw[k];
-	y_yaw[k-1] = y_yaw[k];
+	// rudder from the washed out yaw rate, authority limited to +/-25 deg
+	return saturate(biquad_step(&s->yaw_filter, yawrate), -RUDDER_AUTH_MAX, RUDDER_AUTH_MAX);
+}
 
 
-    //Output rudder command
-    dr = y_yaw[k];
+static double pitch_damper(struct waypoint_tracker_state *s, double pitchrate, double delta_t)
+{
+	// theta tracker output - pitch damper term
+	double de = s->pitch_out - s->pitch_pi.kd*pitchrate;
 
-    // Saturation
-	if (fabs(dr) > RUDDER_AUTH_MAX) {
-		dr = sign(dr)*RUDDER_AUTH_MAX;		// yawdamper authority limited to +/-25 deg
-	}
-	return dr;
+	// eliminate wind-up on the altitude integral and the theta integral
+	pid_antiwindup(&s->alt_pi, s->alt_pi.e, de, delta_t);
+	return pid_antiwindup(&s->pitch_pi, s->pitch_pi.e, de, delta_t);  //rad
 }
 
 
-static double heading_control (double head_ref, double head_angle, double roll_angle, double rollrate, double delta_t)
+static double heading_control (struct waypoint_tracker_state *s, double head_ref, double head_angle, double roll_angle, double delta_t)
 {
 	// Heading tracking controller implemented here
 	double roll_limit = 45*D2R; // Roll angle saturation limit (45 degrees)
-	double head_out;
-
-	e[4] = head_ref - head_angle;
-	head_out = head_gain*e[4];
-
-	if	(fabs(head_out) >= roll_limit){
-		head_out = sign(head_out)*roll_limit;
-	}
-
-	// roll attitude tracker
-	e[0] = head_out - roll_angle;
-	integrator[0] += e[0]*delta_t*anti_windup[0]; //roll error integral (rad)
-
-	    //proportional term + integral term              - roll damper term
-	da  = roll_gain[0]*e[0] + roll_gain[1]*integrator[0] - roll_gain[2]*rollrate;
+	double head_out = saturate(s->gains.head*(head_ref - head_angle), -roll_limit, roll_limit);
 
-	//eliminate windup
-	if      (da >= AILERON_AUTH_MAX && e[0] > 0) {anti_windup[0] = 1; da = AILERON_AUTH_MAX;}
-	else if (da >= AILERON_AUTH_MAX && e[0] < 0) {anti_windup[0] = 0; da = AILERON_AUTH_MAX;}    //stop integrating
-	else if (da <= -AILERON_AUTH_MAX && e[0] > 0) {anti_windup[0] = 0; da = -AILERON_AUTH_MAX;}  //stop integrating
-	else if (da <= -AILERON_AUTH_MAX && e[0] < 0) {anti_windup[0] = 1; da = -AILERON_AUTH_MAX;}
-	else {anti_windup[0] = 1;}
+	s->loops.ref[LOOP_HEADING] = head_ref;
+	s->loops.e[LOOP_HEADING]   = head_ref - head_angle;
+	s->loops.sat[LOOP_HEADING] = (fabs(head_out) >= roll_limit);	// at the bank angle limit
+	s->loops.ref[LOOP_ROLL]    = head_out;
+	s->loops.e[LOOP_ROLL]      = head_out - roll_angle;
 
-    return da;
+	// roll attitude tracker: proportional term + integral term, the roll damper term is subtracted in the inner loop
+	pid_gains(&s->roll_pi, s->gains.roll[0], s->gains.roll[1], s->gains.roll[2]);
+	return pid_outer(&s->roll_pi, head_out - roll_angle, delta_t);
 }
 
 
-static double altitude_control(double alt_ref, double altitude, double pitch, double pitchrate, double delta_t)
+static double altitude_control(struct waypoint_tracker_state *s, double alt_ref, double altitude, double pitch, double delta_t)
 {
 	double pitch_limit = 0.349066; // Pitch angle saturation limit (20 degrees)
+	double e_alt = alt_ref - altitude;
 	double h_out;
 
-	// Altitude tracker
-	e[2] = alt_ref - altitude;
-	integrator[2] += e[2]*delta_t*anti_windup[2]; // altitude error integral
+	// Altitude tracker: proportional term + integral term
+	pid_gains(&s->alt_pi, s->gains.alt[0], s->gains.alt[1], 0);
+	h_out = saturate(pid_outer(&s->alt_pi, e_alt, delta_t), -pitch_limit, pitch_limit);
 
-		//	proportional term + integral term   (output of altitude PI block)
-	h_out = alt_gain[0]*e[2] + alt_gain[1]*integrator[2];
+	s->loops.ref[LOOP_ALTITUDE] = alt_ref;
+	s->loops.e[LOOP_ALTITUDE]   = e_alt;
+	s->loops.ref[LOOP_PITCH]    = h_out;
+	s->loops.e[LOOP_PITCH]      = h_out - pitch;
 
-	if	(abs(h_out) >= pitch_limit){
-		h_out = sign(h_out)*pitch_limit;
-	}
-
-	// pitch attitude tracker
-	e[1] = h_out - pitch;
-	integrator[1] += e[1]*delta_t*anti_windup[1]; //pitch error integral
-
-       //proportional term + integral term               - pitch damper term
-    de = pitch_gain[0]*e[1] + pitch_gain[1]*integrator[1] - pitch_gain[2]*pitchrate;    // Elevator output
-
-	//eliminate wind-up on theta integral
-	if      (de >= ELEVATOR_AUTH_MAX-ELEVATOR_TRIM && e[1] < 0) {anti_windup[1] = 0; de = ELEVATOR_AUTH_MAX-ELEVATOR_TRIM;}  //stop integrating
-	else if (de >= ELEVATOR_AUTH_MAX-ELEVATOR_TRIM && e[1] > 0) {anti_windup[1] = 1; de = ELEVATOR_AUTH_MAX-ELEVATOR_TRIM;}
-	else if (de <= -ELEVATOR_AUTH_MAX-ELEVATOR_TRIM && e[1] < 0) {anti_windup[1] = 1; de = -ELEVATOR_AUTH_MAX-ELEVATOR_TRIM;}
-	else if (de <= -ELEVATOR_AUTH_MAX-ELEVATOR_TRIM && e[1] > 0) {anti_windup[1] = 0; de = -ELEVATOR_AUTH_MAX-ELEVATOR_TRIM;}  //stop integrating
-	else {anti_windup[1] = 1;}
-
-	//eliminate wind-up on altitude integral
-	if      (de >= ELEVATOR_AUTH_MAX-ELEVATOR_TRIM && e[2] < 0) {anti_windup[2] = 1;}
-	else if (de >= ELEVATOR_AUTH_MAX-ELEVATOR_TRIM && e[2] > 0) {anti_windup[2] = 0;}  //stop integrating
-	else if (de <= -ELEVATOR_AUTH_MAX-ELEVATOR_TRIM && e[2] < 0) {anti_windup[2] = 0;}  //stop integrating
-	else if (de <= -ELEVATOR_AUTH_MAX-ELEVATOR_TRIM && e[2] > 0) {anti_windup[2] = 1;}
-	else {anti_windup[2] = 1;}
-
-	return de;  //rad
+	// pitch attitude tracker: proportional term + integral term, the pitch damper term is subtracted in the inner
+	// loop, which also holds the altitude and theta integrals against the elevator limits
+	pid_gains(&s->pitch_pi, s->gains.pitch[0], s->gains.pitch[1], s->gains.pitch[2]);
+	return pid_outer(&s->pitch_pi, h_out - pitch, delta_t);  //rad
 }
 
-static double speed_control(double speed_ref, double airspeed, double delta_t)
+static double speed_control(struct waypoint_tracker_state *s, double speed_ref, double airspeed, double delta_t)
 {
-	// Speed tracker
-	e[3] = speed_ref - airspeed;
-	integrator[3] += e[3]*delta_t*anti_windup[3]; // altitude error integral
-
-		// proportional term  + integral term
-	dthr = v_gain[0]*e[3] + v_gain[1]*integrator[3];    // Throttle output
-
-	//eliminate wind-up on airspeed integral
-	if      (dthr >= THROTTLE_AUTH_MAX-THROTTLE_TRIM && e[3] < 0) {anti_windup[3] = 1; dthr = THROTTLE_AUTH_MAX-THROTTLE_TRIM;}
-	else if (dthr >= THROTTLE_AUTH_MAX-THROTTLE_TRIM && e[3] > 0) {anti_windup[3] = 0; dthr = THROTTLE_AUTH_MAX-THROTTLE_TRIM;}  //stop integrating
-	else if (dthr <= THROTTLE_AUTH_MIN-THROTTLE_TRIM && e[3] < 0) {anti_windup[3] = 0; dthr = THROTTLE_AUTH_MIN-THROTTLE_TRIM;}  //stop integrating
-	else if (dthr <= THROTTLE_AUTH_MIN-THROTTLE_TRIM && e[3] > 0) {anti_windup[3] = 1; dthr = THROTTLE_AUTH_MIN-THROTTLE_TRIM;}
-	else {anti_windup[3] = 1;}
+	s->loops.ref[LOOP_SPEED] = speed_ref;
+	s->loops.e[LOOP_SPEED]   = speed_ref - airspeed;
 
-	return dthr; // non dimensional
+	// Speed tracker: proportional term + integral term
+	pid_gains(&s->speed_pi, s->gains.v[0], s->gains.v[1], 0);
+	return pid_step(&s->speed_pi, speed_ref - airspeed, 0, delta_t); // non dimensional
 }
 
+
 // Reset parameters to initial values
-extern void reset_control(struct control *controlData_ptr){
+static void reset_waypoint_tracker(void *state, struct control *controlData_ptr){
+	struct waypoint_tracker_state *s = state;
 
-	integrator[0] = integrator[1] = integrator[2] = integrator[3] = 0;
-	anti_windup[0] = anti_windup[1] = anti_windup[2] = anti_windup[3] = 1;
-	e[0] = e[1] = e[2] = e[3] = e[4] = 0;
-	u_yaw[0] = u_yaw[1] = y_yaw[0] = y_yaw[1] = 0;
+	*s = initial_state;			 // loops, snapshots and phase wrapping counter
+	biquad_washout(&s->yaw_filter, YD_GAIN, YD_WASHOUT, INNER_TIMESTEP);
 
 	controlData_ptr->dthr = 0; // throttle
 	controlData_ptr->de   = 0; // elevator
@@ -285,8 +286,6 @@ extern void reset_control(struct control *controlData_ptr){
 	controlData_ptr->signal_2 = 0; 	 // wrapped psi
 	controlData_ptr->signal_3 = 0;  // previous psi measurement
 
-	wrapCtr = 0;					 // phase wrapping counter
-
 	controlData_ptr->psi_cmd = 0; 	 // psi command
 	controlData_ptr->h_cmd = 0;		 // altitude command
 
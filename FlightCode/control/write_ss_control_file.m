@@ -0,0 +1,46 @@
+function write_ss_control_file(filename,A,B,C,D,Ts)
+% Write the matrices of a discrete state space controller for ss_control.c
+%
+%   x[k+1] = A*x[k] + B*u[k]
+%     y[k] = C*x[k] + D*u[k]
+%
+% in the signal layout of ss_control.h: x with 2 states, u = [theta_cmd,
+% theta, q, phi_cmd, phi, p, r], y = [de, da, dr]. Ts is the sample time,
+% which must match TIMESTEP of the flight code.
+%
+% The LQI design of lqr_control.mdl, with K_pitch and K_roll from
+% Simulation/SIL_Sim/setup.m:
+%
+%   A = eye(2);
+%   B = Ts*[1 -1 0 0 0 0 0; 0 0 0 1 -1 0 0];
+%   C = [K_pitch(1) 0; 0 K_roll(1,1); 0 K_roll(2,1)];
+%   D = [0 K_pitch(3) K_pitch(2) 0 0 0 0;
+%        0 0 0 0 K_roll(1,4) K_roll(1,2) K_roll(1,3);
+%        0 0 0 0 K_roll(2,4) K_roll(2,2) K_roll(2,3)];
+%   write_ss_control_file('ss_control.txt',A,B,C,D,0.02)
+%
+% $Id$
+
+if ~isequal(size(A),[2 2]) || ~isequal(size(B),[2 7]) || ~isequal(size(C),[3 2]) || ~isequal(size(D),[3 7])
+    error('write_ss_control_file: matrices do not match the signal layout of ss_control.h');
+end
+
+fid = fopen(filename,'w');
+
+fprintf(fid,'# State space controller for ss_control.c (see ss_control.h), written by write_ss_control_file.m\n');
+fprintf(fid,'# Autogenerated on %s\n',datestr(now));
+fprintf(fid,'# x = [integral of theta error, integral of phi error]\n');
+fprintf(fid,'# u = [theta_cmd, theta, q, phi_cmd, phi, p, r], y = [de, da, dr]\n');
+fprintf(fid,'timestep %.10g\n',Ts);
+
+names = 'ABCD';
+M = {A,B,C,D};
+for k = 1:4
+    for i = 1:size(M{k},1)
+        fprintf(fid,'%c',names(k));
+        fprintf(fid,'\t%.15g',M{k}(i,:));
+        fprintf(fid,'\n');
+    end
+end
+
+fclose(fid);
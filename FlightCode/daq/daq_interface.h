@@ -13,5 +13,15 @@
 
 // Functions that are called to handle messages between FMU and BBB
 
+struct sensordata;
+
+/// Wait for the next IMU message from the FMU and update the body rates in sensorData, for the inner loop rate group.
+/*!
+ * Called INNER_LOOP_STEPS-1 times per frame, between the frames the full sensor set is read in, when the inner loop
+ * runs faster than the base rate.
+ * \sa get_inner_control()
+ */
+extern void get_imu_rates(struct sensordata *sensorData_ptr	///< pointer to sensorData structure
+);
 
 #endif /* SOURCE_DAQ_DAQ_INTERFACE_H_ */
@@ -16,6 +16,10 @@
 
 // ******  Thread Settings *****************************************************
 #define TIMESTEP 0.02 ///< Base time step, needed for control laws */
+#ifndef INNER_LOOP_STEPS
+	#define INNER_LOOP_STEPS 1 ///< Inner loop steps per base time step: the rate dampers and actuator output run at INNER_LOOP_STEPS/TIMESTEP Hz */
+#endif
+#define INNER_TIMESTEP (TIMESTEP/INNER_LOOP_STEPS) ///< Inner loop time step, needed for control laws */
 // *****************************************************************************
 
 // ****** Unit conversions and constant definitions: ***************************
@@ -36,8 +40,8 @@
 #endif
 // *****************************************************************************
 
-//****** NEED TO BE UPDATED BEFORE EVERY FLIGHT FOR DAY AND LOCATION ***********
-// Resourse for local magnetic field: http://www.ngdc.noaa.gov/geomag-web/#igrfwmm
+//****** FALLBACK UNTIL THE ONBOARD MAGNETIC MODEL IS VALID (see navigation/mag_model.c) ******
+// Used before GPS lock. Resourse for local magnetic field: http://www.ngdc.noaa.gov/geomag-web/#igrfwmm
 #define		hn_x	0.174935	// X componenet of magnetometer vector in NED frame from the NOAA > NESDIS > NGDC > Geomagnetism Magnetic Field Calculators using the IGRF 11 Model for location and date being tested
 #define		hn_y	0.001217	// Y componenet of magnetometer vector in NED frame from the NOAA > NESDIS > NGDC > Geomagnetism Magnetic Field Calculators using the IGRF 11 Model for location and date being tested
 #define		hn_z	0.526664	// Z componenet of magnetometer vector in NED frame from the NOAA > NESDIS > NGDC > Geomagnetism Magnetic Field Calculators using the IGRF 11 Model for location and date being tested
@@ -62,6 +66,13 @@ enum   errdefs	{
 	MU_ahrs				///< NAV filter, AHRS Measurement Update //10
 	};
 
+/// Define nav filter health enum list, set by the nav health monitor
+enum   navhealthdefs {
+	nav_healthy,		///< GPS innovations consistent with their covariance //0
+	nav_suspect,		///< Windowed NIS above the warning bound //1
+	nav_diverged		///< Windowed NIS above the divergence bound, filter excluded from blending //2
+	};
+
 /// IMU Data Structure
 struct imu {
 	double p;				///< [rad/sec], body X axis angular rate (roll)
@@ -256,6 +267,31 @@ struct ahrsdr {
 	double gpsmu_innov[6];			///< Innovation from GPS measurement update
 };
 
+/// Trig terms of the blended NAV solution, computed once per frame by update_nav_trig()
+struct navtrig {
+	double sphi;			///< sin(phi)
+	double cphi;			///< cos(phi)
+	double sthe;			///< sin(theta)
+	double cthe;			///< cos(theta)
+	double spsi;			///< sin(psi)
+	double cpsi;			///< cos(psi)
+	double slat;			///< sin(lat)
+	double clat;			///< cos(lat)
+	double slon;			///< sin(lon)
+	double clon;			///< cos(lon)
+	double gndtrk;			///< [rad], ground track angle, atan2(ve, vn)
+	double gndspd;			///< [m/sec], horizontal ground speed
+};
+
+/// Local tangent plane position, maintained by update_nav_ltp()
+struct navltp {
+	double lat0;			///< [rad], geodetic latitude of the latched origin
+	double lon0;			///< [rad], longitude of the latched origin
+	double alt0;			///< [m], altitude of the latched origin
+	double pos_ned[3];		///< [m], NED position relative to the origin, in the origin's tangent plane
+	unsigned short valid;	///< [bool], flag set once an origin has been latched
+};
+
 /// Blended Navigation Filter Data Structure (Optimally blends GPS-aided INS and AHRS-DR solutions)
 struct nav {
 	double lat;					///< [rad], geodetic latitude estimate
@@ -267,16 +303,34 @@ struct nav {
 	double phi;					///< [rad], Euler roll angle estimate
 	double the;					///< [rad], Euler pitch angle estimate
 	double psi;					///< [rad], Euler yaw angle estimate
+	double quat[4];				///< Quaternions estimate, held from the transition while the AHRS/DR carries all of the attitude weight
 	double gb[3];				///< [rad/sec], rate gyro bias estimate
 	double ab[3];					///< [m/sec^2], accelerometer bias estimate
 	double ahrsdr_att_weight;	///< Fraction of weight put on AHRS/DR attitude solution during blending
 	double insgps_att_weight;	///< Fraction of weight put on GPS-aided INS attitude solution during blending
 	double ahrsdr_pos_weight;	///< Fraction of weight put on AHRS/DR position and velocity solution during blending
 	double insgps_pos_weight;	///< Fraction of weight put on GPS-aided INS position and velocity solution during blending
+	double insgps_nis;			///< Windowed average normalized innovation squared of the GPS-aided INS filter
+	double ahrsdr_nis;			///< Windowed average normalized innovation squared of the DR filter
+	enum navhealthdefs insgps_health;	///< GPS-aided INS filter health
+	enum navhealthdefs ahrsdr_health;	///< DR filter health
+	struct navtrig trig;		///< Trig terms of this solution, valid after update_nav_trig()
+	struct navltp ltp;			///< NED position relative to the origin latched at autopilot engage
+	double wind[3];				///< [m/sec], NED wind estimate from the DR filter, held while the DR filter is excluded
 	enum errdefs err_type;		///< Blending filter status
 	double time;				///< [sec], timestamp of NAV filter
 };
 
+/// Magnetic field reference data structure
+struct magfield {
+	double hn[3];			///< [Gauss], NED Earth magnetic field from the onboard model
+	double dec;				///< [rad], magnetic declination
+	double lat;				///< [rad], geodetic latitude of the last evaluation
+	double lon;				///< [rad], longitude of the last evaluation
+	double alt;				///< [m], altitude of the last evaluation
+	unsigned short valid;	///< [bool], flag set once the field has been evaluated
+};
+
 /// Combined sensor data structure
 struct sensordata {
 	struct imu *imuData_ptr; 		///< pointer to imu data structure
@@ -285,6 +339,7 @@ struct sensordata {
 	struct gps *gpsData_r_ptr;		///< pointer to right gps data structure
 	struct airdata *adData_ptr;		///< pointer to airdata data structure
 	struct surface *surfData_ptr;	///< pointer to surface data structure
+	struct magfield *magData_ptr;	///< pointer to magnetic field reference structure
 };
 
 /// Datalogging data structure
@@ -350,6 +405,11 @@ struct datalog {
 	static double roll_gain[3]  = {-0.52,-0.20,-0.07};  // PI gains for roll tracker and roll damper
 	static double pitch_gain[3] = {-0.84,-0.23,-0.08};  // PI gains for theta tracker and pitch damper
 	double base_pitch_cmd= 0.0907;  // (Faser Trim value) use 5 deg (0.0872664  rad) for flight, use 4.669 deg (0.0814990 rad) in sim
+	// the HIL model is the UltraStick120 airframe of Faser (trims in hil_config.h from faser_flight01), so the outer
+	// loops use the Faser gains, as the roll and pitch loops above do
+	static double alt_gain[2] 	= {0.021,0.0017};		// PI gains for altitude tracker
+	static double v_gain[2] 	= {0.091, 0.020};		// PI gains for speed tracker
+	static double head_gain 	= 1.2;					// P gain for heading tracker
 #endif
 
 #endif /* SOURCE_GLOBALDEFS_H_ */
@@ -0,0 +1,414 @@
+/*! \file geofence.c
+ *	\brief Geofence with a grid index
+ *
+ *	\details Polygon loading, grid index and return to home override, see geofence.h.
+ *	\ingroup guidance_fcns
+ *
+ * \author University of Minnesota
+ * \author Aerospace Engineering and Mechanics
+ * \copyright Copyright 2015 Regents of the University of Minnesota. All rights reserved.
+ *
+ * $Id$
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+
+#include "../globaldefs.h"
+#include "../utils/matrix.h"
+#include "../navigation/nav_functions.h"
+#include "../control/control_interface.h"
+#include "../utils/misc.h"
+#include "geofence.h"
+
+/// One fence polygon; its vertices are first .. first+num-1 of the vertex table
+struct fence_polygon {
+	enum geofence_kind kind;
+	double alt_min, alt_max;	// [m], altitude band
+	int first, num;
+};
+
+static struct fence_polygon poly[GEOFENCE_MAX_POLYGONS];
+static int num_poly = 0, num_incl = 0;
+
+// vertices, North/East in the fence frame; edge k runs from vertex k to vertex edge_end[k]
+static double vn[GEOFENCE_MAX_VERTICES], ve[GEOFENCE_MAX_VERTICES];
+static int edge_end[GEOFENCE_MAX_VERTICES], edge_poly[GEOFENCE_MAX_VERTICES];
+static int num_vert = 0;
+
+// fence frame: flat-earth projection about the first vertex
+static double lat0, lon0, scale_n, scale_e;
+
+static int last_breach = 0;	// breach on the last check, to report a breach without return to home once
+
+// grid index: edges of cell c are refs[cell_start[c] .. cell_start[c+1]-1]
+static double n_min, e_min, cell, inv_cell;
+static int cell_start[GEOFENCE_GRID*GEOFENCE_GRID + 1];
+static int refs[GEOFENCE_MAX_REFS];
+static uint64_t center_mask[GEOFENCE_GRID*GEOFENCE_GRID];	// bit i set if polygon i contains the cell center
+
+// local functions
+static int load_geofence(const char *filename);
+static int build_index(void);
+static int seg_in_rect(double n0, double e0, double n1, double e1, double nlo, double elo, double nhi, double ehi);
+static int contains(int p, double n, double e);
+static int crosses(double an, double ae, double bn, double be, double cn, double ce, double dn, double de);
+static double seg_dist2(int k, double n, double e);
+static void check(double n, double e, double alt, struct geofence_status *status);
+
+int init_geofence(void){
+	char msg[96];
+
+	num_poly = num_incl = num_vert = 0;
+
+	if (load_geofence(GEOFENCE_FILE) == 0)
+		return 0;
+
+	if (build_index() == 0){
+		snprintf(msg, sizeof(msg), "geofence: %s has too many edges for the grid index, fence disabled", GEOFENCE_FILE);
+		send_status(msg);
+		num_poly = 0;
+	}
+
+	return num_poly;
+}
+
+void get_geofence(struct nav *navData_ptr, struct control *controlData_ptr, struct geofence_status *status){
+	struct fence_polygon *p;
+	double n, e, dlon, bearing, dpsi;
+
+	if (num_poly == 0){
+		status->breach = 0;
+		status->poly = -1;
+		status->dist = status->dalt = -1.0;
+		return;
+	}
+
+	// aircraft in the fence frame
+	dlon = navData_ptr->lon - lon0;
+	if (dlon > PI) dlon -= PI2;
+	else if (dlon < -PI) dlon += PI2;
+	n = (navData_ptr->lat - lat0)*scale_n;
+	e = dlon*scale_e;
+
+	check(n, e, navData_ptr->alt, status);
+
+	// the bearing home is given as a heading error, so only a law of that convention can fly it
+	if (status->breach && !status->rth){
+		if (get_control_psi_error())
+			status->rth = 1;
+		else if (!last_breach)
+			send_status("geofence: breach, no return to home with the active control law");
+	}
+	last_breach = status->breach;
+	if (!status->rth || !navData_ptr->ltp.valid)
+		return;
+
+	// return to the engage point
+	bearing = atan2(-navData_ptr->ltp.pos_ned[1], -navData_ptr->ltp.pos_ned[0]);
+	dpsi = bearing - navData_ptr->trig.gndtrk;
+	if (dpsi > PI) dpsi -= PI2;
+	else if (dpsi < -PI) dpsi += PI2;
+
+	controlData_ptr->gndtrk_cmd = bearing;
+	controlData_ptr->psi_cmd = dpsi;
+
+	// back into the altitude band of the inclusion volume being left
+	if (status->breach && status->poly >= 0){
+		p = &poly[status->poly];
+		if (p->kind == GEOFENCE_INCLUDE){
+			if (navData_ptr->alt < p->alt_min)
+				controlData_ptr->h_cmd = p->alt_min - navData_ptr->ltp.alt0;
+			else if (navData_ptr->alt > p->alt_max)
+				controlData_ptr->h_cmd = p->alt_max - navData_ptr->ltp.alt0;
+		}
+	}
+}
+
+/// Containment, breach and distances at fence frame point (n, e).
+static void check(double n, double e, double alt, struct geofence_status *status){
+	struct fence_polygon *p;
+	uint64_t mask = 0;
+	double cn, ce, d2, best2, lim, dalt;
+	int ci, cj, c, k, r, i, j, included, excluded;
+
+	ci = (int)floor((n - n_min)*inv_cell);
+	cj = (int)floor((e - e_min)*inv_cell);
+
+	// containment: parity of the cell center, toggled by every edge between the center and the point
+	if (ci >= 0 && ci < GEOFENCE_GRID && cj >= 0 && cj < GEOFENCE_GRID){
+		c = ci*GEOFENCE_GRID + cj;
+		cn = n_min + (ci + 0.5)*cell;
+		ce = e_min + (cj + 0.5)*cell;
+		mask = center_mask[c];
+		for (r = cell_start[c]; r < cell_start[c+1]; r++){
+			k = refs[r];
+			if (crosses(vn[k], ve[k], vn[edge_end[k]], ve[edge_end[k]], cn, ce, n, e))
+				mask ^= (uint64_t)1 << edge_poly[k];
+		}
+	}
+
+	// nearest edge: search rings of cells around the (clamped) cell until no closer edge can remain
+	if (ci < 0) ci = 0; else if (ci >= GEOFENCE_GRID) ci = GEOFENCE_GRID - 1;
+	if (cj < 0) cj = 0; else if (cj >= GEOFENCE_GRID) cj = GEOFENCE_GRID - 1;
+	best2 = 1e30;
+	for (k = 0; k < GEOFENCE_GRID; k++){
+		for (i = ci - k; i <= ci + k; i++){
+			if (i < 0 || i >= GEOFENCE_GRID) continue;
+			for (j = cj - k; j <= cj + k; j += (i == ci - k || i == ci + k) ? 1 : 2*k){
+				if (j < 0 || j >= GEOFENCE_GRID) continue;
+				c = i*GEOFENCE_GRID + j;
+				for (r = cell_start[c]; r < cell_start[c+1]; r++){
+					d2 = seg_dist2(refs[r], n, e);
+					if (d2 < best2) best2 = d2;
+				}
+			}
+		}
+		lim = k*cell;
+		if (best2 <= lim*lim)
+			break;
+	}
+	status->dist = sqrt(best2);
+
+	// volumes
+	included = (num_incl == 0);
+	excluded = 0;
+	status->poly = -1;
+	status->dalt = -1.0;
+	for (i = 0; i < num_poly; i++){
+		if (!(mask & ((uint64_t)1 << i)))
+			continue;
+		p = &poly[i];
+
+		dalt = fabs(alt - p->alt_min);
+		if (fabs(p->alt_max - alt) < dalt) dalt = fabs(p->alt_max - alt);
+		if (status->dalt < 0.0 || dalt < status->dalt) status->dalt = dalt;
+
+		if (alt >= p->alt_min && alt <= p->alt_max){
+			if (p->kind == GEOFENCE_INCLUDE)
+				included = 1;
+			else if (!excluded){
+				excluded = 1;
+				status->poly = i;
+			}
+		}
+		else if (p->kind == GEOFENCE_INCLUDE && status->poly < 0)
+			status->poly = i;	// inside horizontally, outside the band
+	}
+
+	status->breach = excluded || !included;
+	if (!status->breach)
+		status->poly = -1;
+}
+
+/// Read the fence file. Returns the number of polygons loaded.
+static int load_geofence(const char *filename){
+	FILE *fp;
+	char line[128], kind[16];
+	double lat, lon, amin, amax, Rn, slat;
+	int i;
+
+	if ((fp = fopen(filename, "r")) == NULL)
+		return 0;
+
+	while (fgets(line, sizeof(line), fp) != NULL){
+		if (sscanf(line, "polygon %15s %lf %lf", kind, &amin, &amax) == 3){
+			if (num_poly > 0 && poly[num_poly-1].num < 3){
+				num_vert = poly[num_poly-1].first;	// drop a degenerate polygon
+				num_poly--;
+			}
+			if (num_poly == GEOFENCE_MAX_POLYGONS)
+				break;
+			poly[num_poly].kind = (strcmp(kind, "exclude") == 0) ? GEOFENCE_EXCLUDE : GEOFENCE_INCLUDE;
+			poly[num_poly].alt_min = amin;
+			poly[num_poly].alt_max = amax;
+			poly[num_poly].first = num_vert;
+			poly[num_poly].num = 0;
+			num_poly++;
+		}
+		else if (sscanf(line, "%lf %lf", &lat, &lon) == 2 && num_poly > 0 && num_vert < GEOFENCE_MAX_VERTICES){
+			vn[num_vert] = lat*D2R;		// geodetic until projected below
+			ve[num_vert] = lon*D2R;
+			edge_poly[num_vert] = num_poly - 1;
+			poly[num_poly-1].num++;
+			num_vert++;
+		}
+	}
+	fclose(fp);
+
+	if (num_poly > 0 && poly[num_poly-1].num < 3){
+		num_vert = poly[num_poly-1].first;
+		num_poly--;
+	}
+	if (num_poly == 0)
+		return 0;
+
+	// project into the fence frame
+	lat0 = vn[0];
+	lon0 = ve[0];
+	slat = sin(lat0);
+	Rn = EARTH_RADIUS/sqrt(1.0 - ECC2*slat*slat);
+	scale_n = Rn*(1.0 - ECC2)/(1.0 - ECC2*slat*slat);
+	scale_e = Rn*cos(lat0);
+
+	for (i = 0; i < num_vert; i++){
+		lon = ve[i] - lon0;
+		if (lon > PI) lon -= PI2;
+		else if (lon < -PI) lon += PI2;
+		vn[i] = (vn[i] - lat0)*scale_n;
+		ve[i] = lon*scale_e;
+	}
+
+	for (i = 0; i < num_poly; i++){
+		if (poly[i].kind == GEOFENCE_INCLUDE)
+			num_incl++;
+	}
+	for (i = 0; i < num_vert; i++){
+		edge_end[i] = (i + 1 < poly[edge_poly[i]].first + poly[edge_poly[i]].num) ? i + 1 : poly[edge_poly[i]].first;
+	}
+
+	return num_poly;
+}
+
+/// Grid over the fence, edge lists per cell and cell center containment. Returns 0 if the edge lists overflow.
+static int build_index(void){
+	static int fill[GEOFENCE_GRID*GEOFENCE_GRID];
+	double n_max, e_max, nlo, elo, cn, ce;
+	int i, j, k, c, pass, imin, imax, jmin, jmax;
+
+	n_min = n_max = vn[0];
+	e_min = e_max = ve[0];
+	for (k = 1; k < num_vert; k++){
+		if (vn[k] < n_min) n_min = vn[k];
+		if (vn[k] > n_max) n_max = vn[k];
+		if (ve[k] < e_min) e_min = ve[k];
+		if (ve[k] > e_max) e_max = ve[k];
+	}
+
+	// square cells, with a margin so no vertex sits on the outer boundary
+	cell = (n_max - n_min > e_max - e_min) ? n_max - n_min : e_max - e_min;
+	cell = cell*1.02/GEOFENCE_GRID + 1e-3;
+	inv_cell = 1.0/cell;
+	n_min -= 0.01*GEOFENCE_GRID*cell;
+	e_min -= 0.01*GEOFENCE_GRID*cell;
+
+	// edge lists: count the cells each edge passes through, then fill
+	memset(fill, 0, sizeof(fill));
+	for (pass = 0; pass < 2; pass++){
+		for (k = 0; k < num_vert; k++){
+			imin = (int)floor((fmin(vn[k], vn[edge_end[k]]) - n_min)*inv_cell);
+			imax = (int)floor((fmax(vn[k], vn[edge_end[k]]) - n_min)*inv_cell);
+			jmin = (int)floor((fmin(ve[k], ve[edge_end[k]]) - e_min)*inv_cell);
+			jmax = (int)floor((fmax(ve[k], ve[edge_end[k]]) - e_min)*inv_cell);
+			for (i = imin; i <= imax; i++){
+				for (j = jmin; j <= jmax; j++){
+					nlo = n_min + i*cell;
+					elo = e_min + j*cell;
+					if (!seg_in_rect(vn[k], ve[k], vn[edge_end[k]], ve[edge_end[k]], nlo, elo, nlo + cell, elo + cell))
+						continue;
+					c = i*GEOFENCE_GRID + j;
+					if (pass == 0)
+						fill[c]++;
+					else
+						refs[cell_start[c] + fill[c]++] = k;
+				}
+			}
+		}
+
+		if (pass == 0){
+			cell_start[0] = 0;
+			for (c = 0; c < GEOFENCE_GRID*GEOFENCE_GRID; c++){
+				cell_start[c+1] = cell_start[c] + fill[c];
+				fill[c] = 0;
+			}
+			if (cell_start[GEOFENCE_GRID*GEOFENCE_GRID] > GEOFENCE_MAX_REFS)
+				return 0;
+		}
+	}
+
+	// containment of every cell center
+	for (i = 0; i < GEOFENCE_GRID; i++){
+		for (j = 0; j < GEOFENCE_GRID; j++){
+			cn = n_min + (i + 0.5)*cell;
+			ce = e_min + (j + 0.5)*cell;
+			c = i*GEOFENCE_GRID + j;
+			center_mask[c] = 0;
+			for (k = 0; k < num_poly; k++){
+				if (contains(k, cn, ce))
+					center_mask[c] |= (uint64_t)1 << k;
+			}
+		}
+	}
+
+	return 1;
+}
+
+/// 1 if the segment touches the rectangle (Liang-Barsky clipping).
+static int seg_in_rect(double n0, double e0, double n1, double e1, double nlo, double elo, double nhi, double ehi){
+	double p[4], q[4], t0 = 0.0, t1 = 1.0, t;
+	int i;
+
+	p[0] = -(n1 - n0); q[0] = n0 - nlo;
+	p[1] =  (n1 - n0); q[1] = nhi - n0;
+	p[2] = -(e1 - e0); q[2] = e0 - elo;
+	p[3] =  (e1 - e0); q[3] = ehi - e0;
+
+	for (i = 0; i < 4; i++){
+		if (p[i] == 0.0){
+			if (q[i] < 0.0)
+				return 0;
+		}
+		else{
+			t = q[i]/p[i];
+			if (p[i] < 0.0){
+				if (t > t1) return 0;
+				if (t > t0) t0 = t;
+			}
+			else{
+				if (t < t0) return 0;
+				if (t < t1) t1 = t;
+			}
+		}
+	}
+	return 1;
+}
+
+/// Crossing number test of polygon p, used to build the index only.
+static int contains(int p, double n, double e){
+	int k, in = 0;
+
+	for (k = poly[p].first; k < poly[p].first + poly[p].num; k++){
+		if (crosses(vn[k], ve[k], vn[edge_end[k]], ve[edge_end[k]], n, e, n + 1e9, e))
+			in = !in;
+	}
+	return in;
+}
+
+/// 1 if segment a-b crosses segment c-d. Points exactly on a line count as on its negative side, so every
+/// crossing of a polygon boundary toggles the parity exactly once.
+static int crosses(double an, double ae, double bn, double be, double cn, double ce, double dn, double de){
+	int c_side = ((bn - an)*(ce - ae) - (be - ae)*(cn - an)) > 0.0;
+	int d_side = ((bn - an)*(de - ae) - (be - ae)*(dn - an)) > 0.0;
+	int a_side = ((dn - cn)*(ae - ce) - (de - ce)*(an - cn)) > 0.0;
+	int b_side = ((dn - cn)*(be - ce) - (de - ce)*(bn - cn)) > 0.0;
+
+	return (c_side != d_side) && (a_side != b_side);
+}
+
+/// Squared distance from (n, e) to edge k.
+static double seg_dist2(int k, double n, double e){
+	double dn = vn[edge_end[k]] - vn[k];
+	double de = ve[edge_end[k]] - ve[k];
+	double len2 = dn*dn + de*de, t = 0.0;
+
+	if (len2 > 0.0){
+		t = ((n - vn[k])*dn + (e - ve[k])*de)/len2;
+		if (t < 0.0) t = 0.0;
+		else if (t > 1.0) t = 1.0;
+	}
+	dn = vn[k] + t*dn - n;
+	de = ve[k] + t*de - e;
+	return dn*dn + de*de;
+}
@@ -0,0 +1,73 @@
+/*! \file geofence.h
+ *	\brief Geofence interface header
+ *
+ *	\details Inclusion and exclusion polygons, each with an altitude band, are loaded from GEOFENCE_FILE at
+ *	startup and projected into a local North/East frame anchored at the first vertex of the fence. A uniform grid
+ *	over the fence holds, per cell, the polygon edges crossing it and which polygons contain the cell center. A
+ *	check then only tests the edges of the aircraft's cell for containment and searches outward ring by ring for
+ *	the nearest edge, so its cost does not grow with the number of vertices.
+ *
+ *	The aircraft must stay inside at least one inclusion volume (if any are defined) and outside every exclusion
+ *	volume. On a breach the geofence latches a return to the point where the autopilot was engaged, overriding the
+ *	guidance commands until the autopilot is re-engaged. The return is only armed if the active control law takes
+ *	psi_cmd as a heading error, see get_control_psi_error(); with any other law a breach is only reported.
+ *	\ingroup guidance_fcns
+ *
+ * \author University of Minnesota
+ * \author Aerospace Engineering and Mechanics
+ * \copyright Copyright 2015 Regents of the University of Minnesota. All rights reserved.
+ *
+ * $Id$
+ */
+
+#ifndef GEOFENCE_H_
+#define GEOFENCE_H_
+
+#ifndef GEOFENCE_FILE
+	#define GEOFENCE_FILE	"geofence.txt"	///< fence polygons; no file, no fence
+#endif
+
+#define GEOFENCE_MAX_POLYGONS	64		///< capacity, one bit per polygon in the cell masks
+#define GEOFENCE_MAX_VERTICES	8192	///< capacity, all polygons together
+#define GEOFENCE_GRID			64		///< grid cells per side
+#define GEOFENCE_MAX_REFS		65536	///< capacity of the cell edge lists
+
+/// Fence polygon kind
+enum geofence_kind {
+	GEOFENCE_INCLUDE,	///< flight allowed only inside
+	GEOFENCE_EXCLUDE	///< no-fly zone
+};
+
+/// Result of a geofence check
+struct geofence_status {
+	int breach;			///< 1 if outside every inclusion volume or inside an exclusion volume
+	int poly;			///< polygon causing the breach, -1 if none
+	double dist;		///< [m], horizontal distance to the nearest fence edge
+	double dalt;		///< [m], distance to the nearest altitude limit of the polygons containing the aircraft
+	int rth;			///< 1 once a breach has latched the return to home
+};
+
+/// Load GEOFENCE_FILE and build the grid index.
+/*!
+ * File format: a polygon starts with a line "polygon include|exclude alt_min alt_max" and is followed by one
+ * "lat lon" line per vertex, in degrees. Altitudes are in meters, with the same reference as navData->alt.
+ * '#' starts a comment.
+ * \return number of polygons, 0 if there is no fence
+ * \ingroup guidance_fcns
+*/
+int init_geofence(void);
+
+/// Check the fence and, once breached, override the guidance commands to return home.
+/*!
+ * Call after get_guidance. The return heading error goes on psi_cmd, the convention of the waypoint guidance
+ * laws and waypoint_tracker.c, and the bearing home on gndtrk_cmd. With a law of another heading convention the
+ * return is not armed and the breach is reported with send_status() instead. An altitude breach of an inclusion volume
+ * also sets h_cmd back into its band, relative to the engage altitude. Clear status->rth at engage.
+ * \ingroup guidance_fcns
+*/
+void get_geofence(struct nav *navData_ptr,	///< pointer to navData structure
+		struct control *controlData_ptr,		///< pointer to controlData structure
+		struct geofence_status *status			///< check result and return to home latch
+		);
+
+#endif /* GEOFENCE_H_ */
@@ -24,4 +24,33 @@ extern void get_guidance(double time, 			///< [sec], time since in autopilot mod
 		struct control *controlData_ptr		///< pointer to controlData structure
 		);
 
+/// Standard function to release the resources of the guidance law, at shutdown
+/*!
+ * \ingroup guidance_fcns
+*/
+extern void close_guidance(void);
+
+/// Inputs and outputs of a batch of independent guidance instances, one array element per instance (SoA).
+/*!
+ * Laws that keep their state in a context struct provide a batch function taking this, so a host-side
+ * simulator can run many instances of the flight guidance code at once. get_guidance is the same law
+ * run as a batch of one on navData/controlData.
+ * \ingroup guidance_fcns
+*/
+struct guidance_batch {
+	int num;				///< number of instances
+	const double *time;		///< [sec], time since in autopilot mode
+	const double *ias;		///< [m/sec], filtered indicated airspeed
+	const double *pos_n;	///< [m], North position from the autopilot engage point
+	const double *pos_e;	///< [m], East position from the autopilot engage point
+	const double *vn;		///< [m/sec], North velocity
+	const double *ve;		///< [m/sec], East velocity
+	const double *gndtrk;	///< [rad], ground track angle
+	const double *gndspd;	///< [m/sec], horizontal ground speed
+	const double *wind_n;	///< [m/sec], North wind estimate
+	const double *wind_e;	///< [m/sec], East wind estimate
+	double *psi_cmd;		///< [rad], heading command output
+	double *r_cmd;			///< diagnostic output
+};
+
 #endif /* GUIDANCE_INTERFACE_H_ */
@@ -26,3 +26,6 @@ extern void get_guidance(double time, struct sensordata *sensorData_ptr, struct
 
 	}
 
+void close_guidance(void){
+	// nothing allocated
+}
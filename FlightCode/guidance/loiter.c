@@ -0,0 +1,281 @@
+/*! \file loiter.c
+ *	\brief Loiter patterns
+ *
+ *	\details Circle, racetrack and figure eight patterns flown with an incrementally rotated carrot, see loiter.h.
+ *	\ingroup guidance_fcns
+ *
+ * \author University of Minnesota
+ * \author Aerospace Engineering and Mechanics
+ * \copyright Copyright 2015 Regents of the University of Minnesota. All rights reserved.
+ *
+ * $Id$
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include "../globaldefs.h"
+#include "loiter.h"
+
+// local functions
+static void set_line(struct loiter_segment *seg, double n0, double e0, double n1, double e1, double step, int next);
+static void set_arc(struct loiter_segment *seg, double cn, double ce, double R, double turn, double vn, double ve, double dpsi, double step, double lead, int next);
+static double sweep(double turn, double vn0, double ve0, double vn1, double ve1);
+static const struct loiter_segment *segment(const struct loiter_pattern *pattern, const struct loiter_carrot *carrot);
+static void begin(const struct loiter_pattern *pattern, struct loiter_carrot *carrot, int seg);
+static void advance(const struct loiter_pattern *pattern, struct loiter_carrot *carrot);
+static int behind(const struct loiter_pattern *pattern, const struct loiter_carrot *carrot, double n, double e);
+
+int load_loiter(struct loiter_spec *spec, const char *filename){
+	FILE *fp;
+	char line[128], kind[16], dir[8];
+	double n, e, R, len, axis;
+	int found = 0;
+
+	if ((fp = fopen(filename, "r")) == NULL)
+		return 0;
+
+	while (!found && fgets(line, sizeof(line), fp) != NULL){
+		if (sscanf(line, "%15s %lf %lf %lf %lf %lf %7s", kind, &n, &e, &R, &len, &axis, dir) != 7)
+			continue;	// blank line or comment
+
+		if (strcmp(kind, "circle") == 0) spec->kind = LOITER_CIRCLE;
+		else if (strcmp(kind, "racetrack") == 0) spec->kind = LOITER_RACETRACK;
+		else if (strcmp(kind, "figure8") == 0) spec->kind = LOITER_FIGURE8;
+		else continue;
+
+		spec->n = n;
+		spec->e = e;
+		spec->R = R;
+		spec->len = len;
+		spec->axis = axis*D2R;
+		spec->turn = (strcmp(dir, "left") == 0) ? -1.0 : 1.0;
+		found = 1;
+	}
+	fclose(fp);
+
+	return found;
+}
+
+int init_loiter(struct loiter_pattern *pattern, const struct loiter_spec *spec, double step, double lead){
+	struct loiter_segment *seg = pattern->seg;
+	enum loiter_kind kind = spec->kind;
+	double R = spec->R, t = (spec->turn < 0.0) ? -1.0 : 1.0, h = 0.5*spec->len;
+	double an = cos(spec->axis), ae = sin(spec->axis);	// along the axis
+	double rn = -ae, re = an;							// right of the axis
+	double n1 = spec->n - h*an, e1 = spec->e - h*ae;	// first circle center
+	double n2 = spec->n + h*an, e2 = spec->e + h*ae;	// second circle center
+	double b, c, h1n, h1e, h2n, h2e, t1n, t1e, t2n, t2e, t3n, t3e, t4n, t4e;
+
+	pattern->num = 0;
+	pattern->step = (step > 0.0) ? step : 1.0;
+	pattern->lead = lead;
+	step = pattern->step;
+	if (R <= 0.0)
+		return 0;
+
+	if (kind == LOITER_FIGURE8 && spec->len <= 2.0*R) kind = LOITER_RACETRACK;
+	if (kind == LOITER_RACETRACK && spec->len <= 0.0) kind = LOITER_CIRCLE;
+
+	switch (kind){
+	case LOITER_CIRCLE:
+		set_arc(&seg[0], spec->n, spec->e, R, t, t*rn, t*re, PI2, step, lead, 0);
+		pattern->num = 1;
+		break;
+
+	case LOITER_RACETRACK:
+		// half circles around the centers, flown with the centers on the inside of the lines
+		set_arc(&seg[0], n1, e1, R, t, t*rn, t*re, PI, step, lead, 1);
+		set_line(&seg[1], n1 - t*R*rn, e1 - t*R*re, n2 - t*R*rn, e2 - t*R*re, step, 2);
+		set_arc(&seg[2], n2, e2, R, t, -t*rn, -t*re, PI, step, lead, 3);
+		set_line(&seg[3], n2 + t*R*rn, e2 + t*R*re, n1 + t*R*rn, e1 + t*R*re, step, 0);
+		pattern->num = 4;
+		break;
+
+	case LOITER_FIGURE8:
+		// lines through the center tangent to both circles, at asin(2R/len) to the axis, one from each circle
+		b = asin(2.0*R/spec->len);
+		c = h*cos(b);
+		h1n = cos(spec->axis + t*b);
+		h1e = sin(spec->axis + t*b);
+		h2n = -cos(spec->axis - t*b);
+		h2e = -sin(spec->axis - t*b);
+		t1n = spec->n - c*h1n;	t1e = spec->e - c*h1e;	// leaving the first circle
+		t2n = spec->n + c*h1n;	t2e = spec->e + c*h1e;	// onto the second circle
+		t3n = spec->n - c*h2n;	t3e = spec->e - c*h2e;	// leaving the second circle
+		t4n = spec->n + c*h2n;	t4e = spec->e + c*h2e;	// back onto the first circle
+		set_arc(&seg[0], n1, e1, R, t, (t4n - n1)/R, (t4e - e1)/R,
+				sweep(t, (t4n - n1)/R, (t4e - e1)/R, (t1n - n1)/R, (t1e - e1)/R), step, lead, 1);
+		set_line(&seg[1], t1n, t1e, t2n, t2e, step, 2);
+		set_arc(&seg[2], n2, e2, R, -t, (t2n - n2)/R, (t2e - e2)/R,
+				sweep(-t, (t2n - n2)/R, (t2e - e2)/R, (t3n - n2)/R, (t3e - e2)/R), step, lead, 3);
+		set_line(&seg[3], t3n, t3e, t4n, t4e, step, 0);
+		pattern->num = 4;
+		break;
+	}
+
+	return pattern->num;
+}
+
+void loiter_enter(const struct loiter_pattern *pattern, struct loiter_carrot *carrot, double n, double e){
+	const struct loiter_segment *first = &pattern->seg[0];
+	const struct loiter_segment *after = &pattern->seg[first->next];
+	double dn = n - first->cn, de = e - first->ce, d = sqrt(dn*dn + de*de);
+	double R = first->R, t = first->turn, ca, sa, vn, ve, wn, we;
+
+	carrot->n = n;
+	carrot->e = e;
+	if (pattern->num == 0)
+		return;
+
+	if (d > R){
+		// tangent point at acos(R/d) from the radial through the aircraft, on the side flown in the turn direction
+		ca = R/d;
+		sa = sqrt(1.0 - ca*ca);
+		vn = (ca*dn - sa*de)/d;
+		ve = (sa*dn + ca*de)/d;
+		if (-t*ve*(first->cn + R*vn - n) + t*vn*(first->ce + R*ve - e) < 0.0){
+			vn = (ca*dn + sa*de)/d;
+			ve = (-sa*dn + ca*de)/d;
+		}
+	}
+	else if (d > 0.0){
+		vn = dn/d;		// inside the circle: join at the nearest point
+		ve = de/d;
+	}
+	else{
+		vn = first->vn;
+		ve = first->ve;
+	}
+
+	// line to the tangent point, then around the circle to where the pattern leaves it
+	wn = (after->n0 - first->cn)/R;
+	we = (after->e0 - first->ce)/R;
+	set_line(&carrot->entry[0], n, e, first->cn + R*vn, first->ce + R*ve, pattern->step, -2);
+	set_arc(&carrot->entry[1], first->cn, first->ce, R, t, vn, ve, sweep(t, vn, ve, wn, we), pattern->step,
+			pattern->lead, first->next);
+	begin(pattern, carrot, -1);
+}
+
+void loiter_track(const struct loiter_pattern *pattern, struct loiter_carrot *carrot, double n, double e){
+	int i;
+
+	if (pattern->num == 0)
+		return;
+
+	for (i = 0; i < LOITER_MAX_STEPS && behind(pattern, carrot, n, e); i++)
+		advance(pattern, carrot);
+}
+
+static void set_line(struct loiter_segment *seg, double n0, double e0, double n1, double e1, double step, int next){
+	double dn = n1 - n0, de = e1 - e0, len = sqrt(dn*dn + de*de);
+
+	memset(seg, 0, sizeof(*seg));
+	seg->next = next;
+	seg->n0 = n0;
+	seg->e0 = e0;
+	seg->steps = (int)ceil(len/step);
+	if (seg->steps > 0){
+		seg->un = dn/len;
+		seg->ue = de/len;
+		seg->ds = len/seg->steps;
+	}
+}
+
+static void set_arc(struct loiter_segment *seg, double cn, double ce, double R, double turn, double vn, double ve, double dpsi, double step, double lead, int next){
+	double a;
+
+	memset(seg, 0, sizeof(*seg));
+	seg->arc = 1;
+	seg->next = next;
+	seg->cn = cn;
+	seg->ce = ce;
+	seg->R = R;
+	seg->turn = turn;
+	seg->vn = vn;
+	seg->ve = ve;
+	seg->n0 = cn + R*vn;
+	seg->e0 = ce + R*ve;
+	seg->steps = (int)ceil(dpsi*R/step);
+
+	// turning by a moves the radial vector by a, in either direction
+	a = (seg->steps > 0) ? turn*dpsi/seg->steps : 0.0;
+	seg->c = cos(a);
+	seg->s = sin(a);
+
+	a = lead/R;
+	if (a > 0.5*PI) a = 0.5*PI;
+	seg->cos2_lead = cos(a)*cos(a);
+}
+
+/// Heading change in [0, 2*PI) flying around a circle in direction turn from radial vector 0 to radial vector 1.
+static double sweep(double turn, double vn0, double ve0, double vn1, double ve1){
+	double a = turn*atan2(vn0*ve1 - ve0*vn1, vn0*vn1 + ve0*ve1);
+
+	return (a < 0.0) ? a + PI2 : a;
+}
+
+static const struct loiter_segment *segment(const struct loiter_pattern *pattern, const struct loiter_carrot *carrot){
+	return (carrot->seg >= 0) ? &pattern->seg[carrot->seg] : &carrot->entry[-1 - carrot->seg];
+}
+
+/// Put the carrot at the start of a segment, skipping segments without steps.
+static void begin(const struct loiter_pattern *pattern, struct loiter_carrot *carrot, int seg){
+	const struct loiter_segment *sp;
+	int i;
+
+	for (i = 0; i < LOITER_MAX_SEGMENTS + 2; i++){
+		carrot->seg = seg;
+		sp = segment(pattern, carrot);
+		if (sp->steps > 0)
+			break;
+		seg = sp->next;
+	}
+
+	carrot->k = 0;
+	carrot->vn = sp->vn;
+	carrot->ve = sp->ve;
+	carrot->n = sp->n0;
+	carrot->e = sp->e0;
+}
+
+/// One carrot step. Every segment ends exactly where the next begins, so rounding does not build up over laps.
+static void advance(const struct loiter_pattern *pattern, struct loiter_carrot *carrot){
+	const struct loiter_segment *sp = segment(pattern, carrot);
+	double vn;
+
+	if (++carrot->k >= sp->steps){
+		begin(pattern, carrot, sp->next);
+		return;
+	}
+
+	if (sp->arc){
+		vn = carrot->vn;
+		carrot->vn = sp->c*vn - sp->s*carrot->ve;
+		carrot->ve = sp->s*vn + sp->c*carrot->ve;
+		carrot->n = sp->cn + sp->R*carrot->vn;
+		carrot->e = sp->ce + sp->R*carrot->ve;
+	}
+	else{
+		carrot->n = sp->n0 + carrot->k*sp->ds*sp->un;
+		carrot->e = sp->e0 + carrot->k*sp->ds*sp->ue;
+	}
+}
+
+/// 1 if the carrot is less than the lead ahead of (n, e).
+static int behind(const struct loiter_pattern *pattern, const struct loiter_carrot *carrot, double n, double e){
+	const struct loiter_segment *sp = segment(pattern, carrot);
+	double dn, de, cross, dot;
+
+	if (!sp->arc)
+		return (carrot->k*sp->ds - ((n - sp->n0)*sp->un + (e - sp->e0)*sp->ue) < pattern->lead);
+
+	// angle from the aircraft radial to the carrot radial, in the turn direction: behind if negative or under
+	// the lead angle
+	dn = n - sp->cn;
+	de = e - sp->ce;
+	cross = sp->turn*(dn*carrot->ve - de*carrot->vn);
+	dot = dn*carrot->vn + de*carrot->ve;
+	return (cross < 0.0 || (dot > 0.0 && dot*dot > (dn*dn + de*de)*sp->cos2_lead));
+}
@@ -0,0 +1,126 @@
+/*! \file loiter.h
+ *	\brief Loiter pattern interface header
+ *
+ *	\details A loiter pattern (an orbit around an arbitrary center, a racetrack or a figure eight) is built once
+ *	as a closed loop of lines and arcs, each cut into a whole number of equal steps of about the distance flown in
+ *	one frame. The carrot moves along the pattern one step at a time: on an arc its radial unit vector is rotated
+ *	by the arc's precomputed step rotation, on a line it moves a fixed distance. It only steps while it is less
+ *	than the lead ahead of the aircraft, which is tested with cross and dot products, so moving the carrot needs no
+ *	atan2, sqrt or trigonometry per frame; the guidance law turning the carrot into a course error still takes one
+ *	atan2 per frame, see loiter_guidance.c. The entry, a line tangent to the first circle of the pattern, is solved once
+ *	from the position at which the loiter starts.
+ *	\ingroup guidance_fcns
+ *
+ * \author University of Minnesota
+ * \author Aerospace Engineering and Mechanics
+ * \copyright Copyright 2015 Regents of the University of Minnesota. All rights reserved.
+ *
+ * $Id$
+ */
+
+#ifndef LOITER_H_
+#define LOITER_H_
+
+#ifndef LOITER_FILE
+	#define LOITER_FILE	"loiter.txt"	///< pattern definition, see load_loiter()
+#endif
+
+#define LOITER_MAX_SEGMENTS	4	///< two arcs and two lines
+#define LOITER_MAX_STEPS	3	///< carrot steps per frame, so the carrot can run at up to three times the nominal speed
+
+/// Pattern kind
+enum loiter_kind {
+	LOITER_CIRCLE,		///< orbit around the center
+	LOITER_RACETRACK,	///< two half circles joined by parallel lines
+	LOITER_FIGURE8		///< two circles flown in opposite directions, joined by lines crossing at the center
+};
+
+/// Pattern definition
+struct loiter_spec {
+	enum loiter_kind kind;	///< pattern kind
+	double n, e;			///< [m], pattern center, North/East of the launch point
+	double R;				///< [m], circle radius
+	double len;				///< [m], distance between the two circle centers (racetrack, figure eight)
+	double axis;			///< [rad], heading from the first circle center to the second
+	double turn;			///< direction of the first circle, +1 right (clockwise), -1 left
+};
+
+/// Line or arc of a pattern
+struct loiter_segment {
+	int arc;				///< 1 for an arc, 0 for a line
+	int next;				///< segment that follows
+	int steps;				///< carrot steps to the end of the segment
+	double n0, e0;			///< [m], start point
+	double un, ue;			///< unit vector along the line (lines)
+	double ds;				///< [m], step length (lines)
+	double cn, ce;			///< [m], circle center (arcs)
+	double R;				///< [m], radius (arcs)
+	double turn;			///< turn direction, +1 right, -1 left (arcs)
+	double vn, ve;			///< radial unit vector at the start (arcs)
+	double c, s;			///< step rotation of the radial vector (arcs)
+	double cos2_lead;		///< squared cosine of the lead angle, at most 90 deg (arcs)
+};
+
+/// Loiter pattern. Read-only once built; every aircraft flying it keeps its own carrot.
+struct loiter_pattern {
+	struct loiter_segment seg[LOITER_MAX_SEGMENTS];	///< segments in flight order, seg[0] is an arc
+	int num;			///< number of segments
+	double step;		///< [m], nominal carrot step
+	double lead;		///< [m], carrot lead
+};
+
+/// Per-aircraft carrot
+struct loiter_carrot {
+	struct loiter_segment entry[2];	///< entry line to the tangent point, then the arc from it onto the pattern
+	int seg;			///< current segment, -1 and -2 for the entry line and arc
+	int k;				///< steps taken along the current segment
+	double vn, ve;		///< radial unit vector of the carrot (arcs)
+	double n, e;		///< [m], carrot position
+};
+
+/// Read a pattern from a file.
+/*!
+ * File format: one line "circle|racetrack|figure8 north east radius length axis right|left", with the center
+ * and distances in meters and the axis heading in degrees. '#' starts a comment.
+ * \return 1 if a pattern was read, 0 otherwise
+ * \ingroup guidance_fcns
+*/
+int load_loiter(struct loiter_spec *spec,	///< pattern definition, left unchanged if none is read
+		const char *filename	///< file to read
+		);
+
+/// Build a pattern.
+/*!
+ * A racetrack of zero length is flown as a circle. A figure eight needs its circle centers more than two radii
+ * apart and falls back to a racetrack otherwise.
+ * \return number of segments
+ * \ingroup guidance_fcns
+*/
+int init_loiter(struct loiter_pattern *pattern,	///< pointer to pattern
+		const struct loiter_spec *spec,	///< pattern definition
+		double step,	///< [m], nominal carrot step, the distance flown in one frame
+		double lead		///< [m], carrot lead ahead of the aircraft
+		);
+
+/// Start a carrot at the tangent entry from (n, e) onto the first circle of the pattern.
+/*!
+ * \ingroup guidance_fcns
+*/
+void loiter_enter(const struct loiter_pattern *pattern,	///< pointer to pattern
+		struct loiter_carrot *carrot,	///< carrot to start
+		double n,		///< [m], North position
+		double e		///< [m], East position
+		);
+
+/// Move the carrot up to LOITER_MAX_STEPS steps, keeping it the lead ahead of (n, e).
+/*!
+ * The carrot position is left in carrot->n and carrot->e.
+ * \ingroup guidance_fcns
+*/
+void loiter_track(const struct loiter_pattern *pattern,	///< pointer to pattern
+		struct loiter_carrot *carrot,	///< carrot to move
+		double n,		///< [m], North position
+		double e		///< [m], East position
+		);
+
+#endif /* LOITER_H_ */
@@ -0,0 +1,94 @@
+/*!	\file loiter_guidance.c
+ *	\brief Loiter get_guidance law
+ *
+ *	\details Flies the circle, racetrack or figure eight pattern of LOITER_FILE (see loiter.h), or a built-in orbit
+ *	north of the engage point if there is none. The pattern is relative to the point where the autopilot is engaged,
+ *	as for waypoint_guidance.c, and is entered along a line tangent to its first circle from the engage position.
+ *	Each frame the heading error to a carrot kept a fixed lead ahead along the pattern is commanded on psi_cmd, the
+ *	convention expected by waypoint_tracker.c. The carrot moves without trigonometry; the bearing to it is the one
+ *	atan2 of the frame.
+ *	\ingroup guidance_fcns
+ *
+ * \author University of Minnesota
+ * \author Aerospace Engineering and Mechanics
+ * \copyright Copyright 2015 Regents of the University of Minnesota. All rights reserved.
+ *
+ * $Id$
+ */
+
+#include <math.h>
+
+#include "../globaldefs.h"
+#include "guidance_interface.h"
+#include "loiter.h"
+
+#include AIRCRAFT_UP1DIR
+
+// Control parameters
+#define LEAD			30.0		// carrot lead along the pattern [m]
+
+// Built-in pattern: 80 m right hand orbit centered 150 m north of the engage point
+static struct loiter_spec spec = {LOITER_CIRCLE, 150.0, 0.0, 80.0, 0.0, 0.0, 1.0};
+static struct loiter_pattern pattern;
+static struct loiter_carrot carrot;
+
+static short guide_init=0;
+static short entered=0;
+static double last_time=0.0;
+
+extern void get_guidance(double time, struct sensordata *sensorData_ptr, struct nav *navData_ptr, struct control *controlData_ptr){
+	double dpsi;
+
+	// enter the pattern again when the autopilot is re-engaged
+	if (time < last_time)
+		entered = 0;
+	last_time = time;
+
+	if (time>0.05){
+	#ifdef AIRCRAFT_THOR
+		controlData_ptr->ias_cmd = 17;				//Trim airspeed (m/s)
+	#endif
+	#ifdef AIRCRAFT_TYR
+		controlData_ptr->ias_cmd = 17;				//Trim airspeed (m/s)
+	#endif
+	#ifdef AIRCRAFT_FASER
+		controlData_ptr->ias_cmd = 23;
+	#endif
+	#ifdef AIRCRAFT_IBIS
+		controlData_ptr->ias_cmd = 23;
+	#endif
+	#ifdef AIRCRAFT_BALDR
+		controlData_ptr->ias_cmd = 23;
+	#endif
+
+		// build the pattern once; the carrot steps by the distance flown in a frame at the commanded airspeed
+		if (guide_init==0){
+			load_loiter(&spec, LOITER_FILE);
+			init_loiter(&pattern, &spec, controlData_ptr->ias_cmd*TIMESTEP, LEAD);
+			guide_init=1;
+		}
+
+		if (pattern.num == 0 || sensorData_ptr->adData_ptr->ias_filt <= 10){	// no pattern, or airspeed filter not initialized
+			controlData_ptr->psi_cmd = 0;
+			return;
+		}
+
+		if (entered==0){
+			loiter_enter(&pattern, &carrot, navData_ptr->ltp.pos_ned[0], navData_ptr->ltp.pos_ned[1]);
+			entered=1;
+		}
+		loiter_track(&pattern, &carrot, navData_ptr->ltp.pos_ned[0], navData_ptr->ltp.pos_ned[1]);
+
+		dpsi = atan2(carrot.e - navData_ptr->ltp.pos_ned[1], carrot.n - navData_ptr->ltp.pos_ned[0]) - navData_ptr->trig.gndtrk;
+		if (dpsi > PI) dpsi -= PI2;
+		else if (dpsi < -PI) dpsi += PI2;
+
+		controlData_ptr->psi_cmd = dpsi;
+		controlData_ptr->r_cmd = carrot.seg;	// store the carrot segment on r_cmd: -1 -> entry line, -2 -> entry arc,
+												// 0.. -> pattern segment
+	}
+}
+
+extern void close_guidance(void){
+	// nothing allocated
+}
@@ -0,0 +1,170 @@
+/*! \file mission.c
+ *	\brief Waypoint mission loading and leg geometry
+ *
+ *	\details Loads the waypoint list and precomputes everything about a leg that does not depend on the
+ *	aircraft state, so guidance laws only evaluate the aircraft-dependent terms each frame.
+ *	\ingroup guidance_fcns
+ *
+ * \author University of Minnesota
+ * \author Aerospace Engineering and Mechanics
+ * \copyright Copyright 2015 Regents of the University of Minnesota. All rights reserved.
+ *
+ * $Id$
+ */
+
+#include <stdio.h>
+#include <math.h>
+
+#include "../globaldefs.h"
+#include "../utils/misc.h"
+#include "mission.h"
+
+// Built-in mission, used when MISSION_FILE is missing or invalid
+// order: NO, EA, IAS, alt
+#define NUM_BUILTIN_WAYPOINTS 6
+static const double builtin_waypoints[NUM_BUILTIN_WAYPOINTS][4] = {
+	{0, 0, 20.0, 60.0},
+	{0, 200, 20.0, 60.0},
+	{120, 200, 20.0, 60.0},
+	{80, 170, 20.0, 60.0},
+	{160, 90, 20.0, 60.0},
+	{120, 0, 20.0, 60.0}
+};
+
+// local functions
+static int load_mission(struct mission *mission_ptr, const char *filename);
+static void leg_geometry(struct mission *mission_ptr);
+
+int init_mission(struct mission *mission_ptr, double ias, double phi_max, double ftol, double wptol, double arc){
+	char msg[96];
+	int i;
+
+	if (load_mission(mission_ptr, MISSION_FILE) < 2){
+		snprintf(msg, sizeof(msg), "mission: %s missing or under 2 waypoints, built-in mission loaded", MISSION_FILE);
+		send_status(msg);
+		for (i = 0; i < NUM_BUILTIN_WAYPOINTS; i++){
+			mission_ptr->leg[i].n   = builtin_waypoints[i][0];
+			mission_ptr->leg[i].e   = builtin_waypoints[i][1];
+			mission_ptr->leg[i].ias = builtin_waypoints[i][2];
+			mission_ptr->leg[i].alt = builtin_waypoints[i][3];
+		}
+		mission_ptr->num = NUM_BUILTIN_WAYPOINTS;
+	}
+
+	leg_geometry(mission_ptr);
+
+	mission_ptr->ias = ias;
+	mission_ptr->tan_phi = tan(phi_max);
+	mission_ptr->ftol = ftol;
+	mission_ptr->arc = arc;
+	mission_ptr->wptol2 = wptol*wptol;
+
+	return mission_ptr->num;
+}
+
+void mission_set_wind(const struct mission *mission_ptr, struct mission_wind *wind_ptr, double wind_n, double wind_e){
+	double vg = mission_ptr->ias + sqrt(wind_n*wind_n + wind_e*wind_e);	// ground speed downwind
+
+	wind_ptr->wind_n = wind_n;
+	wind_ptr->wind_e = wind_e;
+
+	wind_ptr->Rt = vg*vg/g/mission_ptr->tan_phi;
+	wind_ptr->Rt_ftol2 = (wind_ptr->Rt + mission_ptr->ftol)*(wind_ptr->Rt + mission_ptr->ftol);
+	wind_ptr->cs = cos(mission_ptr->arc/wind_ptr->Rt);
+	wind_ptr->ss = sin(mission_ptr->arc/wind_ptr->Rt);
+}
+
+int mission_wind_changed(const struct mission_wind *wind_ptr, double wind_n, double wind_e){
+	double dn = wind_n - wind_ptr->wind_n;
+	double de = wind_e - wind_ptr->wind_e;
+
+	return (dn*dn + de*de > MISSION_WIND_REPLAN*MISSION_WIND_REPLAN);
+}
+
+const struct mission_leg *mission_advance(const struct mission *mission_ptr, int *next){
+
+	if (++(*next) >= mission_ptr->num)
+		*next = 0;	// change back to first waypoint
+
+	return &mission_ptr->leg[*next];
+}
+
+int mission_reached(const struct mission *mission_ptr, int next, double n, double e){
+	double dn = mission_ptr->leg[next].n - n;
+	double de = mission_ptr->leg[next].e - e;
+
+	return (dn*dn + de*de < mission_ptr->wptol2);
+}
+
+/// Read the waypoint file. Returns the number of waypoints loaded, 0 if the file could not be used.
+static int load_mission(struct mission *mission_ptr, const char *filename){
+	FILE *fp;
+	char line[128], msg[96];
+	double n, e, ias, alt;
+	int num = 0;
+
+	if ((fp = fopen(filename, "r")) == NULL)
+		return 0;
+
+	while (fgets(line, sizeof(line), fp) != NULL){
+		if (sscanf(line, "%lf %lf %lf %lf", &n, &e, &ias, &alt) != 4)
+			continue;	// blank line or comment
+
+		if (num >= MISSION_MAX_WAYPOINTS){
+			snprintf(msg, sizeof(msg), "mission: %s truncated to %d waypoints", filename, MISSION_MAX_WAYPOINTS);
+			send_status(msg);
+			break;
+		}
+
+		// the first waypoint must be the launch point
+		if (num == 0 && (n != 0.0 || e != 0.0)){
+			mission_ptr->leg[0].n = 0.0;
+			mission_ptr->leg[0].e = 0.0;
+			mission_ptr->leg[0].ias = ias;
+			mission_ptr->leg[0].alt = alt;
+			num = 1;
+		}
+
+		mission_ptr->leg[num].n = n;
+		mission_ptr->leg[num].e = e;
+		mission_ptr->leg[num].ias = ias;
+		mission_ptr->leg[num].alt = alt;
+		num++;
+	}
+	fclose(fp);
+
+	mission_ptr->num = num;
+	return num;
+}
+
+/// Unit vector, length and heading of every leg, and the turn direction onto it. Leg 0 closes the loop.
+static void leg_geometry(struct mission *mission_ptr){
+	struct mission_leg *leg, *prev;
+	double dn, de;
+	int i;
+
+	for (i = 0; i < mission_ptr->num; i++){
+		leg = &mission_ptr->leg[i];
+		prev = &mission_ptr->leg[(i == 0) ? mission_ptr->num - 1 : i - 1];
+
+		dn = leg->n - prev->n;
+		de = leg->e - prev->e;
+		leg->len = sqrt(dn*dn + de*de);
+		if (leg->len > 0.0){
+			leg->un = dn/leg->len;
+			leg->ue = de/leg->len;
+		}
+		else{
+			leg->un = 1.0;
+			leg->ue = 0.0;
+		}
+		leg->psi = atan2(leg->ue, leg->un);
+	}
+
+	for (i = 0; i < mission_ptr->num; i++){
+		leg = &mission_ptr->leg[i];
+		prev = &mission_ptr->leg[(i == 0) ? mission_ptr->num - 1 : i - 1];
+		dn = prev->un*leg->ue - prev->ue*leg->un;	// cross product, positive for a right turn
+		leg->turn = (dn > 0.0) ? 1.0 : ((dn < 0.0) ? -1.0 : 0.0);
+	}
+}
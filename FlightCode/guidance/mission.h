@@ -0,0 +1,123 @@
+/*! \file mission.h
+ *	\brief Waypoint mission interface header
+ *
+ *	\details Waypoint missions are loaded from MISSION_FILE at guidance initialization, falling back to a built-in
+ *	table. Leg geometry that does not change in flight (unit vectors, headings, lengths) is computed once at
+ *	load. The turn radius and feasibility circle depend on the wind, so each guidance instance keeps its own in a
+ *	struct mission_wind, recomputed only when its wind estimate changes materially; the guidance laws only do O(1)
+ *	work per frame and the mission itself is never written after loading.
+ *	\ingroup guidance_fcns
+ *
+ * \author University of Minnesota
+ * \author Aerospace Engineering and Mechanics
+ * \copyright Copyright 2015 Regents of the University of Minnesota. All rights reserved.
+ *
+ * $Id$
+ */
+
+#ifndef MISSION_H_
+#define MISSION_H_
+
+#ifndef MISSION_MAX_WAYPOINTS
+	#define MISSION_MAX_WAYPOINTS	2048	///< capacity of the waypoint table
+#endif
+
+#ifndef MISSION_WIND_REPLAN
+	#define MISSION_WIND_REPLAN	1.0		///< [m/sec], change of the wind estimate that makes the turn geometry worth recomputing
+#endif
+
+#ifndef MISSION_FILE
+	#define MISSION_FILE	"mission.txt"	///< one waypoint per line: North [m], East [m], IAS [m/s], alt [m]; '#' starts a comment
+#endif
+
+/// One mission leg, from the previous waypoint to waypoint n/e
+struct mission_leg {
+	double n;		///< [m], North offset of the goal waypoint from the launch point
+	double e;		///< [m], East offset of the goal waypoint from the launch point
+	double ias;		///< [m/sec], airspeed for the leg
+	double alt;		///< [m], altitude for the leg
+	double un;		///< North component of the leg unit vector
+	double ue;		///< East component of the leg unit vector
+	double len;		///< [m], leg length
+	double psi;		///< [rad], leg heading
+	double turn;	///< direction of the turn from the previous leg onto this one, +1 right, -1 left, 0 straight
+};
+
+/// Waypoint mission. Read-only once loaded, so one mission can be shared by many guidance instances, each
+/// keeping its own cursor (index of its goal waypoint).
+struct mission {
+	struct mission_leg leg[MISSION_MAX_WAYPOINTS];	///< leg i ends at waypoint i; waypoint 0 is the launch point
+	int num;			///< number of waypoints
+	double ias;			///< [m/sec], commanded airspeed
+	double tan_phi;		///< tan of the maximum bank angle considered for turns
+	double ftol;		///< [m], tolerance of the feasibility circle
+	double arc;			///< [m], forward arc length when tracking the turn circle
+	double wptol2;		///< [m^2], waypoint capture radius squared
+};
+
+/// Turn geometry of a mission in one wind estimate, kept by each guidance instance
+struct mission_wind {
+	double wind_n;		///< [m/sec], North wind the turn geometry was computed for
+	double wind_e;		///< [m/sec], East wind the turn geometry was computed for
+	double Rt;			///< [m], turn radius at the highest ground speed in this wind and maximum bank
+	double Rt_ftol2;	///< [m^2], (Rt + feasibility tolerance)^2
+	double cs, ss;		///< cos and sin of the forward arc angle used when tracking the turn circle
+};
+
+/// Load the mission and precompute its leg geometry.
+/*!
+ * Loads MISSION_FILE if present and valid, otherwise the built-in table. The turn geometry is not part of the
+ * mission, see mission_set_wind(). The first waypoint must be the
+ * launch point {0, 0}; a file that does not start there gets it prepended.
+ * \return number of waypoints
+ * \ingroup guidance_fcns
+*/
+int init_mission(struct mission *mission_ptr,	///< pointer to mission
+		double ias,			///< [m/sec], commanded airspeed, sets the turn radius
+		double phi_max,		///< [rad], maximum bank angle considered for turns
+		double ftol,		///< [m], tolerance of the feasibility circle
+		double wptol,		///< [m], waypoint capture radius
+		double arc			///< [m], forward arc length when tracking the turn circle
+		);
+
+/// Compute the turn geometry of a mission for a wind estimate.
+/*!
+ * The turn radius is sized for the ground speed downwind, ias + |wind|, so a turn flown at the maximum bank
+ * holds in any direction.
+ * \ingroup guidance_fcns
+*/
+void mission_set_wind(const struct mission *mission_ptr,	///< pointer to mission
+		struct mission_wind *wind_ptr,	///< turn geometry to update
+		double wind_n,		///< [m/sec], North wind
+		double wind_e		///< [m/sec], East wind
+		);
+
+/// Returns 1 if the wind estimate has moved more than MISSION_WIND_REPLAN from the one the geometry is for.
+/*!
+ * \ingroup guidance_fcns
+*/
+int mission_wind_changed(const struct mission_wind *wind_ptr,	///< turn geometry in use
+		double wind_n,		///< [m/sec], North wind
+		double wind_e		///< [m/sec], East wind
+		);
+
+/// Advance a cursor to the next waypoint, wrapping back to the launch point after the last one.
+/*!
+ * \return pointer to the new goal leg
+ * \ingroup guidance_fcns
+*/
+const struct mission_leg *mission_advance(const struct mission *mission_ptr,	///< pointer to mission
+		int *next		///< cursor, index of the goal waypoint; starts at 1
+		);
+
+/// Returns 1 if the point (n, e) is within the capture radius of the goal waypoint.
+/*!
+ * \ingroup guidance_fcns
+*/
+int mission_reached(const struct mission *mission_ptr,	///< pointer to mission
+		int next,		///< cursor, index of the goal waypoint
+		double n,		///< [m], North position
+		double e		///< [m], East position
+		);
+
+#endif /* MISSION_H_ */
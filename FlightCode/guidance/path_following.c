@@ -0,0 +1,221 @@
+/*!	\file path_following.c
+ *	\brief Path following get_guidance law
+ *
+ *	\details Flies the waypoint mission along the line and arc path built by path_planner.c when the mission is loaded.
+ *	Each frame the aircraft position is projected onto the path and the heading error to a carrot point a lookahead
+ *	distance further along the path is commanded. Waypoints are relative distances from the point where the
+ *	autopilot is engaged, as for waypoint_guidance.c, and psi_cmd is the heading error expected by waypoint_tracker.c.
+ *	Per-aircraft state is kept in a context, see path_following.h. When the wind estimate moves by more than
+ *	MISSION_WIND_REPLAN the two turns ahead are resized, and the later ones as they come up (see path_replan());
+ *	the lookahead follows the measured ground speed. The predicted time to the end of the leg is logged on
+ *	controlData signal_4.
+ *
+ *	Altitude follows the terrain when DEM tiles are available (see navigation/terrain.h): h_cmd clears the highest
+ *	terrain under the aircraft and along the next TERRAIN_LOOKAHEAD_T seconds of path by the leg altitude of the
+ *	mission, and the tiles at the ends of the next two segments are prefetched. Without terrain h_cmd is left alone.
+ *	\ingroup guidance_fcns
+ *
+ * \author University of Minnesota
+ * \author Aerospace Engineering and Mechanics
+ * \copyright Copyright 2015 Regents of the University of Minnesota. All rights reserved.
+ *
+ * $Id$
+ */
+
+#include <math.h>
+
+#include "../globaldefs.h"
+#include "../utils/matrix.h"
+#include "../navigation/nav_functions.h"
+#include "guidance_interface.h"
+#include "mission.h"
+#include "path_planner.h"
+#include "path_following.h"
+#include "../navigation/terrain.h"
+
+#include AIRCRAFT_UP1DIR
+
+// Control parameters
+#define FTOL			20.0		// tolerance of feasability checking circle [m], unused by the path
+#define WPTOL			10.0		// tolerance for reaching waypoints [m], unused by the path
+#define PHI0			40*D2R		// considered maximum bank angle, sets the turn radius [rad]
+#define LOOKAHEAD_T		3.0			// carrot lead time [sec]
+#define LOOKAHEAD_MIN	30.0		// minimum carrot distance [m]
+#define TERRAIN_LOOKAHEAD_T	10.0	// terrain clearance lead time [sec]
+#define TERRAIN_SAMPLES		4		// terrain samples along the lead, besides the one under the aircraft
+
+static struct mission mission;
+static struct mission_wind wind;		// wind estimate the path is being replanned for
+static struct path path;
+static struct path_following_ctx flight_ctx;	// the instance flown by get_guidance
+
+static short guide_init=0;
+static double lat0_terrain=-1.0, dlat, dlon;	// [rad/m], North/East offsets to latitude/longitude at the engage point
+
+// local functions
+static void step(const struct path *path_ptr, struct path_following_ctx *ctx, const struct guidance_batch *batch, int i);
+static void terrain_follow(struct nav *navData_ptr, struct control *controlData_ptr);
+
+
+extern void get_guidance(double time, struct sensordata *sensorData_ptr, struct nav *navData_ptr, struct control *controlData_ptr){
+	struct guidance_batch batch;
+
+	if (time>0.05){
+	#ifdef AIRCRAFT_THOR
+		controlData_ptr->ias_cmd = 17;				//Trim airspeed (m/s)
+	#endif
+	#ifdef AIRCRAFT_TYR
+		controlData_ptr->ias_cmd = 17;				//Trim airspeed (m/s)
+	#endif
+	#ifdef AIRCRAFT_FASER
+		controlData_ptr->ias_cmd = 23;
+	#endif
+	#ifdef AIRCRAFT_IBIS
+		controlData_ptr->ias_cmd = 23;
+	#endif
+	#ifdef AIRCRAFT_BALDR
+		controlData_ptr->ias_cmd = 23;
+	#endif
+
+		// load the mission and plan the path in still air once; the turn radius follows the commanded airspeed
+		if (guide_init==0){
+			init_mission(&mission, controlData_ptr->ias_cmd, PHI0, FTOL, WPTOL, 0.0);
+			mission_set_wind(&mission, &wind, 0.0, 0.0);
+			init_path(&path, &mission, &wind);
+			init_path_following(&flight_ctx, 1);
+			init_terrain();
+			guide_init=1;
+		}
+
+		// resize the turns ahead for a materially different wind; the segment layout, and so the cursor, is kept
+		if (mission_wind_changed(&wind, navData_ptr->wind[0], navData_ptr->wind[1]))
+			mission_set_wind(&mission, &wind, navData_ptr->wind[0], navData_ptr->wind[1]);
+		path_replan(&path, &mission, &wind, flight_ctx.cursor);
+	}
+
+	// a batch of one on navData/controlData
+	batch.num = 1;
+	batch.time = &time;
+	batch.ias = &sensorData_ptr->adData_ptr->ias_filt;
+	batch.pos_n = &navData_ptr->ltp.pos_ned[0];
+	batch.pos_e = &navData_ptr->ltp.pos_ned[1];
+	batch.vn = &navData_ptr->vn;
+	batch.ve = &navData_ptr->ve;
+	batch.gndtrk = &navData_ptr->trig.gndtrk;
+	batch.gndspd = &navData_ptr->trig.gndspd;
+	batch.wind_n = &navData_ptr->wind[0];
+	batch.wind_e = &navData_ptr->wind[1];
+	batch.psi_cmd = &controlData_ptr->psi_cmd;
+	batch.r_cmd = &controlData_ptr->r_cmd;
+
+	path_following_batch(&path, &flight_ctx, &batch);
+	controlData_ptr->signal_4 = flight_ctx.eta;	// logged
+
+	if (time>0.05 && path.num > 0 && navData_ptr->ltp.valid)
+		terrain_follow(navData_ptr, controlData_ptr);
+}
+
+void init_path_following(struct path_following_ctx *ctx, int num){
+	int i;
+
+	for (i = 0; i < num; i++){
+		ctx[i].cursor = 0;
+		ctx[i].s = 0.0;
+		ctx[i].last_time = 0.0;
+		ctx[i].eta = 0.0;
+	}
+}
+
+void path_following_batch(const struct path *path_ptr, struct path_following_ctx *ctx, const struct guidance_batch *batch){
+	int i;
+
+	for (i = 0; i < batch->num; i++)
+		step(path_ptr, &ctx[i], batch, i);
+}
+
+/// One frame of instance i.
+static void step(const struct path *path_ptr, struct path_following_ctx *ctx, const struct guidance_batch *batch, int i){
+	const struct path_segment *seg, *end;
+	double s_path, lookahead, xT, yT, psiT, dpsi;
+	int iseg;
+
+	// restart from the launch point when the autopilot is re-engaged
+	if (batch->time[i] < ctx->last_time)
+		ctx->cursor = 0;
+	ctx->last_time = batch->time[i];
+
+	if (batch->time[i] <= 0.05)
+		return;
+
+	if (path_ptr->num == 0 || batch->ias[i] <= 10){	// no path, or airspeed filter not initialized
+		batch->psi_cmd[i] = 0;
+		return;
+	}
+
+	// project onto the path, then aim at the carrot further along it
+	s_path = path_project(path_ptr, &ctx->cursor, batch->pos_n[i], batch->pos_e[i]);
+	ctx->s = s_path;
+	lookahead = LOOKAHEAD_T*batch->gndspd[i];
+	if (lookahead < LOOKAHEAD_MIN) lookahead = LOOKAHEAD_MIN;
+	iseg = path_point(path_ptr, s_path + lookahead, &xT, &yT, &psiT);
+
+	psiT = atan2(yT - batch->pos_e[i], xT - batch->pos_n[i]);
+	dpsi = psiT - batch->gndtrk[i];
+	if (dpsi > PI) dpsi -= PI2;
+	else if (dpsi < -PI) dpsi += PI2;
+
+	// predicted time to the end of the leg: the cursor segment and, after a turn, the leg's line
+	seg = &path_ptr->seg[ctx->cursor];
+	end = seg;
+	if (ctx->cursor + 1 < path_ptr->num && seg[1].leg == seg->leg)
+		end = &seg[1];
+	ctx->eta = end->t0 + end->dur - seg->t0;
+	if (seg->len > 0.0)		// lines are of zero length where the fillets meet
+		ctx->eta -= seg->dur*(s_path - seg->s0)/seg->len;
+
+	batch->psi_cmd[i] = dpsi;
+	batch->r_cmd[i] = (path_ptr->seg[iseg].leg+1)*10 + path_ptr->seg[iseg].type;	// store the carrot leg and segment kind on r_cmd:
+																					// 0 -> line, 1 -> turn arc
+}
+
+/// Terrain following h_cmd for the instance flown by get_guidance, relative to the engage altitude.
+static void terrain_follow(struct nav *navData_ptr, struct control *controlData_ptr){
+	const struct path_segment *seg;
+	double n, e, psi, h, hmax = 0.0, lead;
+	int k, found = 0;
+
+	// flat earth scaling around the engage point, refreshed when the autopilot is engaged elsewhere
+	if (navData_ptr->ltp.lat0 != lat0_terrain){
+		lat0_terrain = navData_ptr->ltp.lat0;
+		dlat = 1.0/EARTH_RADIUS;
+		dlon = 1.0/(EARTH_RADIUS*cos(lat0_terrain));
+	}
+
+	lead = TERRAIN_LOOKAHEAD_T*navData_ptr->trig.gndspd;
+	for (k = 0; k <= TERRAIN_SAMPLES; k++){
+		if (k == 0){
+			n = navData_ptr->ltp.pos_ned[0];
+			e = navData_ptr->ltp.pos_ned[1];
+		}
+		else
+			path_point(&path, flight_ctx.s + k*lead/TERRAIN_SAMPLES, &n, &e, &psi);
+
+		if (terrain_height(navData_ptr->ltp.lat0 + n*dlat, navData_ptr->ltp.lon0 + e*dlon, &h) && (!found || h > hmax)){
+			hmax = h;
+			found = 1;
+		}
+	}
+
+	// tiles further along the route, loaded before the lookahead reaches them
+	for (k = 1; k <= 2; k++){
+		seg = &path.seg[(flight_ctx.cursor + k) % path.num];
+		terrain_prefetch(navData_ptr->ltp.lat0 + seg->n0*dlat, navData_ptr->ltp.lon0 + seg->e0*dlon);
+	}
+
+	if (found)
+		controlData_ptr->h_cmd = hmax + mission.leg[path.seg[flight_ctx.cursor].leg].alt - navData_ptr->ltp.alt0;
+}
+
+void close_guidance(void){
+	close_terrain();
+}
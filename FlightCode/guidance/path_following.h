@@ -0,0 +1,47 @@
+/*! \file path_following.h
+ *	\brief Path following guidance law context and batch interface
+ *
+ *	\details All per-aircraft state of path_following.c is held in a context, so one planned path can be flown
+ *	by many independent instances, e.g. Monte Carlo runs in a host-side simulator. A shared path is planned for
+ *	one wind; instances flying in different winds need their own missions and paths.
+ *	\ingroup guidance_fcns
+ *
+ * \author University of Minnesota
+ * \author Aerospace Engineering and Mechanics
+ * \copyright Copyright 2015 Regents of the University of Minnesota. All rights reserved.
+ *
+ * $Id$
+ */
+
+#ifndef PATH_FOLLOWING_H_
+#define PATH_FOLLOWING_H_
+
+#include "guidance_interface.h"
+#include "path_planner.h"
+
+/// Per-instance state of the path following law
+struct path_following_ctx {
+	int cursor;			///< path segment the aircraft was last projected onto
+	double s;			///< [m], arc length along the path of the last projection
+	double last_time;	///< [sec], time of the previous step, to detect the autopilot being re-engaged
+	double eta;			///< [sec], predicted time to the end of the current leg, in the planned wind; logged on signal_4
+};
+
+/// Reset num contexts to the start of the path.
+/*!
+ * \ingroup guidance_fcns
+*/
+void init_path_following(struct path_following_ctx *ctx,	///< array of num contexts
+		int num				///< number of instances
+		);
+
+/// Advance every instance of a batch by one frame along a shared path.
+/*!
+ * \ingroup guidance_fcns
+*/
+void path_following_batch(const struct path *path_ptr,	///< pointer to path, built by init_path
+		struct path_following_ctx *ctx,			///< array of batch->num contexts
+		const struct guidance_batch *batch		///< inputs and outputs
+		);
+
+#endif /* PATH_FOLLOWING_H_ */
@@ -0,0 +1,320 @@
+/*! \file path_planner.c
+ *	\brief Mission path planner
+ *
+ *	\details Line and arc path through the mission waypoints, see path_planner.h.
+ *	\ingroup guidance_fcns
+ *
+ * \author University of Minnesota
+ * \author Aerospace Engineering and Mechanics
+ * \copyright Copyright 2015 Regents of the University of Minnesota. All rights reserved.
+ *
+ * $Id$
+ */
+
+#include <math.h>
+
+#include "../globaldefs.h"
+#include "mission.h"
+#include "path_planner.h"
+
+// local functions
+static double wrap(double a);
+static double ground_speed(const struct mission *mission_ptr, const struct mission_wind *wind_ptr, double psi);
+static double arc_speed_max(const struct mission *mission_ptr, const struct mission_wind *wind_ptr, double psi0, double turn, double dpsi);
+static int locate(const struct path *path_ptr, double s);
+static void fillet(const struct mission *mission_ptr, const struct mission_wind *wind_ptr, const struct mission_leg *in, const struct mission_leg *out, double *R, double *d, double *dpsi, double *turn);
+static void set_line(struct path_segment *seg, const struct mission *mission_ptr, const struct mission_wind *wind_ptr, int leg, double n0, double e0, const struct mission_leg *l, double len);
+static void set_arc(struct path_segment *seg, const struct mission *mission_ptr, const struct mission_wind *wind_ptr, int leg, double n0, double e0, const struct mission_leg *l, double R, double turn, double dpsi);
+static void resize_fillet(struct path *path_ptr, const struct mission *mission_ptr, const struct mission_wind *wind_ptr, int a);
+static void accumulate(struct path *path_ptr);
+static double along(const struct path_segment *seg, double n, double e);
+
+int init_path(struct path *path_ptr, const struct mission *mission_ptr, const struct mission_wind *wind_ptr){
+	static int wp[MISSION_MAX_WAYPOINTS];	// waypoints with a nonzero incoming leg, in flight order
+	static double d[MISSION_MAX_WAYPOINTS];	// [m], fillet tangent distance at each of them
+	static double R[MISSION_MAX_WAYPOINTS];	// [m], fillet radius at each of them
+	static double dpsi[MISSION_MAX_WAYPOINTS];	// [rad], heading change at each of them
+	static double turn[MISSION_MAX_WAYPOINTS];	// turn direction at each of them
+	const struct mission_leg *in;
+	double n0, e0;
+	int i, j, k = 0;
+
+	path_ptr->num = 0;
+	path_ptr->length = 0.0;
+	path_ptr->duration = 0.0;
+
+	// flight order starts on leg 1, leaving the launch point; leg 0 closes the loop
+	for (i = 1; i <= mission_ptr->num; i++){
+		j = i % mission_ptr->num;
+		if (mission_ptr->leg[j].len > 0.0)
+			wp[k++] = j;
+	}
+	if (k < 2)
+		return 0;
+
+	// fillet at every waypoint, sized for the fastest ground speed along it and shrunk where the legs are too short
+	for (j = 0; j < k; j++)
+		fillet(mission_ptr, wind_ptr, &mission_ptr->leg[wp[j]], &mission_ptr->leg[wp[(j + 1) % k]], &R[j], &d[j], &dpsi[j], &turn[j]);
+
+	// every leg has its line, possibly of zero length where the fillets meet, so the segment layout does not
+	// depend on the wind and path_replan() can resize fillets in place
+	for (j = 0; j < k; j++){
+		in = &mission_ptr->leg[wp[j]];
+		i = (j == 0) ? k - 1 : j - 1;
+
+		// line from the end of the previous fillet to the start of this one
+		n0 = mission_ptr->leg[wp[i]].n + d[i]*in->un;
+		e0 = mission_ptr->leg[wp[i]].e + d[i]*in->ue;
+		set_line(&path_ptr->seg[path_ptr->num++], mission_ptr, wind_ptr, wp[j], n0, e0, in, in->len - d[i] - d[j]);
+
+		// fillet onto the next leg, none where the legs are in line
+		if (turn[j] != 0.0){
+			n0 = in->n - d[j]*in->un;
+			e0 = in->e - d[j]*in->ue;
+			set_arc(&path_ptr->seg[path_ptr->num++], mission_ptr, wind_ptr, wp[(j + 1) % k], n0, e0, in, R[j], turn[j], dpsi[j]);
+		}
+	}
+
+	accumulate(path_ptr);
+	return path_ptr->num;
+}
+
+int path_replan(struct path *path_ptr, const struct mission *mission_ptr, const struct mission_wind *wind_ptr, int cursor){
+	const struct path_segment *seg;
+	double dn, de;
+	int i, a = cursor, found = 0, resized = 0;
+
+	if (path_ptr->num == 0)
+		return 0;
+
+	// the next two fillets ahead of the cursor, not the one being flown
+	for (i = 1; i < path_ptr->num && found < 2; i++){
+		if (++a >= path_ptr->num)
+			a = 0;
+		seg = &path_ptr->seg[a];
+		if (seg->type != PATH_ARC)
+			continue;
+		found++;
+
+		dn = wind_ptr->wind_n - seg->wind_n;
+		de = wind_ptr->wind_e - seg->wind_e;
+		if (dn*dn + de*de > MISSION_WIND_REPLAN*MISSION_WIND_REPLAN){
+			resize_fillet(path_ptr, mission_ptr, wind_ptr, a);
+			resized++;
+		}
+	}
+
+	if (resized > 0)
+		accumulate(path_ptr);
+
+	return resized;
+}
+
+double path_project(const struct path *path_ptr, int *cursor, double n, double e){
+	const struct path_segment *seg;
+	double sigma = 0.0;
+	int i;
+
+	if (path_ptr->num == 0)
+		return 0.0;
+
+	for (i = 0; i < path_ptr->num; i++){
+		seg = &path_ptr->seg[*cursor];
+		sigma = along(seg, n, e);
+		if (sigma < seg->len)
+			break;
+		if (++(*cursor) >= path_ptr->num)
+			*cursor = 0;
+	}
+
+	seg = &path_ptr->seg[*cursor];
+	if (sigma < 0.0) sigma = 0.0;
+	else if (sigma > seg->len) sigma = seg->len;
+
+	return seg->s0 + sigma;
+}
+
+int path_point(const struct path *path_ptr, double s, double *n, double *e, double *psi){
+	const struct path_segment *seg;
+	double sigma;
+	int lo;
+
+	if (path_ptr->num == 0){
+		*n = *e = *psi = 0.0;
+		return 0;
+	}
+
+	s = fmod(s, path_ptr->length);
+	if (s < 0.0) s += path_ptr->length;
+
+	lo = locate(path_ptr, s);
+	seg = &path_ptr->seg[lo];
+	sigma = s - seg->s0;
+	if (seg->type == PATH_LINE){
+		*n = seg->n0 + sigma*seg->un;
+		*e = seg->e0 + sigma*seg->ue;
+		*psi = seg->psi0;
+	}
+	else{
+		*psi = seg->psi0 + seg->turn*sigma/seg->R;
+		*n = seg->cn + seg->turn*seg->R*sin(*psi);
+		*e = seg->ce - seg->turn*seg->R*cos(*psi);
+		*psi = wrap(*psi);
+	}
+
+	return lo;
+}
+
+/// Last segment starting at or before s (binary search).
+static int locate(const struct path *path_ptr, double s){
+	int lo = 0, hi = path_ptr->num - 1, mid;
+
+	while (lo < hi){
+		mid = (lo + hi + 1)/2;
+		if (path_ptr->seg[mid].s0 <= s) lo = mid;
+		else hi = mid - 1;
+	}
+	return lo;
+}
+
+/// Ground speed along track psi at the mission airspeed in the planned wind.
+static double ground_speed(const struct mission *mission_ptr, const struct mission_wind *wind_ptr, double psi){
+	double c = cos(psi), sn = sin(psi);
+	double along = wind_ptr->wind_n*c + wind_ptr->wind_e*sn;		// tailwind component
+	double cross = -wind_ptr->wind_n*sn + wind_ptr->wind_e*c;		// crosswind component, taken out by the crab angle
+	double v2 = mission_ptr->ias*mission_ptr->ias - cross*cross;
+	double vg = along + ((v2 > 0.0) ? sqrt(v2) : 0.0);
+
+	return (vg > 0.1*mission_ptr->ias) ? vg : 0.1*mission_ptr->ias;	// the wind estimate can exceed the airspeed
+}
+
+/// Highest ground speed over the tracks covered by an arc: downwind if the arc sweeps through it, else an end.
+static double arc_speed_max(const struct mission *mission_ptr, const struct mission_wind *wind_ptr, double psi0, double turn, double dpsi){
+	double w = sqrt(wind_ptr->wind_n*wind_ptr->wind_n + wind_ptr->wind_e*wind_ptr->wind_e);
+	double rel, v0, v1;
+
+	if (w <= 0.0)
+		return mission_ptr->ias;
+
+	rel = wrap(turn*(atan2(wind_ptr->wind_e, wind_ptr->wind_n) - psi0));
+	if (rel < 0.0) rel += PI2;
+	if (rel <= dpsi)
+		return mission_ptr->ias + w;
+
+	v0 = ground_speed(mission_ptr, wind_ptr, psi0);
+	v1 = ground_speed(mission_ptr, wind_ptr, psi0 + turn*dpsi);
+	return (v0 > v1) ? v0 : v1;
+}
+
+/// Wrap an angle to (-PI, PI].
+static double wrap(double a){
+	while (a > PI) a -= PI2;
+	while (a <= -PI) a += PI2;
+	return a;
+}
+
+/// Radius, tangent distance, heading change and direction of the fillet from leg in onto leg out.
+static void fillet(const struct mission *mission_ptr, const struct mission_wind *wind_ptr, const struct mission_leg *in, const struct mission_leg *out, double *R, double *d, double *dpsi, double *turn){
+	double cross, t, dmax, vg;
+
+	*dpsi = fabs(wrap(out->psi - in->psi));
+	cross = in->un*out->ue - in->ue*out->un;	// positive for a right turn
+	*turn = (cross > 0.0) ? 1.0 : ((cross < 0.0) ? -1.0 : 0.0);
+	t = tan(0.5*(*dpsi));
+
+	vg = arc_speed_max(mission_ptr, wind_ptr, in->psi, *turn, *dpsi);
+	*R = vg*vg/g/mission_ptr->tan_phi;
+	*d = (*R)*t;
+	if (*turn == 0.0){
+		*d = 0.0;		// legs in line, or a reversal handled as a point turn
+		return;
+	}
+	dmax = 0.5*((in->len < out->len) ? in->len : out->len);
+	if (*d > dmax){
+		*d = dmax;
+		*R = dmax/t;
+	}
+}
+
+static void set_line(struct path_segment *seg, const struct mission *mission_ptr, const struct mission_wind *wind_ptr, int leg, double n0, double e0, const struct mission_leg *l, double len){
+
+	seg->type = PATH_LINE;
+	seg->leg = leg;
+	seg->len = (len > 0.0) ? len : 0.0;		// zero where the fillets meet
+	seg->n0 = n0;
+	seg->e0 = e0;
+	seg->psi0 = l->psi;
+	seg->un = l->un;
+	seg->ue = l->ue;
+	seg->dur = seg->len/ground_speed(mission_ptr, wind_ptr, l->psi);
+}
+
+static void set_arc(struct path_segment *seg, const struct mission *mission_ptr, const struct mission_wind *wind_ptr, int leg, double n0, double e0, const struct mission_leg *l, double R, double turn, double dpsi){
+
+	seg->type = PATH_ARC;
+	seg->leg = leg;
+	seg->len = dpsi*R;
+	seg->n0 = n0;
+	seg->e0 = e0;
+	seg->psi0 = l->psi;
+	seg->un = l->un;
+	seg->ue = l->ue;
+	seg->R = R;
+	seg->turn = turn;
+	seg->cn = n0 - turn*R*l->ue;	// center is R to the side of the turn
+	seg->ce = e0 + turn*R*l->un;
+	seg->wind_n = wind_ptr->wind_n;
+	seg->wind_e = wind_ptr->wind_e;
+
+	// flight time by Simpson's rule over the ground speed along the arc
+	seg->dur = seg->len/6.0*(1.0/ground_speed(mission_ptr, wind_ptr, l->psi)
+			+ 4.0/ground_speed(mission_ptr, wind_ptr, l->psi + 0.5*turn*dpsi)
+			+ 1.0/ground_speed(mission_ptr, wind_ptr, l->psi + turn*dpsi));
+}
+
+/// Resize fillet a in the wind, moving the ends of the lines on either side of it.
+static void resize_fillet(struct path *path_ptr, const struct mission *mission_ptr, const struct mission_wind *wind_ptr, int a){
+	struct path_segment *arc = &path_ptr->seg[a];
+	struct path_segment *l1 = &path_ptr->seg[a - 1];	// an arc always follows the line of its leg
+	struct path_segment *l2 = &path_ptr->seg[(a + 1) % path_ptr->num];
+	const struct mission_leg *in = &mission_ptr->leg[l1->leg];
+	const struct mission_leg *out = &mission_ptr->leg[arc->leg];
+	double d_old, R, d, dpsi, turn;
+
+	d_old = (in->n - arc->n0)*in->un + (in->e - arc->e0)*in->ue;
+	fillet(mission_ptr, wind_ptr, in, out, &R, &d, &dpsi, &turn);
+
+	set_arc(arc, mission_ptr, wind_ptr, arc->leg, in->n - d*in->un, in->e - d*in->ue, in, R, turn, dpsi);
+	set_line(l1, mission_ptr, wind_ptr, l1->leg, l1->n0, l1->e0, in, l1->len + d_old - d);
+	set_line(l2, mission_ptr, wind_ptr, l2->leg, in->n + d*out->un, in->e + d*out->ue, out, l2->len + d_old - d);
+}
+
+/// Arc length and predicted time at the start of every segment, and the totals.
+static void accumulate(struct path *path_ptr){
+	int i;
+
+	path_ptr->length = 0.0;
+	path_ptr->duration = 0.0;
+	for (i = 0; i < path_ptr->num; i++){
+		path_ptr->seg[i].s0 = path_ptr->length;
+		path_ptr->seg[i].t0 = path_ptr->duration;
+		path_ptr->length += path_ptr->seg[i].len;
+		path_ptr->duration += path_ptr->seg[i].dur;
+	}
+}
+
+/// Arc length of the projection of (n, e) onto the segment, measured from its start and not clamped.
+static double along(const struct path_segment *seg, double n, double e){
+	double half, a;
+
+	if (seg->type == PATH_LINE)
+		return (n - seg->n0)*seg->un + (e - seg->e0)*seg->ue;
+
+	// heading of the path at the closest point of the circle, relative to the arc start, taken within
+	// half a turn of the arc midpoint so points past the end count as past the end
+	a = atan2(seg->turn*(n - seg->cn), -seg->turn*(e - seg->ce));
+	half = 0.5*seg->len/seg->R;
+	a = wrap(seg->turn*(a - seg->psi0) - half) + half;
+
+	return a*seg->R;
+}
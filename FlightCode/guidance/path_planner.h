@@ -0,0 +1,109 @@
+/*! \file path_planner.h
+ *	\brief Mission path planner interface header
+ *
+ *	\details Turns a waypoint mission into a closed path of straight lines joined by turn arcs (Dubins fillets)
+ *	at mission load. Every segment stores its cumulative arc length and predicted flight time, so in flight the
+ *	aircraft position is projected onto the path with a cursor search and any point along the path is found with
+ *	a binary search. Each arc is sized for the highest ground speed over the headings it covers in the wind it was
+ *	planned for; when the wind estimate changes, path_replan() resizes only the two fillets ahead of the aircraft,
+ *	and the others as the aircraft reaches them.
+ *	\ingroup guidance_fcns
+ *
+ * \author University of Minnesota
+ * \author Aerospace Engineering and Mechanics
+ * \copyright Copyright 2015 Regents of the University of Minnesota. All rights reserved.
+ *
+ * $Id$
+ */
+
+#ifndef PATH_PLANNER_H_
+#define PATH_PLANNER_H_
+
+#include "mission.h"
+
+#define PATH_MAX_SEGMENTS	(2*MISSION_MAX_WAYPOINTS)	///< one line and one arc per waypoint
+
+/// Segment kind
+enum path_segtype {
+	PATH_LINE,		///< straight line
+	PATH_ARC		///< constant radius turn
+};
+
+/// One path segment
+struct path_segment {
+	enum path_segtype type;	///< segment kind
+	int leg;				///< mission leg (goal waypoint index) the segment belongs to
+	double s0;				///< [m], arc length along the path at the start of the segment
+	double len;				///< [m], segment length
+	double n0, e0;			///< [m], start point, North/East of the launch point
+	double psi0;			///< [rad], path heading at the start point
+	double un, ue;			///< cos and sin of psi0
+	double cn, ce;			///< [m], turn center (arcs only)
+	double R;				///< [m], turn radius (arcs only)
+	double turn;			///< turn direction, +1 right, -1 left (arcs only)
+	double wind_n, wind_e;	///< [m/sec], North/East wind the fillet was sized for (arcs only)
+	double t0;				///< [sec], predicted flight time from the start of the path to the start of the segment
+	double dur;				///< [sec], predicted flight time of the segment in the planned wind
+};
+
+/// Closed mission path. Only path_replan() changes it once built; every aircraft following it keeps its own cursor.
+struct path {
+	struct path_segment seg[PATH_MAX_SEGMENTS];	///< segments in flight order
+	int num;			///< number of segments
+	double length;		///< [m], total path length
+	double duration;	///< [sec], predicted time to fly the whole path in the planned wind
+};
+
+/// Build the path for a loaded mission in a wind.
+/*!
+ * Each waypoint is rounded with an arc tangent to both legs, with the radius needed at the maximum bank for the
+ * highest ground speed along the arc. Where two legs are too short for that arc, the radius is reduced so the
+ * arc still fits. Zero length legs are dropped. Every leg keeps its line, of zero length where the fillets meet.
+ * \return number of segments
+ * \ingroup guidance_fcns
+*/
+int init_path(struct path *path_ptr,			///< pointer to path
+		const struct mission *mission_ptr,		///< pointer to loaded mission
+		const struct mission_wind *wind_ptr		///< wind to plan for
+		);
+
+/// Resize the two fillets ahead of the cursor if they were sized for a wind more than MISSION_WIND_REPLAN away.
+/*!
+ * Only those fillets and the lines on either side of them are recomputed, then the arc lengths and times are
+ * summed again; a fillet further along is resized when it becomes one of the two ahead. Cheap when nothing
+ * changed, so it can be called every frame.
+ * \return number of fillets resized
+ * \ingroup guidance_fcns
+*/
+int path_replan(struct path *path_ptr,			///< pointer to path
+		const struct mission *mission_ptr,		///< pointer to loaded mission
+		const struct mission_wind *wind_ptr,	///< current wind estimate
+		int cursor		///< segment the aircraft is on
+		);
+
+/// Project a point onto the path.
+/*!
+ * Starts from the cursor segment and only moves forward, so the projection follows the mission order and costs
+ * O(1) amortized per frame.
+ * \return [m], arc length along the path of the projected point
+ * \ingroup guidance_fcns
+*/
+double path_project(const struct path *path_ptr,	///< pointer to path
+		int *cursor,	///< segment the aircraft was last projected onto; start at 0
+		double n,		///< [m], North position
+		double e		///< [m], East position
+		);
+
+/// Point and heading at arc length s along the path, wrapping around the closed path.
+/*!
+ * \return index of the segment holding the point
+ * \ingroup guidance_fcns
+*/
+int path_point(const struct path *path_ptr,	///< pointer to path
+		double s,		///< [m], arc length along the path
+		double *n,		///< [m], North position of the point
+		double *e,		///< [m], East position of the point
+		double *psi		///< [rad], path heading at the point
+		);
+
+#endif /* PATH_PLANNER_H_ */
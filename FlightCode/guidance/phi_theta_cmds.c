@@ -174,3 +174,7 @@ extern void get_guidance(double time, struct sensordata *sensorData_ptr, struct
                                 break;
         }
 }
+
+void close_guidance(void){
+	// nothing allocated
+}
@@ -18,6 +18,7 @@
 #include "../globaldefs.h"
 #include "../system_id/systemid_interface.h"
 #include "guidance_interface.h"
+#include "../control/control_blocks.h"
 
 //#include "../aircraft/thor_config.h"
 //#include "../aircraft/ibis_config.h"
@@ -27,25 +28,15 @@
 static void filter_trim(double *filt_inp, struct control *controlData_ptr, double time);
 
 /////////////// filters to compute real trim condition/////////////////////
-//filtered surface control signals
-static double da_filt_u[3]={AILERON_TRIM,0,0};
-static double da_filt_y[3]={0,0,0};
+//second order low pass filters on the surface control signals, b = {0, 0.000197483985377198, 0.000194998290973465},
+//a = {1, -1.962320458614849, 0.962712940891200}, started as if the input two frames back was the trim value
+#define TRIM_FILTER(trim)	{0, 0.000197483985377198, 0.000194998290973465, -1.962320458614849, 0.962712940891200, \
+							 0.000194998290973465*(trim), 0}
 
-static double de_filt_u[3]={ELEVATOR_TRIM,0,0};
-static double de_filt_y[3]={0,0,0};
-
-static double dr_filt_u[3]={RUDDER_TRIM,0,0};
-static double dr_filt_y[3]={0,0,0};
-
-static double dthr_filt_u[3]={THROTTLE_TRIM,0,0};
-static double dthr_filt_y[3]={0,0,0};
-
-//filter coefficients
-static double b_filt[3]={ 0,   0.000197483985377198,   0.000194998290973465};
-static double a_filt[3]={ 1.000000000000000,  -1.962320458614849,   0.962712940891200};
-
-//order of filters
-static int l=2; 
+static struct biquad da_filt = TRIM_FILTER(AILERON_TRIM);
+static struct biquad de_filt = TRIM_FILTER(ELEVATOR_TRIM);
+static struct biquad dr_filt = TRIM_FILTER(RUDDER_TRIM);
+static struct biquad dthr_filt = TRIM_FILTER(THROTTLE_TRIM);
 
 //filtered signals
 static double filt_inp[4]={0,0,0,0};
@@ -325,45 +316,13 @@ extern void get_guidance(double time, struct sensordata *sensorData_ptr, struct
 
 void filter_trim (double *filt_inp, struct control *controlData_ptr, double time)
 {
-
-    int i=0;
-    //double tt=time;
-    
-    // aileron filtering
-    da_filt_u[l]=controlData_ptr->da_r;
-	da_filt_y[l]=b_filt[0]*da_filt_u[l] + b_filt[1]*da_filt_u[l-1] + b_filt[2]*da_filt_u[l-2]- a_filt[1]*da_filt_y[l-1] - a_filt[2]*da_filt_y[l-2];
-    
-    // elevator filtering
-    de_filt_u[l]=controlData_ptr->de;
-	de_filt_y[l]=b_filt[0]*de_filt_u[l] + b_filt[1]*de_filt_u[l-1] + b_filt[2]*de_filt_u[l-2] - a_filt[1]*de_filt_y[l-1] - a_filt[2]*de_filt_y[l-2];
-    
-    // rudder filtering
-    dr_filt_u[l]=controlData_ptr->dr;
-	dr_filt_y[l]=b_filt[0]*dr_filt_u[l] + b_filt[1]*dr_filt_u[l-1] + b_filt[2]*dr_filt_u[l-2] - a_filt[1]*dr_filt_y[l-1] - a_filt[2]*dr_filt_y[l-2];
-
-    // throttle filtering
-    dthr_filt_u[l]=controlData_ptr->dthr;
-	dthr_filt_y[l]=b_filt[0]*dthr_filt_u[l] + b_filt[1]*dthr_filt_u[l-1] + b_filt[2]*dthr_filt_u[l-2] - a_filt[1]*dthr_filt_y[l-1]- a_filt[2]*dthr_filt_y[l-2];
-
     //filtered value: will be used at 9.5
-    filt_inp[0]=da_filt_y[l];
-    filt_inp[1]=de_filt_y[l];
-    filt_inp[2]=dr_filt_y[l];
-    filt_inp[3]=dthr_filt_y[l];
-    
-    
-    //fprintf(rudder, "%f\n %f\n",tt,filt_inp[2]);
-    
-    //update time history
-    for (i=0; i<l; i++)
-    {
-        da_filt_u[i]=da_filt_u[i+1];
-        da_filt_y[i]=da_filt_y[i+1];
-        de_filt_u[i]=de_filt_u[i+1];
-        de_filt_y[i]=de_filt_y[i+1];
-        dr_filt_u[i]=dr_filt_u[i+1];
-        dr_filt_y[i]=dr_filt_y[i+1];
-        dthr_filt_u[i]=dthr_filt_u[i+1];
-        dthr_filt_y[i]=dthr_filt_y[i+1];
-    }
+    filt_inp[0]=biquad_step(&da_filt, controlData_ptr->da_r);     // aileron filtering
+    filt_inp[1]=biquad_step(&de_filt, controlData_ptr->de);       // elevator filtering
+    filt_inp[2]=biquad_step(&dr_filt, controlData_ptr->dr);       // rudder filtering
+    filt_inp[3]=biquad_step(&dthr_filt, controlData_ptr->dthr);   // throttle filtering
+}
+
+void close_guidance(void){
+	// nothing allocated
 }
@@ -17,75 +17,42 @@
 #include "../globaldefs.h"
 #include "../system_id/systemid_interface.h"
 #include "guidance_interface.h"
+#include "schedule.h"
 
 
+// Series of 90 deg heading steps; altitude and airspeed commands held at zero
+// order: start [sec], duration [sec], channel, value, interpolation
+static const struct sched_segment rectangle_schedule[] = {
+	{0,	5,	SCHED_PSI,	0,			SCHED_STEP},
+	{0,	SCHED_OPEN,	SCHED_H,	0,	SCHED_STEP},
+	{0,	SCHED_OPEN,	SCHED_IAS,	0,	SCHED_STEP},
+	{5,	8,	SCHED_PSI,	90*D2R,	SCHED_STEP},
+	{13,	8,	SCHED_PSI,	180*D2R,	SCHED_STEP},
+	{21,	8,	SCHED_PSI,	270*D2R,	SCHED_STEP},
+	{29,	8,	SCHED_PSI,	360*D2R,	SCHED_STEP},
+	{37,	8,	SCHED_PSI,	(360+90)*D2R,	SCHED_STEP},
+	{45,	8,	SCHED_PSI,	(360+180)*D2R,	SCHED_STEP},
+	{53,	8,	SCHED_PSI,	(360+270)*D2R,	SCHED_STEP},
+	{61,	8,	SCHED_PSI,	(2*360)*D2R,	SCHED_STEP},
+	{69,	8,	SCHED_PSI,	(2*360+90)*D2R,	SCHED_STEP},
+	{77,	8,	SCHED_PSI,	(2*360+180)*D2R,	SCHED_STEP},
+	{85,	8,	SCHED_PSI,	(2*360+270)*D2R,	SCHED_STEP},
+	{93,	27,	SCHED_PSI,	(2*360+360)*D2R,	SCHED_STEP}
+};
+
+static struct schedule sched;
+static short sched_init = 0;
+
 extern void get_guidance(double time, struct sensordata *sensorData_ptr, struct nav *navData_ptr, struct control *controlData_ptr){
 
-				if( time >= 0 && time < 5){
-					controlData_ptr->psi_cmd = 0;
-					controlData_ptr->h_cmd = 0;
-					controlData_ptr->ias_cmd = 0;
-				}
-				if( time >= 5 && time < 13){
-					controlData_ptr->psi_cmd = 90*D2R;
-					controlData_ptr->h_cmd = 0;
-					controlData_ptr->ias_cmd = 0;
-				}
-				if( time >= 13 && time < 21){
-					controlData_ptr->psi_cmd = 180*D2R;
-					controlData_ptr->h_cmd = 0;
-					controlData_ptr->ias_cmd = 0;
-				}
-				if( time >= 21 && time < 29){
-					controlData_ptr->psi_cmd = 270*D2R;
-					controlData_ptr->h_cmd = 0;
-					controlData_ptr->ias_cmd = 0;
-				}
-				if( time >= 29 && time < 37){
-					controlData_ptr->psi_cmd = 360*D2R;
-					controlData_ptr->h_cmd = 0;
-					controlData_ptr->ias_cmd = 0;
-				}
-				if( time >= 37 && time < 45){
-					controlData_ptr->psi_cmd = (360+90)*D2R;
-					controlData_ptr->h_cmd = 0;
-					controlData_ptr->ias_cmd = 0;
-				}
-				if( time >= 45 && time < 53){
-					controlData_ptr->psi_cmd = (360+180)*D2R;
-					controlData_ptr->h_cmd = 0;
-					controlData_ptr->ias_cmd = 0;
-				}
-				if( time >= 53 && time < 61){
-					controlData_ptr->psi_cmd = (360+270)*D2R;
-					controlData_ptr->h_cmd = 0;
-					controlData_ptr->ias_cmd = 0;
-				}
-				if( time >= 61 && time < 69){
-					controlData_ptr->psi_cmd = (2*360)*D2R;
-					controlData_ptr->h_cmd = 0;
-					controlData_ptr->ias_cmd = 0;
-				}
-				if( time >= 69 && time < 77){
-					controlData_ptr->psi_cmd = (2*360+90)*D2R;
-					controlData_ptr->h_cmd = 0;
-					controlData_ptr->ias_cmd = 0;
-				}
-				if( time >= 77 && time < 85){
-					controlData_ptr->psi_cmd = (2*360+180)*D2R;
-					controlData_ptr->h_cmd = 0;
-					controlData_ptr->ias_cmd = 0;
-				}
-				if( time >= 85 && time < 93){
-					controlData_ptr->psi_cmd = (2*360+270)*D2R;
-					controlData_ptr->h_cmd = 0;
-					controlData_ptr->ias_cmd = 0;
-				}
-				if( time >= 93 && time < 120){
-					controlData_ptr->psi_cmd = (2*360+360)*D2R;
-					controlData_ptr->h_cmd = 0;
-					controlData_ptr->ias_cmd = 0;
-				}
+	if (sched_init == 0){
+		init_schedule(&sched, rectangle_schedule, sizeof(rectangle_schedule)/sizeof(rectangle_schedule[0]), SCHEDULE_FILE);
+		sched_init = 1;
+	}
 
+	run_schedule(&sched, time, controlData_ptr);
 }
 
+void close_guidance(void){
+	// nothing allocated
+}
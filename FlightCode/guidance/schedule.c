@@ -0,0 +1,148 @@
+/*! \file schedule.c
+ *	\brief Maneuver schedule engine
+ *
+ *	\details Segment tables with a monotonic cursor, see schedule.h.
+ *	\ingroup guidance_fcns
+ *
+ * \author University of Minnesota
+ * \author Aerospace Engineering and Mechanics
+ * \copyright Copyright 2015 Regents of the University of Minnesota. All rights reserved.
+ *
+ * $Id$
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "../globaldefs.h"
+#include "schedule.h"
+
+static const char *channel_names[SCHED_NUM_CHANNELS] = {"phi", "theta", "psi", "h", "ias"};
+
+// local functions
+static int load_schedule(struct schedule *sched_ptr, const char *filename);
+static void sort_schedule(struct schedule *sched_ptr);
+static void reset_cursor(struct schedule *sched_ptr);
+static double *channel(struct control *controlData_ptr, enum sched_channel ch);
+
+int init_schedule(struct schedule *sched_ptr, const struct sched_segment *builtin, int num, const char *filename){
+	int i;
+
+	if (filename == NULL || load_schedule(sched_ptr, filename) == 0){
+		if (num > SCHEDULE_MAX_SEGMENTS) num = SCHEDULE_MAX_SEGMENTS;
+		for (i = 0; i < num; i++)
+			sched_ptr->seg[i] = builtin[i];
+		sched_ptr->num = num;
+	}
+
+	sort_schedule(sched_ptr);
+	reset_cursor(sched_ptr);
+
+	return sched_ptr->num;
+}
+
+void run_schedule(struct schedule *sched_ptr, double time, struct control *controlData_ptr){
+	struct sched_segment *seg;
+	double *cmd, frac;
+	int ch;
+
+	if (time < sched_ptr->last_time)
+		reset_cursor(sched_ptr);
+	sched_ptr->last_time = time;
+
+	// start every segment whose start time has passed
+	while (sched_ptr->cursor < sched_ptr->num && sched_ptr->seg[sched_ptr->cursor].start <= time){
+		seg = &sched_ptr->seg[sched_ptr->cursor];
+		sched_ptr->active[seg->channel] = sched_ptr->cursor;
+		sched_ptr->from[seg->channel] = *channel(controlData_ptr, seg->channel);
+		sched_ptr->cursor++;
+	}
+
+	for (ch = 0; ch < SCHED_NUM_CHANNELS; ch++){
+		if (sched_ptr->active[ch] < 0)
+			continue;	// hold the last value
+
+		seg = &sched_ptr->seg[sched_ptr->active[ch]];
+		cmd = channel(controlData_ptr, (enum sched_channel)ch);
+
+		if (seg->duration >= 0.0 && time >= seg->start + seg->duration){
+			// segment over: leave the final value in place
+			*cmd = seg->value;
+			sched_ptr->active[ch] = -1;
+		}
+		else if (seg->interp == SCHED_RAMP && seg->duration > 0.0){
+			frac = (time - seg->start)/seg->duration;
+			*cmd = sched_ptr->from[ch] + frac*(seg->value - sched_ptr->from[ch]);
+		}
+		else{
+			*cmd = seg->value;
+		}
+	}
+}
+
+/// Read a schedule file. Returns the number of segments loaded.
+static int load_schedule(struct schedule *sched_ptr, const char *filename){
+	FILE *fp;
+	char line[128], chname[16], interp[16];
+	struct sched_segment *seg;
+	int num = 0, ch;
+
+	if ((fp = fopen(filename, "r")) == NULL)
+		return 0;
+
+	while (fgets(line, sizeof(line), fp) != NULL && num < SCHEDULE_MAX_SEGMENTS){
+		seg = &sched_ptr->seg[num];
+		if (sscanf(line, "%lf %lf %15s %lf %15s", &seg->start, &seg->duration, chname, &seg->value, interp) != 5)
+			continue;	// blank line or comment
+
+		for (ch = 0; ch < SCHED_NUM_CHANNELS; ch++){
+			if (strcmp(chname, channel_names[ch]) == 0)
+				break;
+		}
+		if (ch == SCHED_NUM_CHANNELS)
+			continue;
+
+		seg->channel = (enum sched_channel)ch;
+		seg->interp = (strcmp(interp, "ramp") == 0) ? SCHED_RAMP : SCHED_STEP;
+		if (seg->duration < 0.0) seg->duration = SCHED_OPEN;
+		if (ch == SCHED_PHI || ch == SCHED_THETA || ch == SCHED_PSI)
+			seg->value *= D2R;
+		num++;
+	}
+	fclose(fp);
+
+	sched_ptr->num = num;
+	return num;
+}
+
+/// Stable insertion sort by start time, so segments that start together keep their file order.
+static void sort_schedule(struct schedule *sched_ptr){
+	struct sched_segment tmp;
+	int i, j;
+
+	for (i = 1; i < sched_ptr->num; i++){
+		tmp = sched_ptr->seg[i];
+		for (j = i; j > 0 && sched_ptr->seg[j-1].start > tmp.start; j--)
+			sched_ptr->seg[j] = sched_ptr->seg[j-1];
+		sched_ptr->seg[j] = tmp;
+	}
+}
+
+static void reset_cursor(struct schedule *sched_ptr){
+	int ch;
+
+	sched_ptr->cursor = 0;
+	sched_ptr->last_time = 0.0;
+	for (ch = 0; ch < SCHED_NUM_CHANNELS; ch++)
+		sched_ptr->active[ch] = -1;
+}
+
+static double *channel(struct control *controlData_ptr, enum sched_channel ch){
+	switch (ch){
+		case SCHED_PHI:		return &controlData_ptr->phi_cmd;
+		case SCHED_THETA:	return &controlData_ptr->theta_cmd;
+		case SCHED_PSI:		return &controlData_ptr->psi_cmd;
+		case SCHED_H:		return &controlData_ptr->h_cmd;
+		default:			return &controlData_ptr->ias_cmd;
+	}
+}
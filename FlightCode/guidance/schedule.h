@@ -0,0 +1,89 @@
+/*! \file schedule.h
+ *	\brief Maneuver schedule engine interface header
+ *
+ *	\details A schedule is a table of segments sorted by start time. Each segment drives one command channel,
+ *	either holding a value (step) or ramping linearly to it over its duration. A cursor advances monotonically
+ *	through the table, so a frame costs O(1) amortized regardless of schedule length. Outside its segments a
+ *	channel keeps its last value.
+ *	\ingroup guidance_fcns
+ *
+ * \author University of Minnesota
+ * \author Aerospace Engineering and Mechanics
+ * \copyright Copyright 2015 Regents of the University of Minnesota. All rights reserved.
+ *
+ * $Id$
+ */
+
+#ifndef SCHEDULE_H_
+#define SCHEDULE_H_
+
+#ifndef SCHEDULE_MAX_SEGMENTS
+	#define SCHEDULE_MAX_SEGMENTS	256		///< capacity of a schedule
+#endif
+
+#ifndef SCHEDULE_FILE
+	#define SCHEDULE_FILE	"schedule.txt"	///< schedule loaded by the scheduled guidance laws, if present
+#endif
+
+#define SCHED_OPEN	-1.0	///< duration of a segment that stays active until a later segment on its channel
+
+/// Command channels a schedule can drive
+enum sched_channel {
+	SCHED_PHI,			///< controlData->phi_cmd [rad]
+	SCHED_THETA,		///< controlData->theta_cmd [rad]
+	SCHED_PSI,			///< controlData->psi_cmd [rad]
+	SCHED_H,			///< controlData->h_cmd [m]
+	SCHED_IAS,			///< controlData->ias_cmd [m/sec]
+	SCHED_NUM_CHANNELS
+};
+
+/// Segment interpolation
+enum sched_interp {
+	SCHED_STEP,			///< hold the value for the whole segment
+	SCHED_RAMP			///< ramp linearly from the channel's value at segment start to the value at segment end
+};
+
+/// One schedule segment
+struct sched_segment {
+	double start;				///< [sec], start time
+	double duration;			///< [sec], duration, or SCHED_OPEN
+	enum sched_channel channel;	///< command channel
+	double value;				///< target value, in the channel's units
+	enum sched_interp interp;	///< interpolation kind
+};
+
+/// Schedule and its cursor
+struct schedule {
+	struct sched_segment seg[SCHEDULE_MAX_SEGMENTS];	///< segments, sorted by start time
+	int num;								///< number of segments
+	int cursor;								///< next segment to start
+	int active[SCHED_NUM_CHANNELS];			///< active segment per channel, -1 if none
+	double from[SCHED_NUM_CHANNELS];		///< channel value when its active segment started, for ramps
+	double last_time;						///< [sec], time of the previous call, to detect a restart
+};
+
+/// Initialize a schedule from a file, falling back to a built-in table.
+/*!
+ * File format: one segment per line, "start duration channel value interp", with channel one of
+ * phi, theta, psi, h, ias, angles in degrees, interp step or ramp, and duration -1 for open-ended.
+ * '#' starts a comment. Segments are sorted by start time.
+ * \return number of segments
+ * \ingroup guidance_fcns
+*/
+int init_schedule(struct schedule *sched_ptr,			///< pointer to schedule
+		const struct sched_segment *builtin,	///< built-in segments, used if the file is missing or empty
+		int num,								///< number of built-in segments
+		const char *filename					///< schedule file, or NULL for the built-in table only
+		);
+
+/// Write the scheduled commands for this frame into controlData.
+/*!
+ * The schedule restarts from the beginning whenever time goes backwards (autopilot re-engaged).
+ * \ingroup guidance_fcns
+*/
+void run_schedule(struct schedule *sched_ptr,		///< pointer to schedule
+		double time,						///< [sec], time since in autopilot mode
+		struct control *controlData_ptr		///< pointer to controlData structure
+		);
+
+#endif /* SCHEDULE_H_ */
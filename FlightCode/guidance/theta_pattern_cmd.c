@@ -17,52 +17,41 @@
 #include "../globaldefs.h"
 #include "../system_id/systemid_interface.h"
 #include "guidance_interface.h"
-
+#include "schedule.h"
+
+
+// Pitch angle pattern at constant roll angle
+// order: start [sec], duration [sec], channel, value, interpolation
+static const struct sched_segment theta_schedule[] = {
+	{0,	2,	SCHED_THETA,	0,	SCHED_STEP},
+	{0,	2,	SCHED_PHI,	0,	SCHED_STEP},
+	{2,	1.5,	SCHED_THETA,	-2*D2R,	SCHED_STEP},
+	{3.5,	1.5,	SCHED_THETA,	4*D2R,	SCHED_STEP},
+	{5,	1,	SCHED_THETA,	-1*D2R,	SCHED_STEP},
+	{6,	2,	SCHED_THETA,	-3*D2R,	SCHED_STEP},
+	{8,	2,	SCHED_THETA,	4*D2R,	SCHED_STEP},
+	{10,	1,	SCHED_THETA,	6*D2R,	SCHED_STEP},
+	{11,	2,	SCHED_THETA,	0,	SCHED_STEP},
+	{13,	1.5,	SCHED_THETA,	-5*D2R,	SCHED_STEP},
+	{14.5,	0.5,	SCHED_THETA,	2*D2R,	SCHED_STEP},
+	{15,	1.5,	SCHED_THETA,	-3*D2R,	SCHED_STEP},
+	{16.5,	1,	SCHED_THETA,	1*D2R,	SCHED_STEP},
+	{17.5,	7.5,	SCHED_THETA,	0,	SCHED_STEP}
+};
+
+static struct schedule sched;
+static short sched_init = 0;
 
 extern void get_guidance(double time, struct sensordata *sensorData_ptr, struct nav *navData_ptr, struct control *controlData_ptr){
 
+	if (sched_init == 0){
+		init_schedule(&sched, theta_schedule, sizeof(theta_schedule)/sizeof(theta_schedule[0]), SCHEDULE_FILE);
+		sched_init = 1;
+	}
 
-                                if( time >= 0 && time < 2){
-                                        controlData_ptr->theta_cmd =    0;
-                                        controlData_ptr->phi_cmd =      0;
-                                }
-                                if( time >= 2 && time < 3.5){
-                                        controlData_ptr->theta_cmd =      -2*D2R;
-                                }
-                                if( time >= 3.5 && time < 5){
-                                        controlData_ptr->theta_cmd =      4*D2R;
-                                }
-                                if( time >= 5 && time < 6){
-                                        controlData_ptr->theta_cmd =      -1*D2R;
-                                }
-                                if( time >= 6 && time < 8){
-                                        controlData_ptr->theta_cmd =      -3*D2R;
-                                }
-                                if( time >= 8 && time < 10){
-                                        controlData_ptr->theta_cmd =      4*D2R;
-                                }
-                                if( time >= 10 && time < 11){
-                                        controlData_ptr->theta_cmd =      6*D2R;
-                                }   
-                                if( time >= 11 && time < 13){
-                                        controlData_ptr->theta_cmd =      0;
-                                }
-								if( time >= 13 && time < 14.5){
-                                        controlData_ptr->theta_cmd =      -5*D2R;
-                                }
-						     	if( time >= 14.5 && time < 15){
-                                        controlData_ptr->theta_cmd =      2*D2R;
-                                }
-						     	if( time >= 15 && time < 16.5){
-                                        controlData_ptr->theta_cmd =      -3*D2R;
-                                }
-								if( time >= 16.5 && time < 17.5){
-                                        controlData_ptr->theta_cmd =      1*D2R;
-                                }
-                                if( time >= 17.5 && time < 25){
-                                        controlData_ptr->theta_cmd =      0;
-                                }
-
-                                
+	run_schedule(&sched, time, controlData_ptr);
+}
 
+void close_guidance(void){
+	// nothing allocated
 }
@@ -17,8 +17,9 @@
 
 #include "../globaldefs.h"
 #include "../system_id/systemid_interface.h"
-#include "../utils/matrix.h"
 #include "guidance_interface.h"
+#include "mission.h"
+#include "waypoint_guidance.h"
 #include "../navigation/nav_functions.h"
 
 //////////////////////////////////////////////////////////////
@@ -32,28 +33,24 @@
 
 
 //local function definition
-void LatLonAltToEcef2(MATRIX vector, MATRIX position);
-double distance2waypoint(MATRIX wp_curr, MATRIX pos_ned);
 double mysign(double v);
 
-//////////////////////////////////////////////////////////////
-// Waypoint definition
-#define numofwaypoints 6
-static short nextwaypoint=1;
-
-// order: NO, EA, IAS, alt
-// FISRT ROW MUST BE {0, 0, IAS, alt} !!!!
-
-static double waypoints[numofwaypoints][4] =    {{0, 0, 20.0, 60.0},
-{0, 200, 20.0, 60.0},
-{120, 200, 20.0, 60.0},
-{80, 170, 20.0, 60.0},
-{160, 90, 20.0, 60.0},
-{120, 0, 20.0, 60.0}
+// aircraft state of one frame, shared by the local functions
+struct wp_frame {
+    const struct mission_leg *leg;      // current leg, ends at the goal waypoint
+    double xA, yA, vn, ve, cpsi, spsi;  // position, velocity and ground track unit vector
+    struct waypoint_ctx *ctx;           // instance state, holds the turn center
 };
 
+static void step(const struct mission *mission_ptr, struct waypoint_ctx *ctx, const struct guidance_batch *batch, int i);
+static void turn_center(struct wp_frame *f);
+static int feasible(const struct wp_frame *f);
+static void circle_target(const struct wp_frame *f, double *xT, double *yT);
 
-
+//////////////////////////////////////////////////////////////
+// Waypoint definition: loaded from MISSION_FILE at initialization, see mission.c
+static struct mission mission;
+static struct waypoint_ctx flight_ctx;	// the instance flown by get_guidance
 
 // Control parameters
 #define LTOL    10.0        // tolerance of linear segment tracking [deg]
@@ -61,19 +58,14 @@ static double waypoints[numofwaypoints][4] =    {{0, 0, 20.0, 60.0},
 #define WPTOL   10.0        // tolerance for reaching waypoints [m]
 #define PHI0    40*D2R  	// considered maximum bank angle [deg]
 #define s       75.0      	// forward arc length in circular path tracking [m]
-#define k_R     1    		// circle radius scaling
 
 
 //local variables
-static MATRIX pos_lla, pos_ecef, pos_ecef0, T_ecef2ned, v_ned, tmp31, pos_ned, WP_goal, WP_prev;
-
-static short guide_init=0, guide_start=0;   // init for initialization of matrices, start for start of waypoint guidance
-
-static short pinit=0, lc=10;  
-static double d2WP, xA, yA, xT, yT, xC, yC, psiT, dpsi, psi, Rt, R2, psiC;
+static short guide_init=0;   // init for loading the mission
 
 
 extern void get_guidance(double time, struct sensordata *sensorData_ptr, struct nav *navData_ptr, struct control *controlData_ptr){
+	struct guidance_batch batch;
 
 if (time>0.05){
 	#ifdef AIRCRAFT_THOR
@@ -95,84 +87,100 @@ if (time>0.05){
 	// Initialization of algorithm and variables	
     if (guide_init==0)  // init variables
     {
-        pos_lla     = mat_creat(3,1,ZERO_MATRIX);
-        pos_ecef    = mat_creat(3,1,ZERO_MATRIX);
-        pos_ecef0   = mat_creat(3,1,ZERO_MATRIX);
-        v_ned       = mat_creat(3,1,ZERO_MATRIX);
-        pos_ned     = mat_creat(3,1,ZERO_MATRIX);
-        tmp31       = mat_creat(3,1,ZERO_MATRIX);
-        T_ecef2ned  = mat_creat(3,3,ZERO_MATRIX);        
-        WP_goal     = mat_creat(2,1,ZERO_MATRIX);
-        WP_prev     = mat_creat(2,1,ZERO_MATRIX);
+        // load the mission; the turn radius and feasibility circle follow the commanded airspeed and the wind
+        init_mission(&mission, controlData_ptr->ias_cmd, PHI0, FTOL, WPTOL, s);
+        init_waypoint_guidance(&mission, &flight_ctx, 1);
         guide_init=1;
     }	    
-    
 
-	if (guide_start==0)		
-	{
-		pos_lla[0][0]=navData_ptr->lat;
-		pos_lla[1][0]=navData_ptr->lon;
-		pos_lla[2][0]=navData_ptr->alt;
-
-		LatLonAltToEcef2(pos_ecef0, pos_lla);
-
-		// transformation matrix for LaunchPoint ECEF |--> NED for initial point
-		T_ecef2ned[0][0] = -sin(pos_lla[0][0])*cos(pos_lla[1][0]); T_ecef2ned[0][1] = -sin(pos_lla[0][0])*sin(pos_lla[1][0]); T_ecef2ned[0][2] =  cos(pos_lla[0][0]);
-		T_ecef2ned[1][0] = -sin(pos_lla[1][0]);                    T_ecef2ned[1][1] =  cos(pos_lla[1][0]);                    T_ecef2ned[1][2] =  0.0;
-		T_ecef2ned[2][0] = -cos(pos_lla[0][0])*cos(pos_lla[1][0]); T_ecef2ned[2][1] = -cos(pos_lla[0][0])*sin(pos_lla[1][0]); T_ecef2ned[2][2] = -sin(pos_lla[0][0]);
-
-		//save next waypoint coordinates
-		WP_goal[0][0]=waypoints[nextwaypoint][0];
-		WP_goal[1][0]=waypoints[nextwaypoint][1];
-		WP_prev[0][0]=0;
-		WP_prev[1][0]=0;
+	// a batch of one on navData/controlData
+	// position is relative to the point where the autopilot was engaged, from the nav LTP cache
+	batch.num = 1;
+	batch.time = &time;
+	batch.ias = &sensorData_ptr->adData_ptr->ias_filt;
+	batch.pos_n = &navData_ptr->ltp.pos_ned[0];
+	batch.pos_e = &navData_ptr->ltp.pos_ned[1];
+	batch.vn = &navData_ptr->vn;
+	batch.ve = &navData_ptr->ve;
+	batch.gndtrk = &navData_ptr->trig.gndtrk;
+	batch.gndspd = &navData_ptr->trig.gndspd;
+	batch.wind_n = &navData_ptr->wind[0];
+	batch.wind_e = &navData_ptr->wind[1];
+	batch.psi_cmd = &controlData_ptr->psi_cmd;
+	batch.r_cmd = &controlData_ptr->r_cmd;
+
+	waypoint_guidance_batch(&mission, &flight_ctx, &batch);
+}
+}
 
-		guide_start=1;
+void init_waypoint_guidance(const struct mission *mission_ptr, struct waypoint_ctx *ctx, int num){
+	int i;
+
+	for (i = 0; i < num; i++){
+		ctx[i].next = 1;
+		ctx[i].pinit = 0;
+		ctx[i].lc = 10;
+		ctx[i].xT = 0.0;
+		ctx[i].yT = 0.0;
+		ctx[i].xC = 0.0;
+		ctx[i].yC = 0.0;
+		mission_set_wind(mission_ptr, &ctx[i].wind, 0.0, 0.0);
 	}
+}
 
-	// current vehicle position/vel (computed at every iteration)
-	pos_lla[0][0]=navData_ptr->lat;
-	pos_lla[1][0]=navData_ptr->lon;
-	pos_lla[2][0]=navData_ptr->alt;
-	v_ned[0][0] = navData_ptr->vn;
-	v_ned[1][0] = navData_ptr->ve;
-	v_ned[2][0] = navData_ptr->vd;
-	psi=atan2(v_ned[1][0],v_ned[0][0]);
+void waypoint_guidance_batch(const struct mission *mission_ptr, struct waypoint_ctx *ctx, const struct guidance_batch *batch){
+	int i;
 
-	LatLonAltToEcef2(pos_ecef, pos_lla);
-	mat_sub(pos_ecef, pos_ecef0, tmp31);
-	mat_mul(T_ecef2ned, tmp31, pos_ned);
+	for (i = 0; i < batch->num; i++)
+		step(mission_ptr, &ctx[i], batch, i);
+}
 
-	d2WP=distance2waypoint(WP_goal, pos_ned);
+//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+// one frame of instance i
+//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+static void step(const struct mission *mission_ptr, struct waypoint_ctx *ctx, const struct guidance_batch *batch, int i){
+	struct wp_frame f;
+	double psi, psiT;
 
-	// change of target waypoint: check if vehicle is within x meters of the target waypoint
-	if ((d2WP < WPTOL) && (guide_start==1)) {
-		if(nextwaypoint == numofwaypoints-1) nextwaypoint = 0; // change back to first waypoint
-		else  nextwaypoint++;
+	f.ctx=ctx;
+	f.leg=&mission_ptr->leg[ctx->next];
 
-		// select new waypoint parameters
-		WP_prev[0][0]=WP_goal[0][0];
-		WP_prev[1][0]=WP_goal[1][0];
-		WP_goal[0][0] = waypoints[nextwaypoint][0];
-		WP_goal[1][0] = waypoints[nextwaypoint][1];
+	// resize the turn circle for the ground speed in a materially different wind
+	if (mission_wind_changed(&ctx->wind, batch->wind_n[i], batch->wind_e[i]))
+		mission_set_wind(mission_ptr, &ctx->wind, batch->wind_n[i], batch->wind_e[i]);
 
-		pinit=0;		// begin tracking next waypoint
+	// current vehicle position/vel (computed at every iteration)
+	f.xA=batch->pos_n[i];   // North
+	f.yA=batch->pos_e[i];   // East
+	f.vn=batch->vn[i];
+	f.ve=batch->ve[i];
+	psi=batch->gndtrk[i];	// ground track
+
+	// unit vector along the ground track
+	if (batch->gndspd[i] > 0.0){
+		f.cpsi=f.vn/batch->gndspd[i];
+		f.spsi=f.ve/batch->gndspd[i];
+	}
+	else{
+		f.cpsi=1.0;
+		f.spsi=0.0;
 	}
 
-	// actual aircraft position
-	xA=pos_ned[0][0];   // North
-	yA=pos_ned[1][0];   // East
-	
+	// change of target waypoint: check if vehicle is within x meters of the target waypoint
+	if (mission_reached(mission_ptr, ctx->next, f.xA, f.yA)) {
+		f.leg = mission_advance(mission_ptr, &ctx->next);	// select new waypoint parameters
+		ctx->pinit=0;		// begin tracking next waypoint
+	}
 
 
 	///////////////////////// DECIDE WHICH TRACKING METHOD TO DO /////////////////////////////////////////////////
-	if (pinit==0)
+	if (ctx->pinit==0)
 	{
-		if (sensorData_ptr->adData_ptr->ias_filt>10)		// make sure airspeed filter has initialized
+		if (batch->ias[i]>10)		// make sure airspeed filter has initialized
 		{
-			xT=WP_goal[0][0];
-			yT=WP_goal[1][0];
-			psiT=atan2(yT-yA, xT-xA);    // Aircraft target azimuth angle
+			ctx->xT=f.leg->n;
+			ctx->yT=f.leg->e;
+			psiT=atan2(ctx->yT-f.yA, ctx->xT-f.xA);    // Aircraft target azimuth angle
 
 			// azimuth angle correction if required:
 			if (fabs(psiT-wraparound(psi))>PI)
@@ -180,48 +188,41 @@ if (time>0.05){
 
 			if (fabs(psiT-wraparound(psi))<LTOL*D2R)    // immediate linear path segment track
 			{
-				lc=1;			// begin linear segment tracking
-				pinit=1;
+				ctx->lc=1;			// begin linear segment tracking
+				ctx->pinit=1;
 			}
 			else    // calculate and validate circular path tracking
 			{
-				Rt=pow(controlData_ptr->ias_cmd, 2)/g/tan(PHI0)/k_R;  // turn radius
-				// center of circle:
-				dpsi=mysign(v_ned[0][0]*(WP_goal[1][0]-WP_prev[1][0])-v_ned[1][0]*(WP_goal[0][0]-WP_prev[0][0]))*90*D2R;
-				xC=xA+Rt*cos(psi+dpsi);
-				yC=yA+Rt*sin(psi+dpsi);
+				turn_center(&f);
 
-				// check feasibility
-				R2=sqrt(pow(WP_goal[0][0]-xC, 2)+pow(WP_goal[1][0]-yC, 2));
-
-				if (R2<Rt+FTOL)   // infeasible problem calculate virtual, additional point
+				if (!feasible(&f))   // infeasible problem calculate virtual, additional point
 				{
 					// virtual point to track (from there, the original point will be achievable)
-					xT=xA+4*Rt*cos(psi);
-					yT=yA+4*Rt*sin(psi);
-					lc=8;
-					pinit=1;
+					ctx->xT=f.xA+4*ctx->wind.Rt*f.cpsi;
+					ctx->yT=f.yA+4*ctx->wind.Rt*f.spsi;
+					ctx->lc=8;
+					ctx->pinit=1;
 				}
 				else    // feasible problem, track circular path
 				{
-					lc=0;		// begin tracking circular path to line up with waypoint
-					pinit=1;
+					ctx->lc=0;		// begin tracking circular path to line up with waypoint
+					ctx->pinit=1;
 				}
 			}
 		} // end if nonzero velocity
 		else
-			controlData_ptr->psi_cmd=0;
+			batch->psi_cmd[i]=0;
 	}   // end decide about tracking method
 
 
 
 	///////////////////////////////TURNING MANEUVER//////////////////////////////////////////////////
 	// turning maneuver
-	if (lc==0)  //
+	if (ctx->lc==0)  //
 	{
-		xT=WP_goal[0][0];
-		yT=WP_goal[1][0];
-		psiT=atan2(yT-yA, xT-xA);    // Aircraft target azimuth angle
+		ctx->xT=f.leg->n;
+		ctx->yT=f.leg->e;
+		psiT=atan2(ctx->yT-f.yA, ctx->xT-f.xA);    // Aircraft target azimuth angle
 		// azimuth angle correction if required:
 		if (fabs(psiT-wraparound(psi))>PI)
 			psiT=psiT+mysign(wraparound(psi))*PI2;
@@ -229,62 +230,40 @@ if (time>0.05){
 		// check if the algorithm can change to linear segment tracking
 		if (fabs(psiT-wraparound(psi))<LTOL*D2R)
 		{
-			lc=1;			// change to linear segment tracking
+			ctx->lc=1;			// change to linear segment tracking
 		}
 		else    			// track circular path
 		{
-			// calculate azimuth angle along circle
-			psiC=atan2(yA-yC, xA-xC);
-
-			// calculate goal azimuth angle considering forward arc length
-			psiC=psiC+mysign((xA-xC)*v_ned[1][0]-(yA-yC)*v_ned[0][0])*s/Rt;
-
-			xT=xC+Rt*cos(psiC);
-			yT=yC+Rt*sin(psiC);
+			circle_target(&f, &ctx->xT, &ctx->yT);
 		}
 	}
 
 
 	//////////////////////////REACHABILITY MANEUVER/////////////////////////////////////////////////////////
-	if (lc==8)
+	if (ctx->lc==8)
 	{
 		// calculate actual circle parameters
-		Rt=pow(controlData_ptr->ias_cmd, 2)/g/tan(PHI0)/k_R;  // turn radius
-		// center of circle:
-		dpsi=mysign(v_ned[0][0]*(WP_goal[1][0]-WP_prev[1][0])-v_ned[1][0]*(WP_goal[0][0]-WP_prev[0][0]))*90*D2R;
-
-		xC=xA+Rt*cos(psi+dpsi);
-		yC=yA+Rt*sin(psi+dpsi);
+		turn_center(&f);
 
 		// check feasibility
-		R2=sqrt(pow(WP_goal[0][0]-xC, 2)+pow(WP_goal[1][0]-yC, 2));
-		if (R2>=Rt+FTOL)   			// feasible problem, track circle
+		if (feasible(&f))   			// feasible problem, track circle
 		{
-			// calculate azimuth angle along circle
-			psiC=atan2(yA-yC, xA-xC);
-
-			// calculate goal azimuth angle considering forward arc length
-			psiC=psiC+mysign((xA-xC)*v_ned[1][0]-(yA-yC)*v_ned[0][0])*s/Rt;
-
-			xT=xC+Rt*cos(psiC);
-			yT=yC+Rt*sin(psiC);
-
-			lc=0;					// change to circular tracking maneuver
+			circle_target(&f, &ctx->xT, &ctx->yT);
+			ctx->lc=0;					// change to circular tracking maneuver
 		}
 	}
 
 	// Aircraft target azimuth angle and heading angle difference
-	psiT=atan2(yT-yA, xT-xA);
+	psiT=atan2(ctx->yT-f.yA, ctx->xT-f.xA);
 
 	// azimuth angle correction if required:
 	if (fabs(psiT-wraparound(psi))>PI)
 		psiT=psiT+mysign(wraparound(psi))*PI2;
 
-		controlData_ptr->psi_cmd=(psiT-wraparound(psi));
+	batch->psi_cmd[i]=(psiT-wraparound(psi));
 
-		controlData_ptr->r_cmd=((nextwaypoint+1)*10+lc); 		// store the current waypoint and tracking mode on r_cmd.
-																// lc=0 -> turning, lc=1 -> flying directly towards waypoint, lc=8 -> reachability maneuver
-}
+	batch->r_cmd[i]=((ctx->next+1)*10+ctx->lc); 		// store the current waypoint and tracking mode on r_cmd.
+														// lc=0 -> turning, lc=1 -> flying directly towards waypoint, lc=8 -> reachability maneuver
 }
     
 /////////////////////////////////////////////////////////////////////////////////////////
@@ -306,41 +285,58 @@ double mysign(double v) {
     return temp;
 }
 
-void LatLonAltToEcef2(MATRIX vector, MATRIX position) {
-    
-    double Rn, alt, denom;
-    double sinlat, coslat, coslon, sinlon;
-    
-    
-    sinlat = sin(position[0][0]);
-    coslat = cos(position[0][0]);
-    coslon = cos(position[1][0]);
-    sinlon = sin(position[1][0]);
-    alt = position[2][0];
-    
-    denom = (1.0 - (ECC2 * pow(sinlat, 2)));
-    denom = fabs(denom);
-    
-    Rn = EARTH_RADIUS / sqrt(denom);
-    
-    vector[0][0] = (Rn + alt) * coslat * coslon;
-    vector[1][0] = (Rn + alt) * coslat * sinlon;
-    vector[2][0] = (Rn * (1.0 - ECC2) + alt) * sinlat;
+//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+// center of the turn circle, 90 deg off the ground track towards the leg
+//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+static void turn_center(struct wp_frame *f) {
+    double dir=mysign(f->vn*f->leg->ue-f->ve*f->leg->un);
+    if (dir!=0) {
+        f->ctx->xC=f->xA-dir*f->ctx->wind.Rt*f->spsi;
+        f->ctx->yC=f->yA+dir*f->ctx->wind.Rt*f->cpsi;
+    }
+    else {
+        f->ctx->xC=f->xA+f->ctx->wind.Rt*f->cpsi;
+        f->ctx->yC=f->yA+f->ctx->wind.Rt*f->spsi;
+    }
 }
 
-double distance2waypoint(MATRIX wp_curr, MATRIX pos_ned) {
-    return sqrt( pow((wp_curr[0][0]-pos_ned[0][0]), 2) + pow((wp_curr[1][0]-pos_ned[1][0]), 2) );
+//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+// waypoint outside the feasibility circle around the turn center
+//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+static int feasible(const struct wp_frame *f) {
+    double dn=f->leg->n-f->ctx->xC;
+    double de=f->leg->e-f->ctx->yC;
+    return (dn*dn+de*de >= f->ctx->wind.Rt_ftol2);
+}
+
+//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+// target point on the turn circle, forward arc length s ahead of the aircraft
+//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+static void circle_target(const struct wp_frame *f, double *xT, double *yT) {
+    const struct mission_wind *w=&f->ctx->wind;
+    double dn=f->xA-f->ctx->xC;
+    double de=f->yA-f->ctx->yC;
+    double r=sqrt(dn*dn+de*de), dir;
+    if (r<=0.0) {
+        *xT=f->xA;
+        *yT=f->yA;
+        return;
+    }
+    dn/=r;
+    de/=r;
+
+    // rotate the radial unit vector by the arc angle in the direction of travel
+    dir=mysign(dn*f->ve-de*f->vn);
+    if (dir==0) {
+        *xT=f->ctx->xC+w->Rt*dn;
+        *yT=f->ctx->yC+w->Rt*de;
+    }
+    else {
+        *xT=f->ctx->xC+w->Rt*(dn*w->cs-dir*de*w->ss);
+        *yT=f->ctx->yC+w->Rt*(de*w->cs+dir*dn*w->ss);
+    }
 }
 
 void close_guidance(void){
-	//free memory space
-	mat_free(pos_lla);
-	mat_free(pos_ecef);
-	mat_free(pos_ecef0);
-	mat_free(T_ecef2ned);
-	mat_free(v_ned);
-	mat_free(tmp31);
-	mat_free(pos_ned);
-	mat_free(WP_goal);
-    mat_free(WP_prev);
+	// nothing allocated
 }
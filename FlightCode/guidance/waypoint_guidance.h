@@ -0,0 +1,49 @@
+/*! \file waypoint_guidance.h
+ *	\brief Waypoint tracker guidance law context and batch interface
+ *
+ *	\details All per-aircraft state of waypoint_guidance.c is held in a context, so one loaded mission can be flown
+ *	by many independent instances, e.g. Monte Carlo runs in a host-side simulator.
+ *	\ingroup guidance_fcns
+ *
+ * \author University of Minnesota
+ * \author Aerospace Engineering and Mechanics
+ * \copyright Copyright 2015 Regents of the University of Minnesota. All rights reserved.
+ *
+ * $Id$
+ */
+
+#ifndef WAYPOINT_GUIDANCE_H_
+#define WAYPOINT_GUIDANCE_H_
+
+#include "guidance_interface.h"
+#include "mission.h"
+
+/// Per-instance state of the waypoint tracker
+struct waypoint_ctx {
+	int next;			///< index of the goal waypoint
+	short pinit;		///< 1 once the tracking method for the current leg is chosen
+	short lc;			///< tracking mode: 0 turning, 1 flying directly towards the waypoint, 8 reachability maneuver
+	double xT, yT;		///< [m], current target point, North/East
+	double xC, yC;		///< [m], center of the turn circle being tracked, North/East
+	struct mission_wind wind;	///< turn geometry for the wind estimate of this instance
+};
+
+/// Reset num contexts to the first waypoint, with the turn geometry for still air.
+/*!
+ * \ingroup guidance_fcns
+*/
+void init_waypoint_guidance(const struct mission *mission_ptr,	///< pointer to mission, loaded by init_mission
+		struct waypoint_ctx *ctx,	///< array of num contexts
+		int num				///< number of instances
+		);
+
+/// Advance every instance of a batch by one frame on a shared mission.
+/*!
+ * \ingroup guidance_fcns
+*/
+void waypoint_guidance_batch(const struct mission *mission_ptr,	///< pointer to mission, loaded by init_mission
+		struct waypoint_ctx *ctx,				///< array of batch->num contexts
+		const struct guidance_batch *batch		///< inputs and outputs
+		);
+
+#endif /* WAYPOINT_GUIDANCE_H_ */
@@ -19,6 +19,7 @@
 #include "../system_id/systemid_interface.h"
 #include "../utils/matrix.h"
 #include "guidance_interface.h"
+#include "mission.h"
 #include "../navigation/nav_functions.h"
 
 
@@ -33,27 +34,15 @@
 
 
 //local function definition
-void LatLonAltToEcef2(MATRIX vector, MATRIX position);
-double distance2waypoint(MATRIX wp_curr, MATRIX pos_ned);
 double mysign(double v);
+static int feasible(double turn);
 
 //////////////////////////////////////////////////////////////
-// Waypoint definition
-#define numofwaypoints 6
-static short nextwaypoint=1;
-
-// order: NO, EA, IAS, alt
-// FISRT ROW MUST BE {0, 0, IAS, alt} !!!!
-
-
-static double waypoints[numofwaypoints][4] =    {{0, 0, 20.0, 60.0},
-{0, 200, 20.0, 60.0},
-{120, 200, 20.0, 60.0},
-{80, 170, 20.0, 60.0},
-{160, 90, 20.0, 60.0},
-{120, 0, 20.0, 60.0}
-};
-
+// Waypoint definition: loaded from MISSION_FILE at initialization, see mission.c
+static struct mission mission;
+static struct mission_wind wind;        // turn geometry for the current wind estimate
+static const struct mission_leg *leg;     // current leg, ends at the goal waypoint
+static int next=1;                  // index of the goal waypoint
 
 
 // Control parameters
@@ -62,11 +51,9 @@ static double waypoints[numofwaypoints][4] =    {{0, 0, 20.0, 60.0},
 #define PHI0    40*D2R      // considered maximum bank angle [deg]
 
 //local variables
-static MATRIX pos_lla, pos_ecef, pos_ecef0, T_ecef2ned, v_ned, tmp31, pos_ned, WP_goal;
-
 static short guide_init=0, guide_start=0;   // init for initialization of matrices, start for start of waypoint guidance                                                      
 static short pinit=0, lc=10;    // pinit for initialization of tracking, lc is the mode flag 
-static double d2WP, xA, yA, xT, yT, xC, yC, psiT, cpsi, dpsi, psi, Rt, R2, psiC;
+static double xA, yA, vn, ve, xT, yT, xC, yC, psiT, cpsi, dpsi, psi, cgt, sgt;
 
 
 extern void get_guidance(double time, struct sensordata *sensorData_ptr, struct nav *navData_ptr, struct control *controlData_ptr){       
@@ -92,35 +79,21 @@ extern void get_guidance(double time, struct sensordata *sensorData_ptr, struct
 	// Initialization of algorithm and variables	
     if (guide_init==0)  // init variables
     {
-        pos_lla     = mat_creat(3,1,ZERO_MATRIX);   // LAT, LON, alt vector
-        pos_ecef    = mat_creat(3,1,ZERO_MATRIX);   // ECEF position vector
-        pos_ecef0   = mat_creat(3,1,ZERO_MATRIX);   // ECEF position vector of initial point
-        v_ned       = mat_creat(3,1,ZERO_MATRIX);   // vector of NED velocity
-        pos_ned     = mat_creat(3,1,ZERO_MATRIX);   // vector of NED position
-        tmp31       = mat_creat(3,1,ZERO_MATRIX);   // temporary 3x1 vector
-        T_ecef2ned  = mat_creat(3,3,ZERO_MATRIX);   // transformation matrix from ECEF to NED
-        WP_goal     = mat_creat(2,1,ZERO_MATRIX);   // Vector of North / East goal coordinates (actaul waypoint)       
+        // load the mission; turn radius and feasibility circle are fixed by the commanded airspeed
+        init_mission(&mission, controlData_ptr->ias_cmd, PHI0, FTOL, WPTOL, 0.0);
+        mission_set_wind(&mission, &wind, 0.0, 0.0);
         guide_init=1;                               // guidance initialization finished
     }	    
+
+    // resize the turn circle for the ground speed in a materially different wind
+    if (mission_wind_changed(&wind, navData_ptr->wind[0], navData_ptr->wind[1]))
+        mission_set_wind(&mission, &wind, navData_ptr->wind[0], navData_ptr->wind[1]);
     
     
     if (guide_start==0)
     {
-        pos_lla[0][0]=navData_ptr->lat;
-        pos_lla[1][0]=navData_ptr->lon;
-        pos_lla[2][0]=navData_ptr->alt;
-        
-        // transform starting point from LLA to ECEF
-        LatLonAltToEcef2(pos_ecef0, pos_lla);
-        
-        // transformation matrix for LaunchPoint ECEF |--> NED for initial point
-        T_ecef2ned[0][0] = -sin(pos_lla[0][0])*cos(pos_lla[1][0]); T_ecef2ned[0][1] = -sin(pos_lla[0][0])*sin(pos_lla[1][0]); T_ecef2ned[0][2] =  cos(pos_lla[0][0]);
-        T_ecef2ned[1][0] = -sin(pos_lla[1][0]);                    T_ecef2ned[1][1] =  cos(pos_lla[1][0]);                    T_ecef2ned[1][2] =  0.0;
-        T_ecef2ned[2][0] = -cos(pos_lla[0][0])*cos(pos_lla[1][0]); T_ecef2ned[2][1] = -cos(pos_lla[0][0])*sin(pos_lla[1][0]); T_ecef2ned[2][2] = -sin(pos_lla[0][0]);
-        
-        //save next waypoint coordinates
-        WP_goal[0][0]=waypoints[nextwaypoint][0];
-        WP_goal[1][0]=waypoints[nextwaypoint][1];       
+        //save next waypoint
+        leg = &mission.leg[next];
         
         guide_start=1;
     }
@@ -128,42 +101,31 @@ extern void get_guidance(double time, struct sensordata *sensorData_ptr, struct
         cpsi=0; //to handle SIL initial zero data
     
     // current vehicle position/vel (computed at every iteration)
-    pos_lla[0][0]=navData_ptr->lat;
-    pos_lla[1][0]=navData_ptr->lon;
-    pos_lla[2][0]=navData_ptr->alt;
-    v_ned[0][0] = navData_ptr->vn;
-    v_ned[1][0] = navData_ptr->ve;
-    v_ned[2][0] = navData_ptr->vd;
+    // position is relative to the point where the autopilot was engaged, from the nav LTP cache
+    xA=navData_ptr->ltp.pos_ned[0];   // North
+    yA=navData_ptr->ltp.pos_ned[1];   // East
+    vn=navData_ptr->vn;
+    ve=navData_ptr->ve;
     // azimuth angle from ground speed
-    psi=atan2(v_ned[1][0], v_ned[0][0]);
-    
-    // Transfrom the difference of actual coordinates from the starting point into NED frame
-    LatLonAltToEcef2(pos_ecef, pos_lla);
-    mat_sub(pos_ecef, pos_ecef0, tmp31);
-    mat_mul(T_ecef2ned, tmp31, pos_ned);
-    
-    // Calculate waypoint distance from actual point
-    d2WP=distance2waypoint(WP_goal, pos_ned);
+    psi=navData_ptr->trig.gndtrk;	// ground track, from the nav trig cache
+    if (navData_ptr->trig.gndspd > 0.0) {
+        cgt=vn/navData_ptr->trig.gndspd;
+        sgt=ve/navData_ptr->trig.gndspd;
+    }
+    else {
+        cgt=1.0;
+        sgt=0.0;
+    }
     
     // change of target waypoint: check if vehicle is within x meters of the target waypoint
-    if ((d2WP < WPTOL) && (guide_start==1)) {
-        if(nextwaypoint == numofwaypoints-1) nextwaypoint = 0; // change back to first waypoint
-        else  nextwaypoint++;
-        
-        // select new waypoint parameters        
-        WP_goal[0][0] = waypoints[nextwaypoint][0];
-        WP_goal[1][0] = waypoints[nextwaypoint][1];
-        
+    if (mission_reached(&mission, next, xA, yA) && (guide_start==1)) {
+        leg = mission_advance(&mission, &next);   // select new waypoint parameters
         pinit=0;
     }
     
-    // actual aircraft position
-    xA=pos_ned[0][0];   // North
-    yA=pos_ned[1][0];   // East
-    
     // Target coordinates
-    xT=WP_goal[0][0];
-    yT=WP_goal[1][0];
+    xT=leg->n;
+    yT=leg->e;
     
     if (pinit==0)   // decide about tracking method
     {
@@ -174,14 +136,10 @@ extern void get_guidance(double time, struct sensordata *sensorData_ptr, struct
             if (fabs(psiT-wraparound(psi))>PI)
                 psiT=psiT+mysign(wraparound(psi))*PI2;
             
-            Rt=pow(controlData_ptr->ias_cmd, 2)/g/tan(PHI0);  // possible turn radius
             // center of circle:
             dpsi=mysign(psiT-wraparound(psi))*90*D2R;            
-            xC=xA+Rt*cos(psi+dpsi);
-            yC=yA+Rt*sin(psi+dpsi);
             // check feasibility
-            R2=sqrt(pow(WP_goal[0][0]-xC, 2)+pow(WP_goal[1][0]-yC, 2)); // distance of waypoint from circle center
-            if (R2<Rt+FTOL)   // infeasible problem turn into opposite direction
+            if (!feasible(dpsi))   // infeasible problem turn into opposite direction
             {
                 cpsi=-dpsi*4;
                 lc=8;
@@ -198,8 +156,6 @@ extern void get_guidance(double time, struct sensordata *sensorData_ptr, struct
    
     if (lc==8)  // check if the algorithm can change to circular segment tracking
     {
-        // calculate actual circle parameters
-        Rt=pow(controlData_ptr->ias_cmd, 2)/g/tan(PHI0);  // turn radius
         // center of circle:
         psiT=atan2(yT-yA, xT-xA);
         // azimuth angle correction if required:
@@ -207,11 +163,8 @@ extern void get_guidance(double time, struct sensordata *sensorData_ptr, struct
             psiT=psiT+mysign(wraparound(psi))*PI2;
         // center of circle:
         dpsi=mysign(psiT-wraparound(psi))*90*D2R;       
-        xC=xA+Rt*cos(psi+dpsi);
-        yC=yA+Rt*sin(psi+dpsi);
         // check feasibility
-        R2=sqrt(pow(WP_goal[0][0]-xC, 2)+pow(WP_goal[1][0]-yC, 2));
-        if (R2>=Rt+FTOL)   // fasible problem, track circle
+        if (feasible(dpsi))   // fasible problem, track circle
         {
             cpsi=psiT-wraparound(psi);
             lc=0;
@@ -231,7 +184,7 @@ extern void get_guidance(double time, struct sensordata *sensorData_ptr, struct
     controlData_ptr->psi_cmd=cpsi;
     
     // send out diagnostic variable
-    controlData_ptr->r_cmd=((nextwaypoint+1)*10+lc);
+    controlData_ptr->r_cmd=((next+1)*10+lc);
     }
 }
     
@@ -254,40 +207,27 @@ double mysign(double v) {
     return temp;
 }
 
-void LatLonAltToEcef2(MATRIX vector, MATRIX position) {
-    
-    double Rn, alt, denom;
-    double sinlat, coslat, coslon, sinlon;
-    
-    
-    sinlat = sin(position[0][0]);
-    coslat = cos(position[0][0]);
-    coslon = cos(position[1][0]);
-    sinlon = sin(position[1][0]);
-    alt = position[2][0];
-    
-    denom = (1.0 - (ECC2 * pow(sinlat, 2)));
-    denom = fabs(denom);
+//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+// turn circle center 90 deg off the ground track on the side of turn (+/-90 deg, or 0),
+// returns 1 if the waypoint lies outside the feasibility circle around it
+//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+static int feasible(double turn) {
+    double dir=mysign(turn), dn, de;
     
-    Rn = EARTH_RADIUS / sqrt(denom);
+    if (dir!=0) {
+        xC=xA-dir*wind.Rt*sgt;
+        yC=yA+dir*wind.Rt*cgt;
+    }
+    else {
+        xC=xA+wind.Rt*cgt;
+        yC=yA+wind.Rt*sgt;
+    }
     
-    vector[0][0] = (Rn + alt) * coslat * coslon;
-    vector[1][0] = (Rn + alt) * coslat * sinlon;
-    vector[2][0] = (Rn * (1.0 - ECC2) + alt) * sinlat;
-}
-
-double distance2waypoint(MATRIX wp_curr, MATRIX pos_ned) {
-    return sqrt( pow((wp_curr[0][0]-pos_ned[0][0]), 2) + pow((wp_curr[1][0]-pos_ned[1][0]), 2) );
+    dn=leg->n-xC;
+    de=leg->e-yC;
+    return (dn*dn+de*de >= wind.Rt_ftol2);
 }
 
 void close_guidance(void){
-	//free memory space
-	mat_free(pos_lla);
-	mat_free(pos_ecef);
-	mat_free(pos_ecef0);
-	mat_free(T_ecef2ned);
-	mat_free(v_ned);
-	mat_free(tmp31);
-	mat_free(pos_ned);
-	mat_free(WP_goal);    
+	// nothing allocated
 }
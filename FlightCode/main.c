@@ -32,11 +32,21 @@
 // Interfaces
 #include "sensors/AirData/airdata_interface.h"
 #include "sensors/daq_interface.h"
+#include "daq/daq_interface.h"
 #include "actuators/actuator_interface.h"
+#include "actuators/actuator_calibration.h"
 #include "navigation/nav_interface.h"
+#include "navigation/nav_environment.h"
+#include "navigation/mag_model.h"
 #include "guidance/guidance_interface.h"
+#include "guidance/geofence.h"
 #include "control/control_interface.h"
+#include "control/reference_filter.h"
+#include "control/gain_schedule.h"
+#include "control/control_allocation.h"
+#include "control/control_metrics.h"
 #include "system_id/systemid_interface.h"
+#include "system_id/systemid_rls.h"
 #include "faults/fault_interface.h"
 #include "datalog/datalog_interface.h"
 #include "telemetry/telemetry_interface.h"
@@ -48,6 +58,8 @@
 // dataLog structure. External but used only in datalogger.c
 struct datalog dataLog;
 
+#define NUM_SHADOW_VARS 7	///< surface commands of the shadow control law, logged after the float variables of DATALOG_CONFIG
+
 // Conditional variables. These are external but only used in scheduling.c
 pthread_cond_t  trigger_daq, trigger_nav, trigger_guidance, trigger_sensfault, \
 trigger_control, trigger_sysid, trigger_surffault, \
@@ -64,8 +76,11 @@ int main(int argc, char **argv) {
 	struct	ahrsdr ahrsdrData;
 	struct  nav   navData;
 	struct  control controlData;
+	struct  control shadowData;		// commands and outputs of the shadow control law, never sent to the actuators
 	struct  airdata adData;
 	struct  surface surfData;
+	struct  magfield magData;
+	struct	geofence_status fenceStatus;
 
 	// sensor data
 	struct sensordata sensorData;
@@ -80,6 +95,14 @@ int main(int argc, char **argv) {
 	// Include datalog definition
 	#include DATALOG_CONFIG
 
+	// Float variables of DATALOG_CONFIG followed by the shadow law surface commands, used when a shadow law runs
+	char* logFloatNames[NUM_FLOAT_VARS + NUM_SHADOW_VARS];
+	double* logFloatPointers[NUM_FLOAT_VARS + NUM_SHADOW_VARS];
+	char* shadowNames[NUM_SHADOW_VARS] = {"shadow_dthr", "shadow_de", "shadow_dr", "shadow_da_l", "shadow_da_r",
+			"shadow_df_l", "shadow_df_r"};
+	double* shadowPointers[NUM_SHADOW_VARS] = {&shadowData.dthr, &shadowData.de, &shadowData.dr, &shadowData.da_l,
+			&shadowData.da_r, &shadowData.df_l, &shadowData.df_r};
+
 	// Populate dataLog members with initial values
 	dataLog.saveAsDoubleNames = &saveAsDoubleNames[0];
 	dataLog.saveAsDoublePointers = &saveAsDoublePointers[0];
@@ -98,19 +121,46 @@ int main(int argc, char **argv) {
 	double tic,time,t0=0;
 	static int t0_latched = FALSE;
 	int loop_counter = 0;
+	int loop;
+	char status_msg[96];
+	short mag_clamped, mag_pending = 0;
+#if INNER_LOOP_STEPS > 1
+	int inner_step;
+#endif
 
 	// Populate sensorData structure with pointers to data structures
 	sensorData.imuData_ptr = &imuData;
 	sensorData.gpsData_ptr = &gpsData;
 	sensorData.adData_ptr = &adData;
 	sensorData.surfData_ptr = &surfData;
+	sensorData.magData_ptr = &magData;
 
 	// Initialize set_actuators (PWM or serial) at zero
+	check_actuator_calibration();	// report PWM output and R/C input calibrations that are not monotonic
 	init_actuators();
 	set_actuators(&controlData);
 
 	// initialize functions
 	init_daq(&sensorData, &insgpsData, &ahrsdrData, &navData, &controlData);
+	init_nav_env();
+	mag_clamped = (init_mag_model() != 0);	// flight date outside the validity of the magnetic model
+	init_geofence();
+	init_gain_schedule();
+	init_control_allocation();
+	init_control(&controlData);
+	if (get_control_shadow()){
+		// log the shadow law outputs next to the active ones
+		memcpy(logFloatNames, saveAsFloatNames, sizeof(saveAsFloatNames));
+		memcpy(logFloatPointers, saveAsFloatPointers, sizeof(saveAsFloatPointers));
+		memcpy(&logFloatNames[NUM_FLOAT_VARS], shadowNames, sizeof(shadowNames));
+		memcpy(&logFloatPointers[NUM_FLOAT_VARS], shadowPointers, sizeof(shadowPointers));
+		dataLog.saveAsFloatNames = &logFloatNames[0];
+		dataLog.saveAsFloatPointers = &logFloatPointers[0];
+		dataLog.numFloatVars = NUM_FLOAT_VARS + NUM_SHADOW_VARS;
+	}
+	magData.valid = 0;
+	navData.ltp.valid = 0;
+	init_nav_health(&navData);
 	init_telemetry();
 
 	while(1){
@@ -152,16 +202,27 @@ int main(int argc, char **argv) {
 			// Run DR & GPS-aided INS filters
 			if (ahrsdrData.err_type_2 == got_invalid){ // Check if DR has been initialized
 				if (gpsData.navValid == 0) {// check if GPS is locked
-					// Initialize DR & GPS-aided INS filters
+					// Evaluate the magnetic field at the lock position, then initialize DR & GPS-aided INS filters
+					mag_pending = update_mag_field(&sensorData);
 					init_dr(&sensorData, &ahrsdrData, &controlData);
 					init_insgps(&sensorData, &insgpsData, &controlData, &ahrsdrData);
 					send_status("Position initialized");
 				}
 			}
 			else{
-				// Call DR & GPS-aided INS filters
-				get_dr(&sensorData, &ahrsdrData, &controlData);
-				get_insgps(&sensorData, &insgpsData, &controlData, &ahrsdrData);
+				// Call DR & GPS-aided INS filters. A filter flagged diverged by the health monitor is excluded by the
+				// blender and holds until it is re-initialized in the background
+				if (navData.ahrsdr_health != nav_diverged){
+					get_dr(&sensorData, &ahrsdrData, &controlData);
+				}
+
+				if (navData.insgps_health != nav_diverged){
+					get_insgps(&sensorData, &insgpsData, &controlData, &ahrsdrData);
+				}
+
+				// Check filter consistency against this frame's GPS measurement update
+				get_nav_health(&sensorData, &insgpsData, &ahrsdrData, &navData);
+
 				// Ensure that GPS newData flag is reset AFTER filters run
 				if (gpsData.newData == 1){
 					gpsData.newData = 0;
@@ -180,6 +241,12 @@ int main(int argc, char **argv) {
 				// Call Blender
 				get_nav(&sensorData, &insgpsData, &ahrsdrData, &navData);
 			}
+
+			// Trig of the blended solution, shared by guidance and control for the rest of the frame
+			update_nav_trig(&navData);
+
+			// NED position relative to the origin latched at autopilot engage
+			update_nav_ltp(&navData);
 			//********************************************************************************************//
 
 			//**** END NAVIGATION ********************************************************
@@ -188,12 +255,20 @@ int main(int argc, char **argv) {
 				if (t0_latched == FALSE) {
 					t0 = get_Time();
 					t0_latched = TRUE;
+					set_nav_ltp_origin(&navData);	// guidance positions are relative to the engage point
+					fenceStatus.rth = 0;			// a new engagement clears the geofence return to home
+					reset_control_metrics();		// statistics of this engagement only
+					reset_sysid_rls();				// derivatives of this engagement only
 				}
 
 				time = get_Time()-t0; // Time since in auto mode
 
 				//**** GUIDANCE **********************************************************
+				restore_reference_filter(&controlData);	// the guidance law sees its raw commands of the previous frame
 				get_guidance(time, &sensorData, &navData, &controlData);
+				get_geofence(&navData, &controlData, &fenceStatus);	// return to home override on a fence breach
+				get_control_steps(time, &controlData);	// steps of the raw guidance commands, for the metrics
+				get_reference_filter(&sensorData, &controlData);	// rate and acceleration limit the commands for the control law
 				etime_guidance= get_Time() - tic - etime_nav - etime_daq; // compute execution time
 				//************************************************************************
 
@@ -203,7 +278,9 @@ int main(int argc, char **argv) {
 				//************************************************************************
 
 				//**** CONTROL ***********************************************************
+				shadowData = controlData;	// the shadow law sees the commands and feedback of the active law
 				get_control(time, &sensorData, &navData, &controlData);
+				get_control_metrics(time);
 				etime_control = get_Time() - tic - etime_sensfault - etime_guidance - etime_nav - etime_daq; // compute execution time
 				//************************************************************************
 
@@ -221,8 +298,23 @@ int main(int argc, char **argv) {
 			else{
 				if (t0_latched == TRUE) {
 					t0_latched = FALSE;
+
+					// Tracking statistics of the engagement that just ended
+					for (loop = 0; loop < LOOP_N; loop++){
+						if (report_control_metrics(loop, controlData.run_num, status_msg, sizeof(status_msg)) > 0)
+							send_status(status_msg);
+					}
+
+					// Derivatives identified onboard, to confirm the test point before landing
+					update_sysid_rls();
+					for (loop = 0; loop < SYSID_NAXES; loop++){
+						if (report_sysid_rls(loop, controlData.run_num, status_msg, sizeof(status_msg)) > 0)
+							send_status(status_msg);
+					}
 				}
 				reset_control(&controlData); // reset controller states and set get_control surfaces to zero
+				reset_shadow_control(&shadowData);
+				reset_reference_filter();	 // the commands after engaging are shaped from the aircraft state
 			} // end if (controlData.mode == 2)
 
 			// Add trim biases to get_control surface commands
@@ -233,6 +325,32 @@ int main(int argc, char **argv) {
 			etime_actuators = get_Time() - tic - ACTUATORS_OFFSET; // compute execution time
 			//************************************************************************
 
+			// Store the rates and surface commands of the frame for the onboard estimator, run in the background
+			if (controlData.mode == 2)
+				get_sysid_sample(&sensorData, &controlData);
+
+			//**** SHADOW CONTROL ****************************************************
+			// Candidate law stepped after the actuators are set, so it adds no latency to the active law
+			if (controlData.mode == 2)
+				get_shadow_control(time, &sensorData, &navData, &shadowData);
+			//************************************************************************
+
+#if INNER_LOOP_STEPS > 1
+			//**** INNER LOOP ********************************************************
+			// Rate dampers and actuator output at INNER_LOOP_STEPS/TIMESTEP Hz, on fresh IMU body rates. Navigation,
+			// guidance and the outer control loops above run once per frame and hold their commands; the first inner
+			// step ran with get_control()
+			for (inner_step = 1; inner_step < INNER_LOOP_STEPS; inner_step++){
+				get_imu_rates(&sensorData);
+				if (controlData.mode == 2){
+					get_inner_control(&sensorData, &controlData);
+					set_actuators(&controlData);
+					get_shadow_inner_control(&sensorData, &shadowData);
+				}
+			}
+			//************************************************************************
+#endif
+
 			//**** DATA LOGGING ******************************************************
 			datalogger();
 			etime_datalog = get_Time() - tic - etime_actuators - ACTUATORS_OFFSET; // compute execution time
@@ -248,6 +366,30 @@ int main(int argc, char **argv) {
 
 				send_telemetry(&sensorData, &navData, &controlData, cpuLoad);
 
+				// Background: refresh the magnetic field reference once the aircraft has moved far enough, and report
+				// each new evaluation
+				if (update_mag_field(&sensorData) || mag_pending){
+					mag_pending = 0;
+					snprintf(status_msg, sizeof(status_msg), "Mag field %.3f %.3f %.3f G, dec %.1f deg%s", magData.hn[0],
+							magData.hn[1], magData.hn[2], magData.dec*R2D, mag_clamped ? ", model date clamped" : "");
+					send_status(status_msg);
+				}
+
+				// Background: re-initialize a nav filter the health monitor declared diverged
+				if (navData.ahrsdr_health == nav_diverged){
+					init_dr(&sensorData, &ahrsdrData, &controlData);
+					reset_nav_health(&navData, NAV_HEALTH_AHRSDR);
+					send_status("DR re-initialized");
+				}
+				if (navData.insgps_health == nav_diverged){
+					init_insgps(&sensorData, &insgpsData, &controlData, &ahrsdrData);
+					reset_nav_health(&navData, NAV_HEALTH_INSGPS);
+					send_status("GPS-aided INS re-initialized");
+				}
+
+				// Background: onboard stability and control derivative estimates, on the frames stored since the last pass
+				update_sysid_rls();
+
 				etime_telemetry = get_Time() - tic - etime_datalog - etime_actuators - ACTUATORS_OFFSET; // compute execution time
 			}
 			//************************************************************************
@@ -269,6 +411,7 @@ int main(int argc, char **argv) {
 	 **********************************************************************/
 
 	close_actuators();
+	close_guidance();
 	close_ahrs();
 	close_insgps();
 	close_dr();
@@ -1,11 +1,225 @@
 /*
  * \file Blender.c
- * \description
- *  
+ * \description Blends the GPS-aided INS and AHRS/DR solutions into the navData structure.
+ *
+ *	Weights are inverse-variance weights computed from the diagonal of the attitude (Pa) and
+ *	position/velocity (Pp, Pv) covariances of each filter. They are only recomputed when one of the
+ *	covariance traces has moved by more than BLEND_COV_TOL (relative) since the last update, so most
+ *	frames reuse the previous weights. A filter flagged nav_diverged by the health monitor (nav_health.c)
+ *	gets zero weight until it has been re-initialized. Attitude is blended as a normalized linear interpolation of the
+ *	two quaternions, the AHRS one built from its Euler angles. When one filter carries all of the weight its Euler
+ *	angles are copied directly and no trig is evaluated; with the AHRS alone, which publishes Euler angles only, the
+ *	quaternion is converted once when the AHRS takes over and held after that. The wind estimate comes from the DR
+ *	filter alone.
+ *
  *  Created on: 5:41:41 PM Feb 4, 2015 by john
  *  \author University of Minnesota
  *  \author Aerospace Engineering and Mechanics
  *  \copyright Copyright 2015 Regents of the University of Minnesota.  All rights reserved.
  */
 
+#include <math.h>
 
+#include "../globaldefs.h"
+#include "../utils/matrix.h"
+#include "nav_functions.h"
+#include "nav_interface.h"
+
+#define BLEND_COV_TOL		0.05	///< relative change in a covariance trace that triggers a weight update
+#define BLEND_WEIGHT_EPS	1.0e-4	///< weights closer than this to 0 or 1 are snapped, selecting a single filter
+
+// local functions
+static void update_weights(struct insgps *insgpsData_ptr, struct ahrsdr *ahrsdrData_ptr, struct nav *navData_ptr);
+static double blend_weight(double P_ins, double P_ahrsdr);
+static short cov_changed(double P, double P_last);
+
+// covariance traces used for the current weights
+static double Pa_ins_last, Pa_ahrsdr_last, Ppv_ins_last, Ppv_ahrsdr_last;
+static short insgps_valid_last = -1, ahrsdr_valid_last = -1, ahrsdr_pos_valid_last = -1;
+static short ahrs_att_only = 0;		// 1 while the AHRS carries all of the attitude weight
+
+void init_nav(struct sensordata *sensorData_ptr, struct insgps *insgpsData_ptr, struct ahrsdr *ahrsdrData_ptr, struct nav *navData_ptr){
+
+	// force a weight computation on the first call
+	ahrs_att_only = 0;
+	insgps_valid_last = -1;
+	ahrsdr_valid_last = -1;
+	ahrsdr_pos_valid_last = -1;
+
+	update_weights(insgpsData_ptr, ahrsdrData_ptr, navData_ptr);
+
+	navData_ptr->err_type = data_valid;
+
+	get_nav(sensorData_ptr, insgpsData_ptr, ahrsdrData_ptr, navData_ptr);
+}
+
+void get_nav(struct sensordata *sensorData_ptr, struct insgps *insgpsData_ptr, struct ahrsdr *ahrsdrData_ptr, struct nav *navData_ptr){
+	double wa, wi, sgn, qnorm, dlon;
+	double q[4], qa[4];
+	int i;
+
+	update_weights(insgpsData_ptr, ahrsdrData_ptr, navData_ptr);
+
+	//********** Attitude **********
+	wi = navData_ptr->insgps_att_weight;
+	wa = navData_ptr->ahrsdr_att_weight;
+
+	if (wi == 1.0){
+		navData_ptr->phi = insgpsData_ptr->phi;
+		navData_ptr->the = insgpsData_ptr->the;
+		navData_ptr->psi = insgpsData_ptr->psi;
+		for (i = 0; i < 4; i++) navData_ptr->quat[i] = insgpsData_ptr->quat[i];
+		ahrs_att_only = 0;
+	}
+	else if (wa == 1.0){
+		navData_ptr->phi = ahrsdrData_ptr->phi;
+		navData_ptr->the = ahrsdrData_ptr->the;
+		navData_ptr->psi = ahrsdrData_ptr->psi;
+		if (!ahrs_att_only){
+			// the AHRS publishes Euler angles only; converted at the transition, held after
+			eul2quat(navData_ptr->quat, navData_ptr->phi, navData_ptr->the, navData_ptr->psi);
+			ahrs_att_only = 1;
+		}
+	}
+	else{
+		ahrs_att_only = 0;
+		eul2quat(qa, ahrsdrData_ptr->phi, ahrsdrData_ptr->the, ahrsdrData_ptr->psi);
+
+		// q and -q are the same attitude; interpolate along the short arc
+		sgn = 0.0;
+		for (i = 0; i < 4; i++) sgn += insgpsData_ptr->quat[i]*qa[i];
+		sgn = (sgn < 0.0) ? -1.0 : 1.0;
+
+		qnorm = 0.0;
+		for (i = 0; i < 4; i++){
+			q[i] = wa*qa[i] + sgn*wi*insgpsData_ptr->quat[i];
+			qnorm += q[i]*q[i];
+		}
+		qnorm = 1.0/sqrt(qnorm);
+		for (i = 0; i < 4; i++) navData_ptr->quat[i] = q[i]*qnorm;
+
+		quat2eul(navData_ptr->quat, &navData_ptr->phi, &navData_ptr->the, &navData_ptr->psi);
+	}
+
+	// sensor biases follow the attitude weighting
+	for (i = 0; i < 3; i++){
+		navData_ptr->gb[i] = wa*ahrsdrData_ptr->gb[i] + wi*insgpsData_ptr->gb[i];
+		navData_ptr->ab[i] = wa*ahrsdrData_ptr->ab[i] + wi*insgpsData_ptr->ab[i];
+	}
+
+	//********** Position and Velocity **********
+	wi = navData_ptr->insgps_pos_weight;
+	wa = navData_ptr->ahrsdr_pos_weight;
+
+	if (wi == 1.0){
+		navData_ptr->lat = insgpsData_ptr->lat;
+		navData_ptr->lon = insgpsData_ptr->lon;
+		navData_ptr->alt = insgpsData_ptr->alt;
+		navData_ptr->vn  = insgpsData_ptr->vn;
+		navData_ptr->ve  = insgpsData_ptr->ve;
+		navData_ptr->vd  = insgpsData_ptr->vd;
+	}
+	else if (wa == 1.0){
+		navData_ptr->lat = ahrsdrData_ptr->lat;
+		navData_ptr->lon = ahrsdrData_ptr->lon;
+		navData_ptr->alt = ahrsdrData_ptr->alt;
+		navData_ptr->vn  = ahrsdrData_ptr->vn;
+		navData_ptr->ve  = ahrsdrData_ptr->ve;
+		navData_ptr->vd  = ahrsdrData_ptr->vd;
+	}
+	else if (wa > 0.0){
+		// blend longitude as an offset so the +/-180 deg seam is handled
+		dlon = wraparound(insgpsData_ptr->lon - ahrsdrData_ptr->lon);
+
+		navData_ptr->lat = wa*ahrsdrData_ptr->lat + wi*insgpsData_ptr->lat;
+		navData_ptr->lon = wraparound(ahrsdrData_ptr->lon + wi*dlon);
+		navData_ptr->alt = wa*ahrsdrData_ptr->alt + wi*insgpsData_ptr->alt;
+		navData_ptr->vn  = wa*ahrsdrData_ptr->vn  + wi*insgpsData_ptr->vn;
+		navData_ptr->ve  = wa*ahrsdrData_ptr->ve  + wi*insgpsData_ptr->ve;
+		navData_ptr->vd  = wa*ahrsdrData_ptr->vd  + wi*insgpsData_ptr->vd;
+	}
+	// else: no position solution yet, hold the previous values
+
+	//********** Wind **********
+	// only the DR filter estimates wind; hold the last estimate while it is excluded
+	if (ahrsdr_pos_valid_last == 1){
+		for (i = 0; i < 3; i++) navData_ptr->wind[i] = ahrsdrData_ptr->wind[i];
+	}
+
+	navData_ptr->time = sensorData_ptr->imuData_ptr->time;
+}
+
+void close_nav(void){
+	// nothing allocated
+}
+
+/// Recompute the blending weights if a filter changed state or a covariance trace moved beyond BLEND_COV_TOL.
+static void update_weights(struct insgps *insgpsData_ptr, struct ahrsdr *ahrsdrData_ptr, struct nav *navData_ptr){
+	double Pa_ins, Pa_ahrsdr, Ppv_ins, Ppv_ahrsdr;
+	short insgps_valid, ahrsdr_valid, ahrsdr_pos_valid;
+
+	// a filter the health monitor has declared diverged is excluded until it is re-initialized
+	insgps_valid = (insgpsData_ptr->err_type != got_invalid) && (navData_ptr->insgps_health != nav_diverged);
+	ahrsdr_valid = (navData_ptr->ahrsdr_health != nav_diverged) || !insgps_valid;
+	ahrsdr_pos_valid = (ahrsdrData_ptr->err_type_2 != got_invalid) && ahrsdr_valid;
+
+	Pa_ins = insgpsData_ptr->Pa[0] + insgpsData_ptr->Pa[1] + insgpsData_ptr->Pa[2];
+	Pa_ahrsdr = ahrsdrData_ptr->Pa[0] + ahrsdrData_ptr->Pa[1] + ahrsdrData_ptr->Pa[2];
+	Ppv_ins = insgpsData_ptr->Pp[0] + insgpsData_ptr->Pp[1] + insgpsData_ptr->Pp[2]
+			+ insgpsData_ptr->Pv[0] + insgpsData_ptr->Pv[1] + insgpsData_ptr->Pv[2];
+	Ppv_ahrsdr = ahrsdrData_ptr->Pp[0] + ahrsdrData_ptr->Pp[1] + ahrsdrData_ptr->Pp[2]
+			+ ahrsdrData_ptr->Pv[0] + ahrsdrData_ptr->Pv[1] + ahrsdrData_ptr->Pv[2];
+
+	// steady state: nothing has moved enough to matter
+	if (insgps_valid == insgps_valid_last && ahrsdr_valid == ahrsdr_valid_last && ahrsdr_pos_valid == ahrsdr_pos_valid_last
+			&& !cov_changed(Pa_ins, Pa_ins_last) && !cov_changed(Pa_ahrsdr, Pa_ahrsdr_last)
+			&& !cov_changed(Ppv_ins, Ppv_ins_last) && !cov_changed(Ppv_ahrsdr, Ppv_ahrsdr_last))
+		return;
+
+	if (!insgps_valid){
+		// AHRS/DR only
+		navData_ptr->insgps_att_weight = 0.0;
+		navData_ptr->insgps_pos_weight = 0.0;
+		navData_ptr->ahrsdr_pos_weight = ahrsdr_pos_valid ? 1.0 : 0.0;
+	}
+	else if (!ahrsdr_valid){
+		// GPS-aided INS only
+		navData_ptr->insgps_att_weight = 1.0;
+		navData_ptr->insgps_pos_weight = 1.0;
+		navData_ptr->ahrsdr_pos_weight = 0.0;
+	}
+	else{
+		navData_ptr->insgps_att_weight = blend_weight(Pa_ins, Pa_ahrsdr);
+		navData_ptr->insgps_pos_weight = ahrsdr_pos_valid ? blend_weight(Ppv_ins, Ppv_ahrsdr) : 1.0;
+		navData_ptr->ahrsdr_pos_weight = 1.0 - navData_ptr->insgps_pos_weight;
+	}
+	navData_ptr->ahrsdr_att_weight = 1.0 - navData_ptr->insgps_att_weight;
+
+	Pa_ins_last = Pa_ins;
+	Pa_ahrsdr_last = Pa_ahrsdr;
+	Ppv_ins_last = Ppv_ins;
+	Ppv_ahrsdr_last = Ppv_ahrsdr;
+	insgps_valid_last = insgps_valid;
+	ahrsdr_valid_last = ahrsdr_valid;
+	ahrsdr_pos_valid_last = ahrsdr_pos_valid;
+}
+
+/// Inverse-variance weight placed on the GPS-aided INS solution, snapped to 0 or 1 near the ends.
+static double blend_weight(double P_ins, double P_ahrsdr){
+	double w;
+
+	if (P_ins + P_ahrsdr <= 0.0)
+		return 1.0;
+
+	w = P_ahrsdr/(P_ins + P_ahrsdr);
+
+	if (w > 1.0 - BLEND_WEIGHT_EPS) w = 1.0;
+	else if (w < BLEND_WEIGHT_EPS) w = 0.0;
+
+	return w;
+}
+
+/// Returns 1 if the covariance trace P has moved more than BLEND_COV_TOL relative to P_last.
+static short cov_changed(double P, double P_last){
+	return (fabs(P - P_last) > BLEND_COV_TOL*fabs(P_last));
+}
@@ -0,0 +1,258 @@
+/*
+ * \file mag_model.c
+ * \description Onboard WMM/IGRF main field evaluator.
+ *
+ *	Coefficients are read once from MAG_MODEL_FILE (NOAA .COF format, e.g. WMM.COF) or taken from the
+ *	built-in IGRF-13 table, propagated to the flight date with the secular variation and scaled by the
+ *	Schmidt semi-normalization factors. The Legendre recursion constants are precomputed as well, so an
+ *	evaluation is a fixed number of multiply-adds plus sin/cos of latitude and longitude and two sqrt.
+ *
+ *	Reference: The US/UK World Magnetic Model for 2020-2025, NOAA Technical Report, 2019.
+ *
+ *  \author University of Minnesota
+ *  \author Aerospace Engineering and Mechanics
+ *  \copyright Copyright 2015 Regents of the University of Minnesota.  All rights reserved.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "../globaldefs.h"
+#include "mag_model.h"
+
+#define MAG_REF_RADIUS	6371.2				///< [km], geomagnetic reference radius
+#define WGS84_A_KM		6378.137			///< [km], WGS84 semi-major axis
+#define WGS84_E2		0.00669437999014	///< WGS84 eccentricity squared
+#define NT2GAUSS		1.0e-5				///< [Gauss/nT]
+
+#if MAG_EVAL_DEGREE > MAG_MAX_DEGREE
+	#error "MAG_EVAL_DEGREE exceeds MAG_MAX_DEGREE"
+#endif
+
+// local functions
+static int load_cof(const char *filename);
+static void load_builtin(void);
+static double build_date(void);
+
+// raw coefficients [nT], [nT/yr]
+static double g_nm[MAG_MAX_DEGREE+1][MAG_MAX_DEGREE+1], h_nm[MAG_MAX_DEGREE+1][MAG_MAX_DEGREE+1];
+static double gd_nm[MAG_MAX_DEGREE+1][MAG_MAX_DEGREE+1], hd_nm[MAG_MAX_DEGREE+1][MAG_MAX_DEGREE+1];
+static double epoch;
+static int nmax;
+
+// coefficients at the flight date with Schmidt factors folded in, and Legendre recursion constants
+static double gs[MAG_EVAL_DEGREE+1][MAG_EVAL_DEGREE+1], hs[MAG_EVAL_DEGREE+1][MAG_EVAL_DEGREE+1];
+static double K[MAG_EVAL_DEGREE+1][MAG_EVAL_DEGREE+1];
+
+/// IGRF-13 main field at 2020.0 and secular variation 2020-2025, degree 4: n, m, g, h, dg, dh
+static const double igrf13[][6] = {
+	{1, 0, -29404.8,      0.0,  5.7,   0.0},
+	{1, 1,  -1450.9,   4652.5,  7.4, -25.9},
+	{2, 0,  -2499.6,      0.0,-11.0,   0.0},
+	{2, 1,   2982.0,  -2991.6, -7.0, -30.2},
+	{2, 2,   1677.0,   -734.6, -2.1, -22.4},
+	{3, 0,   1363.2,      0.0,  2.2,   0.0},
+	{3, 1,  -2381.2,    -82.1, -5.9,   6.0},
+	{3, 2,   1236.2,    241.9,  3.1,  -1.1},
+	{3, 3,    525.7,   -543.4,-12.0,   0.5},
+	{4, 0,    903.0,      0.0, -1.2,   0.0},
+	{4, 1,    809.5,    281.9, -1.6,  -0.1},
+	{4, 2,     86.3,   -158.4, -5.9,   6.5},
+	{4, 3,   -309.4,    199.7,  5.2,   3.6},
+	{4, 4,     48.0,   -349.7, -5.1,  -5.0}
+};
+#define IGRF13_EPOCH	2020.0
+
+int init_mag_model(void){
+	double dt, S[MAG_EVAL_DEGREE+1][MAG_EVAL_DEGREE+1];
+	int n, m, status = 0;
+
+	memset(g_nm, 0, sizeof(g_nm)); memset(h_nm, 0, sizeof(h_nm));
+	memset(gd_nm, 0, sizeof(gd_nm)); memset(hd_nm, 0, sizeof(hd_nm));
+
+	if (load_cof(MAG_MODEL_FILE) != 0)
+		load_builtin();
+
+	if (nmax > MAG_EVAL_DEGREE) nmax = MAG_EVAL_DEGREE;
+
+#ifdef MAG_MODEL_DATE
+	dt = MAG_MODEL_DATE - epoch;
+#else
+	dt = build_date() - epoch;
+#endif
+	// the secular variation is only valid over the span of the model
+	if (dt < 0.0 || dt > MAG_MODEL_SPAN){
+		dt = (dt < 0.0) ? 0.0 : MAG_MODEL_SPAN;
+		status = -1;
+	}
+
+	// Schmidt semi-normalization factors
+	S[0][0] = 1.0;
+	for (n = 1; n <= nmax; n++){
+		S[n][0] = S[n-1][0]*(2.0*n - 1.0)/n;
+		for (m = 1; m <= n; m++)
+			S[n][m] = S[n][m-1]*sqrt((n - m + 1.0)*(m == 1 ? 2.0 : 1.0)/(n + m));
+	}
+
+	for (n = 0; n <= nmax; n++){
+		for (m = 0; m <= n; m++){
+			gs[n][m] = S[n][m]*(g_nm[n][m] + dt*gd_nm[n][m]);
+			hs[n][m] = S[n][m]*(h_nm[n][m] + dt*hd_nm[n][m]);
+			K[n][m] = (n > 1) ? ((n-1.0)*(n-1.0) - m*m)/((2.0*n - 1.0)*(2.0*n - 3.0)) : 0.0;
+		}
+	}
+
+	return status;
+}
+
+void get_mag_field(double lat, double lon, double alt, struct magfield *magData_ptr){
+	double slat, clat, slon, clon, Rc, p, z, r, ct, st, ar, arn;
+	double sml[MAG_EVAL_DEGREE+1], cml[MAG_EVAL_DEGREE+1];
+	double P[MAG_EVAL_DEGREE+1][MAG_EVAL_DEGREE+1], dP[MAG_EVAL_DEGREE+1][MAG_EVAL_DEGREE+1];
+	double br = 0.0, bt = 0.0, bp = 0.0, tmp, X, Z, cd, sd;
+	int n, m;
+
+	slat = sin(lat); clat = cos(lat);
+	slon = sin(lon); clon = cos(lon);
+
+	// geodetic to geocentric spherical; ct/st are sin/cos of geocentric latitude
+	Rc = WGS84_A_KM/sqrt(1.0 - WGS84_E2*slat*slat);
+	p = (Rc + alt*0.001)*clat;
+	z = (Rc*(1.0 - WGS84_E2) + alt*0.001)*slat;
+	r = sqrt(p*p + z*z);
+	ct = z/r;
+	st = p/r;
+	if (st < 1.0e-8) st = 1.0e-8;	// pole
+
+	// sin/cos of m*lon by angle addition
+	sml[0] = 0.0; cml[0] = 1.0;
+	for (m = 1; m <= nmax; m++){
+		sml[m] = sml[m-1]*clon + cml[m-1]*slon;
+		cml[m] = cml[m-1]*clon - sml[m-1]*slon;
+	}
+
+	// Gauss-normalized associated Legendre functions and their colatitude derivatives
+	P[0][0] = 1.0; dP[0][0] = 0.0;
+	ar = MAG_REF_RADIUS/r;
+	arn = ar*ar;
+	for (n = 1; n <= nmax; n++){
+		arn *= ar;	// (a/r)^(n+2)
+		for (m = 0; m <= n; m++){
+			if (n == m){
+				P[n][m] = st*P[n-1][m-1];
+				dP[n][m] = st*dP[n-1][m-1] + ct*P[n-1][m-1];
+			}
+			else if (m == n - 1){	// K[n][n-1] = 0 and P[n-2][n-1] does not exist
+				P[n][m] = ct*P[n-1][m];
+				dP[n][m] = ct*dP[n-1][m] - st*P[n-1][m];
+			}
+			else{
+				P[n][m] = ct*P[n-1][m] - K[n][m]*P[n-2][m];
+				dP[n][m] = ct*dP[n-1][m] - st*P[n-1][m] - K[n][m]*dP[n-2][m];
+			}
+
+			tmp = gs[n][m]*cml[m] + hs[n][m]*sml[m];
+			br += arn*(n + 1)*tmp*P[n][m];
+			bt -= arn*tmp*dP[n][m];
+			bp += arn*m*(gs[n][m]*sml[m] - hs[n][m]*cml[m])*P[n][m];
+		}
+	}
+	bp /= st;
+
+	// geocentric north/down to geodetic north/down, rotation by (geocentric - geodetic latitude)
+	X = -bt;
+	Z = -br;
+	cd = ct*slat + st*clat;
+	sd = ct*clat - st*slat;
+
+	magData_ptr->hn[0] = (X*cd - Z*sd)*NT2GAUSS;
+	magData_ptr->hn[1] = bp*NT2GAUSS;
+	magData_ptr->hn[2] = (X*sd + Z*cd)*NT2GAUSS;
+	magData_ptr->dec = atan2(magData_ptr->hn[1], magData_ptr->hn[0]);
+	magData_ptr->lat = lat;
+	magData_ptr->lon = lon;
+	magData_ptr->alt = alt;
+	magData_ptr->valid = 1;
+}
+
+int update_mag_field(struct sensordata *sensorData_ptr){
+	struct gps *gpsData_ptr = sensorData_ptr->gpsData_ptr;
+	struct magfield *magData_ptr = sensorData_ptr->magData_ptr;
+	double lat, lon;
+
+	if (gpsData_ptr->navValid != 0)
+		return 0;
+
+	lat = gpsData_ptr->lat*D2R;
+	lon = gpsData_ptr->lon*D2R;
+
+	if (magData_ptr->valid && fabs(lat - magData_ptr->lat) < MAG_UPDATE_TOL
+			&& fabs(lon - magData_ptr->lon)*cos(lat) < MAG_UPDATE_TOL
+			&& fabs(gpsData_ptr->alt - magData_ptr->alt) < MAG_UPDATE_ALT_TOL)
+		return 0;
+
+	get_mag_field(lat, lon, gpsData_ptr->alt, magData_ptr);
+	return 1;
+}
+
+/// Read a NOAA .COF coefficient file. Returns 0 on success.
+static int load_cof(const char *filename){
+	FILE *fp;
+	char line[128];
+	double gnm, hnm, dgnm, dhnm;
+	int n, m;
+
+	if ((fp = fopen(filename, "r")) == NULL)
+		return -1;
+
+	if (fgets(line, sizeof(line), fp) == NULL || sscanf(line, "%lf", &epoch) != 1){
+		fclose(fp);
+		return -1;
+	}
+
+	nmax = 0;
+	while (fgets(line, sizeof(line), fp) != NULL){
+		if (strncmp(line, "9999", 4) == 0)
+			break;
+		if (sscanf(line, "%d %d %lf %lf %lf %lf", &n, &m, &gnm, &hnm, &dgnm, &dhnm) != 6
+				|| n < 1 || n > MAG_MAX_DEGREE || m < 0 || m > n)
+			continue;
+		g_nm[n][m] = gnm; h_nm[n][m] = hnm;
+		gd_nm[n][m] = dgnm; hd_nm[n][m] = dhnm;
+		if (n > nmax) nmax = n;
+	}
+	fclose(fp);
+
+	return (nmax > 0) ? 0 : -1;
+}
+
+/// Use the compiled-in IGRF-13 coefficients.
+static void load_builtin(void){
+	int i, n, m;
+
+	nmax = 0;
+	for (i = 0; i < (int)(sizeof(igrf13)/sizeof(igrf13[0])); i++){
+		n = (int)igrf13[i][0]; m = (int)igrf13[i][1];
+		g_nm[n][m] = igrf13[i][2]; h_nm[n][m] = igrf13[i][3];
+		gd_nm[n][m] = igrf13[i][4]; hd_nm[n][m] = igrf13[i][5];
+		if (n > nmax) nmax = n;
+	}
+	epoch = IGRF13_EPOCH;
+}
+
+/// Decimal year of the build, from __DATE__ ("Mmm dd yyyy").
+static double build_date(void){
+	static const char months[] = "JanFebMarAprMayJunJulAugSepOctNovDec";
+	const char *date = __DATE__;
+	char mon[4];
+	int day = 1, year = 2020, i;
+
+	sscanf(date, "%3s %d %d", mon, &day, &year);
+	for (i = 0; i < 12; i++){
+		if (strncmp(mon, &months[3*i], 3) == 0)
+			break;
+	}
+
+	return year + (30.4375*(i % 12) + day - 1)/365.25;
+}
@@ -0,0 +1,61 @@
+/*
+ * \file mag_model.h
+ *	\details
+ *     Description:     Onboard WMM/IGRF main field evaluator. Keeps the NED Earth field
+ *                      at the aircraft position in sensorData->magData_ptr.
+ *	\ingroup nav_fcns
+ *
+ *  \author University of Minnesota
+ *  \author Aerospace Engineering and Mechanics
+ *  \copyright Copyright 2015 Regents of the University of Minnesota.  All rights reserved.
+ */
+
+#ifndef SOURCE_NAVIGATION_MAG_MODEL_H_
+#define SOURCE_NAVIGATION_MAG_MODEL_H_
+
+#define MAG_MAX_DEGREE		12			///< largest degree stored (WMM)
+
+#ifndef MAG_EVAL_DEGREE
+	#define MAG_EVAL_DEGREE	8			///< degree used onboard; truncation error is a few hundred nT at most
+#endif
+
+#ifndef MAG_MODEL_FILE
+	#define MAG_MODEL_FILE	"WMM.COF"	///< coefficient file in NOAA .COF format; built-in IGRF-13 (degree 4) if missing
+#endif
+
+#ifndef MAG_MODEL_SPAN
+	#define MAG_MODEL_SPAN	5.0			///< [yr] validity of a model after its epoch (WMM and IGRF: 5 years)
+#endif
+
+#define MAG_UPDATE_TOL		2.0e-3		///< [rad] horizontal motion (~12 km) that triggers a re-evaluation
+#define MAG_UPDATE_ALT_TOL	500.0		///< [m] altitude change that triggers a re-evaluation
+
+/// Load the coefficients, propagate them to the flight date and precompute the recursion constants.
+/*!
+* The date is MAG_MODEL_DATE [decimal year] if defined, otherwise the build date. A date outside the validity of the
+* model, epoch to epoch + MAG_MODEL_SPAN, is clamped to it rather than extrapolated with the secular variation.
+* \return 0, or -1 if the date was clamped
+* \ingroup nav_fcns
+*/
+int init_mag_model(void);
+
+/// Evaluate the field at a geodetic position.
+/*!
+* \ingroup nav_fcns
+*/
+void get_mag_field(double lat,						///< [rad], geodetic latitude
+				   double lon,						///< [rad], longitude
+				   double alt,						///< [m], altitude above the WGS84 ellipsoid
+				   struct magfield *magData_ptr	///< pointer to magnetic field data structure
+				   );
+
+/// Re-evaluate the field from the GPS solution if it is not yet valid or the aircraft has moved beyond tolerance.
+/*!
+* Cheap to call every background slot; does nothing without a GPS solution.
+* \return 1 if the field was re-evaluated, 0 otherwise
+* \ingroup nav_fcns
+*/
+int update_mag_field(struct sensordata *sensorData_ptr	///< pointer to sensorData structure
+					  );
+
+#endif /* SOURCE_NAVIGATION_MAG_MODEL_H_ */
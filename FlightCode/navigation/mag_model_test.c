@@ -0,0 +1,75 @@
+/*
+ * \file mag_model_test.c
+ * \description Check of the onboard field evaluator against the published WMM2020 test values.
+ *
+ *	Not part of the flight or SIL builds. Build and run next to the NOAA WMM2020 coefficient file:
+ *
+ *	gcc -DAIRCRAFT_THOR -DMAG_EVAL_DEGREE=12 -DMAG_MODEL_DATE=2020.0 -DMAG_MODEL_FILE=\"WMM.COF\"
+ *		mag_model_test.c mag_model.c -lm -Wl,--allow-multiple-definition -o mag_model_test && ./mag_model_test
+ *
+ *	(globaldefs.h defines base_pitch_cmd, hence the linker flag.)
+ *
+ *	Without WMM.COF only the finiteness of the field over a global grid is checked, with the built-in model.
+ *
+ *	Reference: The US/UK World Magnetic Model for 2020-2025, NOAA Technical Report, 2019, test values.
+ *
+ *  \author University of Minnesota
+ *  \author Aerospace Engineering and Mechanics
+ *  \copyright Copyright 2015 Regents of the University of Minnesota.  All rights reserved.
+ */
+
+#include <math.h>
+#include <stdio.h>
+
+#include "../globaldefs.h"
+#include "mag_model.h"
+
+#define TEST_TOL	1.0		///< [nT], published values are rounded to 0.1 nT
+
+/// WMM2020 test values at 2020.0: lat [deg], lon [deg], alt [m], X, Y, Z [nT]
+static const double wmm2020[][6] = {
+	{ 80.0,   0.0, 0.0,  6570.4,  -146.3,  54606.0},
+	{  0.0, 120.0, 0.0, 39624.3,   109.9, -10932.5},
+	{-80.0, 240.0, 0.0,  5940.6, 15772.1, -52480.8}
+};
+
+int main(void){
+	struct magfield magData;
+	FILE *fp;
+	double err;
+	int i, j, lat, lon, fail = 0;
+
+	init_mag_model();
+
+	for (lat = -90; lat <= 90; lat += 5){
+		for (lon = -180; lon <= 180; lon += 15){
+			get_mag_field(lat*D2R, lon*D2R, 0.0, &magData);
+			for (j = 0; j < 3; j++){
+				if (!isfinite(magData.hn[j])){
+					printf("FAIL non-finite field at %d %d\n", lat, lon);
+					fail = 1;
+				}
+			}
+		}
+	}
+
+	if ((fp = fopen(MAG_MODEL_FILE, "r")) == NULL){
+		printf("%s not found, WMM2020 test values skipped\n", MAG_MODEL_FILE);
+		return fail;
+	}
+	fclose(fp);
+
+	for (i = 0; i < (int)(sizeof(wmm2020)/sizeof(wmm2020[0])); i++){
+		get_mag_field(wmm2020[i][0]*D2R, wmm2020[i][1]*D2R, wmm2020[i][2], &magData);
+		for (j = 0; j < 3; j++){
+			err = magData.hn[j]/1.0e-5 - wmm2020[i][3+j];
+			if (fabs(err) > TEST_TOL){
+				printf("FAIL %g %g axis %d: %.1f nT off\n", wmm2020[i][0], wmm2020[i][1], j, err);
+				fail = 1;
+			}
+		}
+	}
+
+	printf(fail ? "mag_model_test FAILED\n" : "mag_model_test passed\n");
+	return fail;
+}
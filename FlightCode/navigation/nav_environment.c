@@ -0,0 +1,61 @@
+/*
+ * \file nav_environment.c
+ * \description Cached WGS-84 environment terms for nav propagation.
+ *
+ *	Radii of curvature and Earth rate are smooth functions of latitude and altitude, so the filters
+ *	can share one evaluation until the vehicle has moved beyond NAV_ENV_LAT_TOL or NAV_ENV_ALT_TOL.
+ *	A refresh costs one sin, one cos and one sqrt; every other call is two compares.
+ *
+ *  \author University of Minnesota
+ *  \author Aerospace Engineering and Mechanics
+ *  \copyright Copyright 2015 Regents of the University of Minnesota.  All rights reserved.
+ */
+
+#include <math.h>
+
+#include "../globaldefs.h"
+#include "../utils/matrix.h"
+#include "nav_functions.h"
+#include "nav_environment.h"
+
+// local functions
+static void refresh(double lat, double alt);
+
+static struct navenv env;
+
+void init_nav_env(void){
+	env.valid = 0;
+}
+
+struct navenv *get_nav_env(double lat, double alt){
+
+	if (!env.valid || fabs(lat - env.lat) > NAV_ENV_LAT_TOL || fabs(alt - env.alt) > NAV_ENV_ALT_TOL)
+		refresh(lat, alt);
+
+	return &env;
+}
+
+/// Evaluate all cached terms at (lat, alt).
+static void refresh(double lat, double alt){
+	double denom, sdenom;
+
+	env.lat = lat;
+	env.alt = alt;
+
+	env.slat = sin(lat);
+	env.clat = cos(lat);
+	env.tlat = env.slat/env.clat;
+
+	denom = 1.0 - ECC2*env.slat*env.slat;
+	sdenom = sqrt(denom);
+
+	env.Rew = EARTH_RADIUS/sdenom;
+	env.Rns = EARTH_RADIUS*(1.0 - ECC2)/(denom*sdenom);
+	env.inv_Rns_h = 1.0/(env.Rns + alt);
+	env.inv_Rew_h = 1.0/(env.Rew + alt);
+
+	env.we_n = EARTH_RATE*env.clat;
+	env.we_d = -EARTH_RATE*env.slat;
+
+	env.valid = 1;
+}
@@ -0,0 +1,52 @@
+/*
+ * \file nav_environment.h
+ *	\details
+ *     Description:     Cached WGS-84 environment terms for nav propagation: radii of
+ *                      curvature and Earth rate. The terms depend only on latitude and
+ *                      altitude, so they are evaluated once and reused until the vehicle has
+ *                      moved beyond NAV_ENV_LAT_TOL / NAV_ENV_ALT_TOL. llarate() and navrate()
+ *                      of nav_functions.c read them.
+ *	\ingroup nav_fcns
+ *
+ *  \author University of Minnesota
+ *  \author Aerospace Engineering and Mechanics
+ *  \copyright Copyright 2015 Regents of the University of Minnesota.  All rights reserved.
+ */
+
+#ifndef SOURCE_NAVIGATION_NAV_ENVIRONMENT_H_
+#define SOURCE_NAVIGATION_NAV_ENVIRONMENT_H_
+
+#define NAV_ENV_LAT_TOL		1.0e-5		///< [rad] latitude change that triggers a refresh (~60 m)
+#define NAV_ENV_ALT_TOL		10.0		///< [m] altitude change that triggers a refresh
+
+/// Cached environment terms, valid at (lat, alt)
+struct navenv {
+	double lat;			///< [rad], latitude the terms were evaluated at
+	double alt;			///< [m], altitude the terms were evaluated at
+	double slat;		///< sin(lat)
+	double clat;		///< cos(lat)
+	double tlat;		///< tan(lat)
+	double Rns;			///< [m], meridian radius of curvature
+	double Rew;			///< [m], transverse radius of curvature
+	double inv_Rns_h;	///< [1/m], 1/(Rns + alt)
+	double inv_Rew_h;	///< [1/m], 1/(Rew + alt)
+	double we_n;		///< [rad/sec], north component of Earth rate in NED
+	double we_d;		///< [rad/sec], down component of Earth rate in NED
+	int valid;			///< 0 until the first evaluation
+};
+
+/// Invalidate the cache.
+/*!
+* \ingroup nav_fcns
+*/
+void init_nav_env(void);
+
+/// Return the environment terms at (lat, alt), refreshing the cache only if the position has moved beyond tolerance.
+/*!
+* \ingroup nav_fcns
+*/
+struct navenv *get_nav_env(double lat,	///< [rad], latitude
+						   double alt		///< [m], altitude
+						   );
+
+#endif /* SOURCE_NAVIGATION_NAV_ENVIRONMENT_H_ */
@@ -24,6 +24,7 @@
 #include <math.h>
 #include "../utils/matrix.h"
 #include "nav_functions.h"
+#include "nav_environment.h"
 #include "../globaldefs.h"
 
 /*=================================================================*/
@@ -38,9 +39,9 @@ MATRIX eul2dcm(MATRIX euler, MATRIX dcm)
 	*/
 	double cPHI, sPHI, cTHE, sTHE, cPSI, sPSI;
 
-	cPHI = cos(euler[0][0]); sPHI = sin(euler[0][0]);
-	cTHE = cos(euler[1][0]); sTHE = sin(euler[1][0]);
-	cPSI = cos(euler[2][0]); sPSI = sin(euler[2][0]);
+	nav_sincos(euler[0][0], &sPHI, &cPHI);
+	nav_sincos(euler[1][0], &sTHE, &cTHE);
+	nav_sincos(euler[2][0], &sPSI, &cPSI);
 
 	dcm[0][0] = cTHE*cPSI; 				dcm[0][1] = cTHE*sPSI; 					dcm[0][2] = -sTHE;
 	dcm[1][0] = sPHI*sTHE*cPSI - cPHI*sPSI;	dcm[1][1] = sPHI*sTHE*sPSI + cPHI*cPSI;	dcm[1][2] = sPHI*cTHE;
@@ -75,21 +76,23 @@ MATRIX create_R(MATRIX e, MATRIX R)
 	/* This function is used to create the transformation matrix to get
 	* phi_dot, the_dot and psi_dot from given pqr (body rate).
 	*/
-	double ph, th, ps;
+	double sph, cph, sth, cth, sec_th;
 
-	ph = e[0][0]; th = e[1][0]; ps = e[2][0];
+	nav_sincos(e[0][0], &sph, &cph);
+	nav_sincos(e[1][0], &sth, &cth);
+	sec_th = 1.0 / cth;
 
 	R[0][0] = 1.0;
-	R[0][1] = sin(ph)*tan(th);
-	R[0][2] = cos(ph)*tan(th);
+	R[0][1] = sph*sth*sec_th;
+	R[0][2] = cph*sth*sec_th;
 
 	R[1][0] = 0.0;
-	R[1][1] = cos(ph);
-	R[1][2] = -sin(ph);
+	R[1][1] = cph;
+	R[1][2] = -sph;
 
 	R[2][0] = 0.0;
-	R[2][1] = sin(ph) / cos(th);
-	R[2][2] = cos(ph) / cos(th);
+	R[2][1] = sph*sec_th;
+	R[2][2] = cph*sec_th;
 
 	return R;
 }
@@ -98,20 +101,14 @@ MATRIX llarate(MATRIX V, MATRIX lla, MATRIX lla_dot)
 {
 	/* This function calculates the rate of change of latitude, longitude,
 	* and altitude.
-	* Using WGS-84.
+	* Using WGS-84. Radii of curvature come from the nav environment cache.
 	*/
-	double lat, h, Rew, Rns, denom;
+	struct navenv *env;
 
-	lat = lla[0][0]; h = lla[2][0];
+	env = get_nav_env(lla[0][0], lla[2][0]);
 
-	denom = (1.0 - (ECC2 * sin(lat) * sin(lat)));
-	denom = sqrt(denom*denom);
-
-	Rew = EARTH_RADIUS / sqrt(denom);
-	Rns = EARTH_RADIUS*(1 - ECC2) / denom*sqrt(denom);
-
-	lla_dot[0][0] = V[0][0] / (Rns + h);
-	lla_dot[1][0] = V[1][0] / ((Rew + h)*cos(lat));
+	lla_dot[0][0] = V[0][0] * env->inv_Rns_h;
+	lla_dot[1][0] = V[1][0] * env->inv_Rew_h / env->clat;
 	lla_dot[2][0] = -V[2][0];
 
 	return lla_dot;
@@ -121,21 +118,15 @@ MATRIX navrate(MATRIX V, MATRIX lla, MATRIX nr)
 {
 	/* This function calculates the angular velocity of the NED frame,
 	* also known as the navigation rate.
-	* Using WGS-84.
+	* Using WGS-84. Radii of curvature come from the nav environment cache.
 	*/
-	double lat, h, Rew, Rns, denom;
+	struct navenv *env;
 
-	lat = lla[0][0]; h = lla[2][0];
+	env = get_nav_env(lla[0][0], lla[2][0]);
 
-	denom = (1.0 - (ECC2 * sin(lat) * sin(lat)));
-	denom = sqrt(denom*denom);
-
-	Rew = EARTH_RADIUS / sqrt(denom);
-	Rns = EARTH_RADIUS*(1 - ECC2) / denom*sqrt(denom);
-
-	nr[0][0] = V[1][0] / (Rew + h);
-	nr[1][0] = -V[0][0] / (Rns + h);
-	nr[2][0] = -V[1][0] * tan(lat) / (Rew + h);
+	nr[0][0] = V[1][0] * env->inv_Rew_h;
+	nr[1][0] = -V[0][0] * env->inv_Rns_h;
+	nr[2][0] = -V[1][0] * env->tlat * env->inv_Rew_h;
 
 	return nr;
 }
@@ -380,14 +371,16 @@ void quat2eul(double *q, double *phi, double *the, double *psi) {
 }
 
 void eul2quat(double *q, double phi, double the, double psi) {
-	phi = phi / 2.0;
-	the = the / 2.0;
-	psi = psi / 2.0;
-
-	q[0] = cos(psi)*cos(the)*cos(phi) + sin(psi)*sin(the)*sin(phi);
-	q[1] = cos(psi)*cos(the)*sin(phi) - sin(psi)*sin(the)*cos(phi);
-	q[2] = cos(psi)*sin(the)*cos(phi) + sin(psi)*cos(the)*sin(phi);
-	q[3] = sin(psi)*cos(the)*cos(phi) - cos(psi)*sin(the)*sin(phi);
+	double sphi, cphi, sthe, cthe, spsi, cpsi;
+
+	nav_sincos(phi / 2.0, &sphi, &cphi);
+	nav_sincos(the / 2.0, &sthe, &cthe);
+	nav_sincos(psi / 2.0, &spsi, &cpsi);
+
+	q[0] = cpsi*cthe*cphi + spsi*sthe*sphi;
+	q[1] = cpsi*cthe*sphi - spsi*sthe*cphi;
+	q[2] = cpsi*sthe*cphi + spsi*cthe*sphi;
+	q[3] = spsi*cthe*cphi - cpsi*sthe*sphi;
 }
 
 MATRIX quat2dcm(double *q, MATRIX C_N2B) {
@@ -424,17 +417,18 @@ MATRIX quat2dcm(double *q, MATRIX C_N2B) {
 MATRIX EulerToDcm(MATRIX euler, double decA, MATRIX dcm)
 {
 	MATRIX A, B;
-	double cPHI, sPHI, cTHE, sTHE, cPSI, sPSI;
+	double cPHI, sPHI, cTHE, sTHE, cPSI, sPSI, cDEC, sDEC;
 
-	cPHI = cos(euler[2][0]); sPHI = sin(euler[2][0]);
-	cTHE = cos(euler[1][0]); sTHE = sin(euler[1][0]);
-	cPSI = cos(euler[0][0]); sPSI = sin(euler[0][0]);
+	nav_sincos(euler[2][0], &sPHI, &cPHI);
+	nav_sincos(euler[1][0], &sTHE, &cTHE);
+	nav_sincos(euler[0][0], &sPSI, &cPSI);
+	nav_sincos(decA, &sDEC, &cDEC);
 
 	A = mat_creat(3, 3, ZERO_MATRIX);
 	B = mat_creat(3, 3, UNDEFINED);
 
-	A[0][0] = cos(decA); A[0][1] = -sin(decA);
-	A[1][0] = sin(decA); A[1][1] = cos(decA);
+	A[0][0] = cDEC; A[0][1] = -sDEC;
+	A[1][0] = sDEC; A[1][1] = cDEC;
 	A[2][2] = 1;
 
 	B[0][0] = cTHE*cPSI; B[0][1] = sPHI*sTHE*cPSI - cPHI*sPSI; B[0][2] = cPHI*sTHE*cPSI + sPHI*sPSI;
@@ -645,23 +639,23 @@ void eCntrans(MATRIX e_C_n, MATRIX LatLon)
 
 void lCbtrans(MATRIX l_C_b, MATRIX YawPitchRoll)
 {
-	double psi, theta, phi;
+	double spsi, cpsi, sthe, cthe, sphi, cphi;
 
-	psi = YawPitchRoll[0][0];
-	theta = YawPitchRoll[1][0];
-	phi = YawPitchRoll[2][0];
+	nav_sincos(YawPitchRoll[0][0], &spsi, &cpsi);
+	nav_sincos(YawPitchRoll[1][0], &sthe, &cthe);
+	nav_sincos(YawPitchRoll[2][0], &sphi, &cphi);
 
-	l_C_b[0][0] = cos(theta)*cos(psi);
-	l_C_b[0][1] = -cos(phi)*sin(psi) + sin(phi)*sin(theta)*cos(psi);
-	l_C_b[0][2] = sin(phi)*sin(psi) + cos(phi)*sin(theta)*cos(psi);
+	l_C_b[0][0] = cthe*cpsi;
+	l_C_b[0][1] = -cphi*spsi + sphi*sthe*cpsi;
+	l_C_b[0][2] = sphi*spsi + cphi*sthe*cpsi;
 
-	l_C_b[1][0] = cos(theta)*sin(psi);
-	l_C_b[1][1] = cos(phi)*cos(psi) + sin(phi)*sin(theta)*sin(psi);
-	l_C_b[1][2] = -sin(phi)*cos(psi) + cos(phi)*sin(theta)*sin(psi);
+	l_C_b[1][0] = cthe*spsi;
+	l_C_b[1][1] = cphi*cpsi + sphi*sthe*spsi;
+	l_C_b[1][2] = -sphi*cpsi + cphi*sthe*spsi;
 
-	l_C_b[2][0] = -sin(theta);
-	l_C_b[2][1] = sin(phi)*cos(theta);
-	l_C_b[2][2] = cos(phi)*cos(theta);
+	l_C_b[2][0] = -sthe;
+	l_C_b[2][1] = sphi*cthe;
+	l_C_b[2][2] = cphi*cthe;
 }
 
 //+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
@@ -21,6 +21,9 @@
 #ifndef SOURCE_NAVIGATION_NAV_FUNCTIONS_H_
 #define SOURCE_NAVIGATION_NAV_FUNCTIONS_H_
 
+#include <math.h>
+#include "../utils/matrix.h"
+
 /*     Define Constants   */
 
 #define EARTH_RATE   0.00007292115   /* rotation rate of earth (rad/sec) */
@@ -44,6 +47,20 @@
 /*---------------     Define Structures and Enumerated Types -------------*/
 typedef enum { OFF, ON } toggle;
 
+/* Function:     void nav_sincos(double x, double *s, double *c)
+* ----------------------------------------------------------------
+* Sine and cosine of the same angle in one call. Uses the compiler's
+* sincos builtin where available, which shares the argument reduction.
+*/
+static inline void nav_sincos(double x, double *s, double *c)
+{
+#ifdef __GNUC__
+	__builtin_sincos(x, s, c);
+#else
+	*s = sin(x); *c = cos(x);
+#endif
+}
+
 
 MATRIX eul2dcm(MATRIX euler, MATRIX dcm);
 
@@ -0,0 +1,129 @@
+/*
+ * \file nav_health.c
+ * \description Consistency monitor for the GPS-aided INS and DR filters.
+ *
+ *	Every GPS measurement update produces an innovation (gpsmu_innov) and its predicted covariance
+ *	(gpsmu_innov_covar). The normalized innovation squared (NIS) of one update, summed over the six
+ *	position and velocity terms, is chi-square distributed with 6 degrees of freedom for a consistent
+ *	filter. The monitor keeps the last NAV_HEALTH_WINDOW NIS values of each filter in a ring buffer with a
+ *	running sum, so each update costs one subtraction and one addition, and compares the window sum against
+ *	chi-square bounds precomputed at init. A filter whose window sum exceeds the divergence bound is flagged
+ *	nav_diverged; the blender then drops it, its updates stop, and the main loop re-initializes it in the background
+ *	slot of the telemetry frame. A diverged filter stays flagged until then.
+ *
+ *  \author University of Minnesota
+ *  \author Aerospace Engineering and Mechanics
+ *  \copyright Copyright 2015 Regents of the University of Minnesota.  All rights reserved.
+ */
+
+#include <math.h>
+
+#include "../globaldefs.h"
+#include "nav_interface.h"
+
+#define NAV_HEALTH_WINDOW	10		///< number of GPS measurement updates in the NIS window
+#define NAV_HEALTH_DOF		6		///< degrees of freedom of one update (3 position, 3 velocity)
+#define NAV_HEALTH_Z_WARN	2.326	///< standard normal quantile of the warning bound (99%)
+#define NAV_HEALTH_Z_DIVERGE	3.719	///< standard normal quantile of the divergence bound (99.99%)
+
+/// NIS window of one filter
+struct nis_window {
+	double nis[NAV_HEALTH_WINDOW];	///< NIS of the last updates, ring buffer
+	double sum;						///< running sum of nis[]
+	int head;						///< next slot to overwrite
+	int count;						///< number of valid entries
+};
+
+// local functions
+static enum navhealthdefs update_window(struct nis_window *win, double *innov, double *innov_covar, double *nis_avg);
+static double chi2_quantile(double k, double z);
+
+static struct nis_window window[2];
+
+// chi-square bounds on the window sum, indexed by the number of updates in the window
+static double warn_bound[NAV_HEALTH_WINDOW+1], diverge_bound[NAV_HEALTH_WINDOW+1];
+
+void init_nav_health(struct nav *navData_ptr){
+	int n;
+
+	for (n = 1; n <= NAV_HEALTH_WINDOW; n++){
+		warn_bound[n] = chi2_quantile(n*NAV_HEALTH_DOF, NAV_HEALTH_Z_WARN);
+		diverge_bound[n] = chi2_quantile(n*NAV_HEALTH_DOF, NAV_HEALTH_Z_DIVERGE);
+	}
+
+	reset_nav_health(navData_ptr, NAV_HEALTH_INSGPS);
+	reset_nav_health(navData_ptr, NAV_HEALTH_AHRSDR);
+}
+
+void get_nav_health(struct sensordata *sensorData_ptr, struct insgps *insgpsData_ptr, struct ahrsdr *ahrsdrData_ptr, struct nav *navData_ptr){
+
+	// innovations are only fresh on frames with a GPS measurement update
+	if (sensorData_ptr->gpsData_ptr->newData != 1)
+		return;
+
+	// a diverged filter is held, its innovations are stale until it is re-initialized
+	if ((insgpsData_ptr->err_type == gps_aided || insgpsData_ptr->err_type == inflated_gps_aided)
+			&& navData_ptr->insgps_health != nav_diverged)
+		navData_ptr->insgps_health = update_window(&window[NAV_HEALTH_INSGPS], insgpsData_ptr->gpsmu_innov,
+				insgpsData_ptr->gpsmu_innov_covar, &navData_ptr->insgps_nis);
+
+	if ((ahrsdrData_ptr->err_type_2 == gps_aided || ahrsdrData_ptr->err_type_2 == inflated_gps_aided)
+			&& navData_ptr->ahrsdr_health != nav_diverged)
+		navData_ptr->ahrsdr_health = update_window(&window[NAV_HEALTH_AHRSDR], ahrsdrData_ptr->gpsmu_innov,
+				ahrsdrData_ptr->gpsmu_innov_covar, &navData_ptr->ahrsdr_nis);
+}
+
+void reset_nav_health(struct nav *navData_ptr, int filter){
+	int i;
+
+	for (i = 0; i < NAV_HEALTH_WINDOW; i++) window[filter].nis[i] = 0.0;
+	window[filter].sum = 0.0;
+	window[filter].head = 0;
+	window[filter].count = 0;
+
+	if (filter == NAV_HEALTH_INSGPS){
+		navData_ptr->insgps_health = nav_healthy;
+		navData_ptr->insgps_nis = 0.0;
+	}
+	else{
+		navData_ptr->ahrsdr_health = nav_healthy;
+		navData_ptr->ahrsdr_nis = 0.0;
+	}
+}
+
+/// Push the NIS of one update into the window and classify the window sum.
+static enum navhealthdefs update_window(struct nis_window *win, double *innov, double *innov_covar, double *nis_avg){
+	double nis = 0.0;
+	int i;
+
+	for (i = 0; i < NAV_HEALTH_DOF; i++){
+		if (innov_covar[i] > 0.0)
+			nis += innov[i]*innov[i]/innov_covar[i];
+	}
+
+	win->sum += nis - win->nis[win->head];
+	win->nis[win->head] = nis;
+	win->head = (win->head + 1) % NAV_HEALTH_WINDOW;
+	if (win->count < NAV_HEALTH_WINDOW) win->count++;
+
+	// guard the running sum against round-off drift
+	if (win->sum < 0.0) win->sum = 0.0;
+
+	*nis_avg = win->sum/win->count;
+
+	// a single outlier cannot declare divergence; wait for a full window
+	if (win->count == NAV_HEALTH_WINDOW && win->sum > diverge_bound[win->count])
+		return nav_diverged;
+	else if (win->sum > warn_bound[win->count])
+		return nav_suspect;
+	else
+		return nav_healthy;
+}
+
+/// Wilson-Hilferty approximation of the chi-square quantile with k degrees of freedom at normal quantile z.
+static double chi2_quantile(double k, double z){
+	double c = 2.0/(9.0*k);
+	double t = 1.0 - c + z*sqrt(c);
+
+	return k*t*t*t;
+}
@@ -137,5 +137,71 @@ void get_nav(struct sensordata *sensorData_ptr,	///< pointer to sensorData struc
 void close_nav(void);
 //****************************************************************************************//
 
+//*********************************NAV TRIG CACHE*****************************************//
+/// Fill navData->trig with the sin/cos of the current attitude and position, ground track and ground speed.
+/*!
+* Called once per frame right after the blender; guidance and control read the cached terms
+* instead of evaluating trig of the nav solution themselves.
+* \ingroup nav_fcns
+*/
+void update_nav_trig(struct nav *navData_ptr	///< pointer to blended nav Data structure
+					);
+//****************************************************************************************//
+
+//*********************************LOCAL TANGENT PLANE************************************//
+/// Latch the local tangent plane origin at the current nav position and zero pos_ned.
+/*!
+* Requires navData->trig to be current.
+* \sa update_nav_ltp()
+* \ingroup nav_fcns
+*/
+void set_nav_ltp_origin(struct nav *navData_ptr	///< pointer to blended nav Data structure
+					);
+
+/// Update navData->ltp.pos_ned from the current nav position.
+/*!
+* Flat-earth increment from the previous frame, re-anchored with the exact ECEF transform every
+* NAV_LTP_ANCHOR_FRAMES frames. Does nothing until an origin is latched. Call after update_nav_trig().
+* \sa set_nav_ltp_origin()
+* \ingroup nav_fcns
+*/
+void update_nav_ltp(struct nav *navData_ptr	///< pointer to blended nav Data structure
+					);
+//****************************************************************************************//
+
+//*********************************NAV HEALTH FUNCTIONS***********************************//
+#define NAV_HEALTH_INSGPS	0	///< index of the GPS-aided INS filter in the health monitor
+#define NAV_HEALTH_AHRSDR	1	///< index of the DR filter in the health monitor
+
+/// Initialize the nav health monitor. Both filters start out healthy.
+/*!
+* \sa get_nav_health(), reset_nav_health()
+* \ingroup nav_fcns
+*/
+void init_nav_health(struct nav *navData_ptr		///< pointer to blended nav Data structure
+					);
+
+/// Update the windowed NIS of each filter from its latest GPS measurement update and set its health.
+/*!
+* Must be called after the filters run and before the GPS newData flag is cleared. O(1) per call.
+* \sa init_nav_health(), reset_nav_health()
+* \ingroup nav_fcns
+*/
+void get_nav_health(struct sensordata *sensorData_ptr,	///< pointer to sensorData structure
+					struct insgps *insgpsData_ptr,		///< pointer to GPS-aided INS Data structure
+					struct ahrsdr *ahrsdrData_ptr,		///< pointer to AHRS-DR Data structure
+					struct nav *navData_ptr				///< pointer to blended nav Data structure
+					);
+
+/// Clear the NIS window of one filter after it has been re-initialized.
+/*!
+* \sa init_nav_health(), get_nav_health()
+* \ingroup nav_fcns
+*/
+void reset_nav_health(struct nav *navData_ptr,	///< pointer to blended nav Data structure
+					  int filter					///< NAV_HEALTH_INSGPS or NAV_HEALTH_AHRSDR
+					);
+//****************************************************************************************//
+
 
 #endif /* SOURCE_NAVIGATION_NAV_INTERFACE_H_ */
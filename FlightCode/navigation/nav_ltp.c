@@ -0,0 +1,108 @@
+/*
+ * \file nav_ltp.c
+ * \description Local tangent plane position of the blended nav solution.
+ *
+ *	The origin is latched at autopilot engage. Every frame the NED position is advanced with a
+ *	flat-earth increment from the previous frame's lat/lon/alt, using radii of curvature held since
+ *	the last anchor. Every NAV_LTP_ANCHOR_FRAMES frames the position is recomputed exactly through
+ *	ECEF, which removes the drift of the flat-earth approximation and refreshes the radii. Guidance
+ *	laws read navData->ltp.pos_ned instead of doing their own ECEF round trip.
+ *
+ *  \author University of Minnesota
+ *  \author Aerospace Engineering and Mechanics
+ *  \copyright Copyright 2015 Regents of the University of Minnesota.  All rights reserved.
+ */
+
+#include <math.h>
+
+#include "../globaldefs.h"
+#include "../utils/matrix.h"
+#include "nav_functions.h"
+#include "nav_interface.h"
+
+#define NAV_LTP_ANCHOR_FRAMES	50	///< frames between exact ECEF re-anchoring (1 sec at 50 Hz)
+
+// local functions
+static void anchor(struct nav *navData_ptr);
+static void lla2ecef_trig(double alt, struct navtrig *trig, double *ecef, double *Rn);
+
+static double ecef0[3];				// ECEF position of the origin
+static double T_ecef2ned[3][3];		// ECEF to NED rotation at the origin
+static double lat_last, lon_last, alt_last;
+static double scale_n, scale_e;		// [m/rad], (Rns + h) and (Rew + h)*cos(lat) at the last anchor
+static int frames;
+
+void set_nav_ltp_origin(struct nav *navData_ptr){
+	struct navtrig *trig = &navData_ptr->trig;
+	double Rn;
+
+	navData_ptr->ltp.lat0 = navData_ptr->lat;
+	navData_ptr->ltp.lon0 = navData_ptr->lon;
+	navData_ptr->ltp.alt0 = navData_ptr->alt;
+
+	lla2ecef_trig(navData_ptr->alt, trig, ecef0, &Rn);
+
+	T_ecef2ned[0][0] = -trig->slat*trig->clon; T_ecef2ned[0][1] = -trig->slat*trig->slon; T_ecef2ned[0][2] =  trig->clat;
+	T_ecef2ned[1][0] = -trig->slon;            T_ecef2ned[1][1] =  trig->clon;            T_ecef2ned[1][2] =  0.0;
+	T_ecef2ned[2][0] = -trig->clat*trig->clon; T_ecef2ned[2][1] = -trig->clat*trig->slon; T_ecef2ned[2][2] = -trig->slat;
+
+	navData_ptr->ltp.valid = 1;
+	anchor(navData_ptr);
+}
+
+void update_nav_ltp(struct nav *navData_ptr){
+	double *pos_ned = navData_ptr->ltp.pos_ned;
+	double dlon;
+
+	if (!navData_ptr->ltp.valid)
+		return;
+
+	if (++frames >= NAV_LTP_ANCHOR_FRAMES){
+		anchor(navData_ptr);
+		return;
+	}
+
+	// flat-earth increment
+	dlon = navData_ptr->lon - lon_last;
+	if (dlon > PI) dlon -= PI2;
+	else if (dlon < -PI) dlon += PI2;
+
+	pos_ned[0] += (navData_ptr->lat - lat_last)*scale_n;
+	pos_ned[1] += dlon*scale_e;
+	pos_ned[2] -= (navData_ptr->alt - alt_last);
+
+	lat_last = navData_ptr->lat;
+	lon_last = navData_ptr->lon;
+	alt_last = navData_ptr->alt;
+}
+
+/// Exact NED position through ECEF, and fresh radii for the following increments.
+static void anchor(struct nav *navData_ptr){
+	struct navtrig *trig = &navData_ptr->trig;
+	double ecef[3], d[3], Rn, denom;
+	int i;
+
+	lla2ecef_trig(navData_ptr->alt, trig, ecef, &Rn);
+	for (i = 0; i < 3; i++) d[i] = ecef[i] - ecef0[i];
+	for (i = 0; i < 3; i++)
+		navData_ptr->ltp.pos_ned[i] = T_ecef2ned[i][0]*d[0] + T_ecef2ned[i][1]*d[1] + T_ecef2ned[i][2]*d[2];
+
+	// Rns = Rn^3 (1-e^2)/a^2
+	denom = Rn/EARTH_RADIUS;
+	scale_n = Rn*denom*denom*(1.0 - ECC2) + navData_ptr->alt;
+	scale_e = (Rn + navData_ptr->alt)*trig->clat;
+
+	lat_last = navData_ptr->lat;
+	lon_last = navData_ptr->lon;
+	alt_last = navData_ptr->alt;
+	frames = 0;
+}
+
+/// ECEF position from altitude and the cached lat/lon trig; also returns the transverse radius Rn.
+static void lla2ecef_trig(double alt, struct navtrig *trig, double *ecef, double *Rn){
+	*Rn = EARTH_RADIUS/sqrt(1.0 - ECC2*trig->slat*trig->slat);
+
+	ecef[0] = (*Rn + alt)*trig->clat*trig->clon;
+	ecef[1] = (*Rn + alt)*trig->clat*trig->slon;
+	ecef[2] = (*Rn*(1.0 - ECC2) + alt)*trig->slat;
+}
@@ -0,0 +1,32 @@
+/*
+ * \file nav_trig.c
+ * \description Per-frame trig cache of the blended nav solution.
+ *
+ *	Attitude and position trig is needed by guidance, control and the nav helper functions alike.
+ *	update_nav_trig() evaluates it once per frame, right after the blender, with paired sin/cos
+ *	calls; consumers read navData->trig instead of calling sin/cos/atan2 on the nav solution.
+ *
+ *  \author University of Minnesota
+ *  \author Aerospace Engineering and Mechanics
+ *  \copyright Copyright 2015 Regents of the University of Minnesota.  All rights reserved.
+ */
+
+#include <math.h>
+
+#include "../globaldefs.h"
+#include "../utils/matrix.h"
+#include "nav_functions.h"
+#include "nav_interface.h"
+
+void update_nav_trig(struct nav *navData_ptr){
+	struct navtrig *trig = &navData_ptr->trig;
+
+	nav_sincos(navData_ptr->phi, &trig->sphi, &trig->cphi);
+	nav_sincos(navData_ptr->the, &trig->sthe, &trig->cthe);
+	nav_sincos(navData_ptr->psi, &trig->spsi, &trig->cpsi);
+	nav_sincos(navData_ptr->lat, &trig->slat, &trig->clat);
+	nav_sincos(navData_ptr->lon, &trig->slon, &trig->clon);
+
+	trig->gndtrk = atan2(navData_ptr->ve, navData_ptr->vn);
+	trig->gndspd = sqrt(navData_ptr->vn*navData_ptr->vn + navData_ptr->ve*navData_ptr->ve);
+}
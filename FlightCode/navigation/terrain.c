@@ -0,0 +1,352 @@
+/*
+ * \file terrain.c
+ * \description Terrain height from a cache of SRTM .hgt DEM tiles.
+ *
+ *	An .hgt tile covers 1x1 deg from its south west corner, as TERRAIN_TILE_SIZE rows of big endian
+ *	16 bit heights in meters, north row first. The loader thread maps the file where the platform
+ *	supports memory mapped files (reads it otherwise), decodes it into the least recently used cache
+ *	slot, and publishes the slot. The geoid undulation at the four corners of the tile is read from the
+ *	EGM96 grid of TERRAIN_GEOID_FILE at the same time, streamed only as far as the rows needed, so the
+ *	grid is never held in memory; a tile without it is not used. All cache state is guarded by one mutex, which the loader never holds
+ *	during file I/O, so the control thread only ever waits for a few bookkeeping instructions.
+ *
+ *  \author University of Minnesota
+ *  \author Aerospace Engineering and Mechanics
+ *  \copyright Copyright 2015 Regents of the University of Minnesota.  All rights reserved.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#if defined(_POSIX_MAPPED_FILES) && _POSIX_MAPPED_FILES > 0
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+#endif
+
+#include "../globaldefs.h"
+#include "terrain.h"
+
+#define N	TERRAIN_TILE_SIZE
+
+/// Cache slot state
+enum tile_state {
+	TILE_EMPTY,		///< unused
+	TILE_LOADING,	///< being read by the loader; not to be touched by lookups
+	TILE_READY,		///< heights valid
+	TILE_MISSING	///< no usable file for the tile; kept so it is not requested again every frame
+};
+
+/// Cache slot
+struct tile {
+	int key;					///< tile index, see tile_key()
+	enum tile_state state;		///< slot state
+	unsigned long used;			///< lookup clock at the last use, for the LRU
+	double und[4];				///< [m], geoid undulation at the NW, NE, SW and SE corners
+	short *h;					///< [m], heights above the geoid, north row first, N*N posts
+};
+
+// local functions
+static void *loader(void *arg);
+static int load_tile(int key, short *h);
+static int load_undulation(int key, double *und);
+static int tile_key(double lat, double lon);
+static int find(int key);
+static int victim(void);
+static void enqueue(int key);
+
+static struct tile cache[TERRAIN_CACHE_TILES];
+static short *heights;				// height posts of all the cache slots
+static unsigned long clock_use;		// lookups so far
+static int queue[TERRAIN_QUEUE];	// pending tile keys
+static int q_head, q_tail;
+static int running;
+
+static pthread_t loader_thread;
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t wake = PTHREAD_COND_INITIALIZER;
+
+int init_terrain(void){
+	int i;
+
+	if (running)
+		return 0;
+
+	if ((heights = malloc((size_t)TERRAIN_CACHE_TILES*N*N*sizeof(short))) == NULL)
+		return -1;
+	for (i = 0; i < TERRAIN_CACHE_TILES; i++){
+		cache[i].state = TILE_EMPTY;
+		cache[i].key = -1;
+		cache[i].h = heights + (size_t)i*N*N;
+	}
+	q_head = q_tail = 0;
+	clock_use = 0;
+
+	running = 1;
+	if (pthread_create(&loader_thread, NULL, loader, NULL) != 0){
+		running = 0;
+		free(heights);
+		heights = NULL;
+		return -1;
+	}
+	return 0;
+}
+
+void close_terrain(void){
+	if (!running)
+		return;
+
+	pthread_mutex_lock(&lock);
+	running = 0;
+	pthread_cond_signal(&wake);
+	pthread_mutex_unlock(&lock);
+	pthread_join(loader_thread, NULL);
+
+	free(heights);
+	heights = NULL;
+}
+
+int terrain_height(double lat, double lon, double *h){
+	const short *p;
+	const double *u;
+	double r, c, fr, fc, gr, gc;
+	int key, slot, i, j, ok = 0;
+
+	if (!running)
+		return 0;
+
+	lat *= R2D;
+	lon *= R2D;
+	key = tile_key(lat, lon);
+
+	// fractional row from the north edge and column from the west edge
+	r = (floor(lat) + 1.0 - lat)*(N - 1);
+	c = (lon - floor(lon))*(N - 1);
+	i = (int)r;
+	j = (int)c;
+	if (i > N - 2) i = N - 2;
+	if (j > N - 2) j = N - 2;
+	fr = r - i;
+	fc = c - j;
+	gr = r/(N - 1);
+	gc = c/(N - 1);
+
+	pthread_mutex_lock(&lock);
+	if ((slot = find(key)) < 0)
+		enqueue(key);
+	else{
+		cache[slot].used = ++clock_use;
+		if (cache[slot].state == TILE_READY){
+			p = &cache[slot].h[i*N + j];
+			if (p[0] != TERRAIN_VOID && p[1] != TERRAIN_VOID && p[N] != TERRAIN_VOID && p[N + 1] != TERRAIN_VOID){
+				u = cache[slot].und;
+				*h = (1.0 - fr)*((1.0 - fc)*p[0] + fc*p[1]) + fr*((1.0 - fc)*p[N] + fc*p[N + 1])
+						+ (1.0 - gr)*((1.0 - gc)*u[0] + gc*u[1]) + gr*((1.0 - gc)*u[2] + gc*u[3]);
+				ok = 1;
+			}
+		}
+	}
+	pthread_mutex_unlock(&lock);
+
+	return ok;
+}
+
+void terrain_prefetch(double lat, double lon){
+	int key = tile_key(lat*R2D, lon*R2D);
+
+	if (!running)
+		return;
+
+	pthread_mutex_lock(&lock);
+	if (find(key) < 0)
+		enqueue(key);
+	pthread_mutex_unlock(&lock);
+}
+
+/// Loader thread: takes tile keys off the queue and loads them into the LRU slot.
+static void *loader(void *arg){
+	int key, slot, ok;
+
+	pthread_mutex_lock(&lock);
+	while (running){
+		if (q_head == q_tail){
+			pthread_cond_wait(&wake, &lock);
+			continue;
+		}
+		key = queue[q_tail];
+		q_tail = (q_tail + 1) % TERRAIN_QUEUE;
+		if (find(key) >= 0 || (slot = victim()) < 0)
+			continue;
+
+		cache[slot].key = key;
+		cache[slot].state = TILE_LOADING;
+		pthread_mutex_unlock(&lock);
+
+		ok = load_undulation(key, cache[slot].und) && load_tile(key, cache[slot].h);
+
+		pthread_mutex_lock(&lock);
+		cache[slot].state = ok ? TILE_READY : TILE_MISSING;
+		cache[slot].used = clock_use;
+	}
+	pthread_mutex_unlock(&lock);
+
+	return NULL;
+}
+
+/// Read and decode one tile. Returns 1 on success.
+static int load_tile(int key, short *h){
+	char name[64];
+	const unsigned char *b;
+	int lat = key/360 - 90, lon = key%360 - 180;
+	long i, n = (long)N*N;
+
+	snprintf(name, sizeof(name), "%s/%c%02d%c%03d.hgt", TERRAIN_DIR, (lat < 0) ? 'S' : 'N', (lat < 0) ? -lat : lat,
+			(lon < 0) ? 'W' : 'E', (lon < 0) ? -lon : lon);
+
+#if defined(_POSIX_MAPPED_FILES) && _POSIX_MAPPED_FILES > 0
+	{
+		struct stat st;
+		void *map;
+		int fd;
+
+		if ((fd = open(name, O_RDONLY)) < 0)
+			return 0;
+		if (fstat(fd, &st) != 0 || st.st_size != 2*n || (map = mmap(NULL, 2*n, PROT_READ, MAP_PRIVATE, fd, 0)) == MAP_FAILED){
+			close(fd);
+			return 0;	// not a tile of this resolution
+		}
+		b = (const unsigned char *)map;
+		for (i = 0; i < n; i++)
+			h[i] = (short)((b[2*i] << 8) | b[2*i + 1]);
+		munmap(map, 2*n);
+		close(fd);
+	}
+#else
+	{
+		unsigned char row[2*N];
+		FILE *fp;
+		long j;
+
+		if ((fp = fopen(name, "rb")) == NULL)
+			return 0;
+		if (fseek(fp, 0, SEEK_END) != 0 || ftell(fp) != 2*n || fseek(fp, 0, SEEK_SET) != 0){
+			fclose(fp);
+			return 0;	// not a tile of this resolution
+		}
+		b = row;
+		for (i = 0; i < N; i++){
+			if (fread(row, 2, N, fp) != N){
+				fclose(fp);
+				return 0;
+			}
+			for (j = 0; j < N; j++)
+				h[i*N + j] = (short)((b[2*j] << 8) | b[2*j + 1]);
+		}
+		fclose(fp);
+	}
+#endif
+
+	return 1;
+}
+
+/// Read the geoid undulation at the corners of a tile from the EGM96 grid. Returns 1 on success.
+/*!
+ * The NGA .GRD file starts with the grid bounds and spacing, "south north west east dlat dlon" in degrees,
+ * followed by the undulations in meters, north row first, each row west to east. Only the values up to the
+ * south corners of the tile are read.
+ */
+static int load_undulation(int key, double *und){
+	double south, north, west, east, dlat, dlon, v;
+	int lat = key/360 - 90, lon = key%360 - 180;
+	long ncol, row[2], col[2], idx[4], last, k;
+	int i, found = 0;
+	FILE *fp;
+
+	if ((fp = fopen(TERRAIN_GEOID_FILE, "r")) == NULL)
+		return 0;
+	if (fscanf(fp, "%lf %lf %lf %lf %lf %lf", &south, &north, &west, &east, &dlat, &dlon) != 6
+			|| !(dlat > 0.0 && dlon > 0.0) || lat < south || lat + 1 > north){
+		fclose(fp);
+		return 0;
+	}
+	ncol = (long)floor((east - west)/dlon + 0.5) + 1;
+
+	// nearest grid nodes to the north and south edges, and the west and east edges wrapped onto the grid
+	row[0] = (long)floor((north - (lat + 1))/dlat + 0.5);
+	row[1] = (long)floor((north - lat)/dlat + 0.5);
+	for (i = 0; i < 2; i++){
+		v = fmod(lon + i - west, 360.0);
+		if (v < 0.0) v += 360.0;
+		col[i] = (long)floor(v/dlon + 0.5);
+		if (col[i] >= ncol) col[i] -= (long)floor(360.0/dlon + 0.5);
+	}
+	for (i = 0; i < 4; i++)
+		idx[i] = row[i/2]*ncol + col[i%2];
+	last = mymax(idx[2], idx[3]);
+
+	for (k = 0; k <= last && fscanf(fp, "%lf", &v) == 1; k++){
+		for (i = 0; i < 4; i++){
+			if (idx[i] == k){
+				und[i] = v;
+				found++;
+			}
+		}
+	}
+	fclose(fp);
+
+	return (found == 4);
+}
+
+/// Index of the tile holding a position [deg].
+static int tile_key(double lat, double lon){
+	int ilat = (int)floor(lat), ilon = (int)floor(lon);
+
+	if (ilat > 89) ilat = 89;
+	if (ilon > 179) ilon -= 360;
+	return (ilat + 90)*360 + (ilon + 180);
+}
+
+/// Cache slot of a tile in any state, -1 if none. Call with the lock held.
+static int find(int key){
+	int i;
+
+	for (i = 0; i < TERRAIN_CACHE_TILES; i++){
+		if (cache[i].key == key && cache[i].state != TILE_EMPTY)
+			return i;
+	}
+	return -1;
+}
+
+/// Slot to load the next tile into: an empty one, else the least recently used one not being loaded.
+/// Call with the lock held.
+static int victim(void){
+	int i, best = -1;
+
+	for (i = 0; i < TERRAIN_CACHE_TILES; i++){
+		if (cache[i].state == TILE_EMPTY)
+			return i;
+		if (cache[i].state != TILE_LOADING && (best < 0 || cache[i].used < cache[best].used))
+			best = i;
+	}
+	return best;
+}
+
+/// Add a tile to the load queue unless it is queued already; dropped if the queue is full. Call with the lock
+/// held.
+static void enqueue(int key){
+	int i;
+
+	for (i = q_tail; i != q_head; i = (i + 1) % TERRAIN_QUEUE){
+		if (queue[i] == key)
+			return;
+	}
+	if ((q_head + 1) % TERRAIN_QUEUE == q_tail)
+		return;
+
+	queue[q_head] = key;
+	q_head = (q_head + 1) % TERRAIN_QUEUE;
+	pthread_cond_signal(&wake);
+}
@@ -0,0 +1,75 @@
+/*
+ * \file terrain.h
+ *	\details
+ *     Description:     Terrain height from SRTM .hgt DEM tiles. Tiles are loaded by a background
+ *                      thread into a fixed LRU cache of decoded tiles, so a lookup on the control
+ *                      thread is a scan of the cache and a bilinear interpolation, never file I/O.
+ *                      A lookup of a tile that is not cached queues it for loading and reports
+ *                      no terrain until it is in; terrain_prefetch() queues tiles ahead of time.
+ *                      DEM heights are above the EGM96 geoid; each tile is loaded with the geoid
+ *                      undulation at its corners from TERRAIN_GEOID_FILE so heights are reported above
+ *                      the WGS84 ellipsoid, the reference of navData->alt.
+ *	\ingroup nav_fcns
+ *
+ *  \author University of Minnesota
+ *  \author Aerospace Engineering and Mechanics
+ *  \copyright Copyright 2015 Regents of the University of Minnesota.  All rights reserved.
+ */
+
+#ifndef SOURCE_NAVIGATION_TERRAIN_H_
+#define SOURCE_NAVIGATION_TERRAIN_H_
+
+#ifndef TERRAIN_DIR
+	#define TERRAIN_DIR			"terrain"	///< directory of the 1x1 deg tiles, named as N44W094.hgt
+#endif
+
+#ifndef TERRAIN_TILE_SIZE
+	#define TERRAIN_TILE_SIZE	1201		///< posts per tile side: 1201 for 3 arcsec SRTM3, 3601 for 1 arcsec SRTM1
+#endif
+
+#ifndef TERRAIN_GEOID_FILE
+	#define TERRAIN_GEOID_FILE	TERRAIN_DIR "/WW15MGH.GRD"	///< EGM96 undulation grid, NGA ASCII .GRD format
+#endif
+
+#ifndef TERRAIN_CACHE_TILES
+	#define TERRAIN_CACHE_TILES	4			///< decoded tiles kept, 2.9 MB each for SRTM3, allocated by init_terrain()
+#endif
+
+#define TERRAIN_QUEUE			16			///< capacity of the load request queue
+#define TERRAIN_VOID			(-32768)	///< SRTM no-data post
+
+/// Allocate the tile cache and start the tile loader thread. Does nothing if it is already running.
+/*!
+* \return 0 on success, -1 if the cache could not be allocated or the thread could not be created
+* \ingroup nav_fcns
+*/
+int init_terrain(void);
+
+/// Stop the tile loader thread and free the tile cache.
+/*!
+* \ingroup nav_fcns
+*/
+void close_terrain(void);
+
+/// Terrain height at a position, bilinearly interpolated between the four surrounding posts.
+/*!
+* Heights are above the WGS84 ellipsoid, as navData->alt: the DEM height above the EGM96 geoid plus the geoid
+* undulation, bilinearly interpolated between the corners of the tile.
+* \return 1 if the height is known, 0 if its tile is not loaded (it is then queued), missing, without a geoid
+* undulation, or void there
+* \ingroup nav_fcns
+*/
+int terrain_height(double lat,		///< [rad], geodetic latitude
+				   double lon,		///< [rad], longitude
+				   double *h		///< [m], terrain height
+				   );
+
+/// Queue the tile holding a position for loading, if it is not cached or queued already.
+/*!
+* \ingroup nav_fcns
+*/
+void terrain_prefetch(double lat,	///< [rad], geodetic latitude
+					  double lon	///< [rad], longitude
+					  );
+
+#endif /* SOURCE_NAVIGATION_TERRAIN_H_ */
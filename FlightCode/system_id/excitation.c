@@ -0,0 +1,183 @@
+/*! \file excitation.c
+ *	\brief Excitation signal synthesis source code
+ *
+ *	\details System ID excitation signals loaded from a data file and synthesized into tables, see excitation.h.
+ *	\ingroup systemid_fcns
+ *
+ * \author University of Minnesota
+ * \author Aerospace Engineering and Mechanics
+ * \copyright Copyright 2015 Regents of the University of Minnesota. All rights reserved.
+ *
+ * $Id$
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "../globaldefs.h"
+#include AIRCRAFT_UP1DIR
+#include "excitation.h"
+
+/// One signal and its table
+struct signal {
+	unsigned short run;		///< engagement the signal is applied on, 0 for every engagement
+	int surface;			///< enum excitation_surface
+	double amp;				///< [rad], or [ND] for the throttle, amplitude
+	double start;			///< [sec], start time since engagement
+	int offset;				///< first sample of the table in the pool
+	int length;				///< number of samples
+};
+
+/// Definition of one signal while the file is read
+struct signal_def {
+	struct signal sig;
+	double duration;				///< [sec]
+	int nsine;						///< number of sines
+	double freq[EXCITATION_NSINE];	///< [Hz]
+	double phase[EXCITATION_NSINE];	///< [rad]
+	int nsamp;						///< number of time history samples, at pool[sig.offset]
+};
+
+// local functions
+static int parse_surface(const char *name);
+static int synthesize(struct signal_def *d, float *pool, int used);
+
+static const char *const surface_name[EXCITE_NSURF] = {"de", "da", "dr", "dthr", "df_l", "df_r"};
+
+static float pool[EXCITATION_POOL];
+static struct signal signals[EXCITATION_NSIG];
+static int nsig;
+
+int load_excitation(const char *filename){
+	static float tmp_pool[EXCITATION_POOL];
+	static struct signal_def def[EXCITATION_NSIG];
+	FILE *fp;
+	char line[EXCITATION_LINE], name[16], surf[8], *p, *end;
+	struct signal_def *d = NULL;
+	int n, k, used = 0, ndef = 0, ok = 1;
+	double v;
+
+	if ((fp = fopen(filename, "r")) == NULL)
+		return -1;
+
+	while (ok && fgets(line, sizeof(line), fp) != NULL){
+		if (strchr(line, '\n') == NULL && getc(fp) != EOF){
+			ok = 0;		// line too long, it would be read in pieces
+			break;
+		}
+		if (sscanf(line, "%15s%n", name, &n) != 1 || name[0] == '#')
+			continue;	// blank line or comment
+
+		if (strcmp(name, "signal") == 0){
+			if (ndef == EXCITATION_NSIG){
+				ok = 0;		// too many signals
+				break;
+			}
+			d = &def[ndef++];
+			memset(d, 0, sizeof(*d));
+			if (sscanf(line + n, "%hu %7s %lf %lf %lf", &d->sig.run, surf, &d->sig.amp, &d->sig.start, &d->duration) != 5
+					|| (d->sig.surface = parse_surface(surf)) < 0 || d->duration <= 0.0)
+				ok = 0;
+			d->sig.offset = used;
+		}
+		else if (strcmp(name, "sine") == 0){
+			if (d == NULL || d->nsamp > 0 || d->nsine == EXCITATION_NSINE
+					|| sscanf(line + n, "%lf %lf", &d->freq[d->nsine], &d->phase[d->nsine]) != 2
+					|| !(d->freq[d->nsine] >= 0.0 && d->freq[d->nsine] < 0.5/TIMESTEP))
+				ok = 0;
+			else
+				d->nsine++;
+		}
+		else if (strcmp(name, "samples") == 0){
+			if (d == NULL || d->nsine > 0){
+				ok = 0;
+				break;
+			}
+			p = line + n;
+			for (v = strtod(p, &end); end != p; v = strtod(p, &end)){
+				if (used == EXCITATION_POOL){
+					ok = 0;	// pool full
+					break;
+				}
+				tmp_pool[used++] = (float)(v*d->sig.amp);
+				d->nsamp++;
+				p = end;
+			}
+		}
+	}
+	fclose(fp);
+
+	// Sines are synthesized after the time histories, each into the pool space that follows
+	for (k = 0; ok && k < ndef; k++){
+		if (def[k].nsine == 0 && def[k].nsamp == 0)
+			ok = 0;		// empty signal
+		else if (def[k].nsine > 0)
+			ok = ((used = synthesize(&def[k], tmp_pool, used)) >= 0);
+		else
+			def[k].sig.length = mymin(def[k].nsamp, (int)(def[k].duration/TIMESTEP + 0.5));
+	}
+	if (!ok)
+		return -1;
+
+	memcpy(pool, tmp_pool, used*sizeof(float));
+	for (k = 0; k < ndef; k++)
+		signals[k] = def[k].sig;
+	nsig = ndef;
+	return 0;
+}
+
+int get_excitation(double time, unsigned short run_num, double *u){
+	const struct signal *s;
+	int k, i, active = 0;
+
+	for (k = 0; k < EXCITE_NSURF; k++)
+		u[k] = 0.0;
+
+	for (k = 0; k < nsig; k++){
+		s = &signals[k];
+		if (s->run != 0 && s->run != run_num)
+			continue;
+		i = (int)floor((time - s->start)/TIMESTEP + 0.5);	// nearest frame of the table
+		if (i < 0 || i >= s->length)
+			continue;
+		u[s->surface] += pool[s->offset + i];
+		active = 1;
+	}
+	return active;
+}
+
+/// Surface of a name, -1 if unknown.
+static int parse_surface(const char *name){
+	int k;
+
+	for (k = 0; k < EXCITE_NSURF; k++){
+		if (strcmp(name, surface_name[k]) == 0)
+			return k;
+	}
+	return -1;
+}
+
+/// Sample the sum of the sines of a signal at each frame of its duration into the pool from used on.
+/*!
+ * \return samples of the pool in use after the table, -1 if the table does not fit
+ */
+static int synthesize(struct signal_def *d, float *pool, int used){
+	double a = d->sig.amp*sqrt(1.0/d->nsine), t, y;
+	int n = (int)(d->duration/TIMESTEP + 0.5), i, j;
+
+	if (n > EXCITATION_POOL - used)
+		return -1;
+
+	d->sig.offset = used;
+	d->sig.length = n;
+	for (i = 0; i < n; i++){
+		t = i*TIMESTEP;
+		y = 0.0;
+		for (j = 0; j < d->nsine; j++)
+			y += cos(PI2*d->freq[j]*t + d->phase[j]);
+		pool[used + i] = (float)(a*y);
+	}
+	return used + n;
+}
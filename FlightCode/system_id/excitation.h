@@ -0,0 +1,69 @@
+/*! \file excitation.h
+ *	\brief Excitation signal synthesis interface header
+ *
+ *	\details System ID excitation signals defined in a data file, EXCITATION_FILE, instead of autogenerated
+ *	headers, so a new test signal needs no rebuild. Each signal is synthesized once, when the file is loaded, into
+ *	a table of one sample per frame over its duration; in flight a signal costs one table lookup per frame whatever
+ *	the number of its frequencies. The tables share a pool of EXCITATION_POOL samples.
+ *
+ *	File format, one entry per line, # for comments:
+ *
+ *	\code
+ *	signal <run> <surface> <amplitude> <start> <duration>
+ *	sine <frequency> <phase>
+ *	samples <u> <u> ...
+ *	\endcode
+ *
+ *	A signal is applied on engagement run, or on every engagement for run 0, to surface de, da, dr, dthr, df_l or
+ *	df_r, from start to start + duration seconds after the engagement. It is the sum of the sine lines that follow it, in Hz
+ *	and rad, each of amplitude/sqrt(n) for n sines as in three_multi_sine(), or the time history of the samples
+ *	lines that follow it, one sample per TIMESTEP scaled by amplitude. A long time history is split over several samples
+ *	lines, each shorter than EXCITATION_LINE characters. The aileron signal is applied antisymmetric,
+ *	+ on the right aileron. The flap channels excite whatever surface the aircraft allocates to them, the left
+ *	elevator and the top rudder on Baldr. A signal with a sine at or above the Nyquist frequency, a line that does not fit
+ *	EXCITATION_LINE or a file that does not fit the pool, is rejected as a whole.
+ *	\ingroup systemid_fcns
+ *
+ * \author University of Minnesota
+ * \author Aerospace Engineering and Mechanics
+ * \copyright Copyright 2015 Regents of the University of Minnesota. All rights reserved.
+ *
+ * $Id$
+ */
+
+#ifndef EXCITATION_H_
+#define EXCITATION_H_
+
+#ifndef EXCITATION_FILE
+	#define EXCITATION_FILE		"excitation.txt"	///< excitation signals, see the format above
+#endif
+#ifndef EXCITATION_POOL
+	#define EXCITATION_POOL		16384	///< samples of all the tables, 5.5 min of signal at 50 Hz
+#endif
+
+#define EXCITATION_NSIG		16		///< most signals in the file
+#define EXCITATION_NSINE	32		///< most sines in a signal
+#define EXCITATION_LINE		512		///< [chars], line buffer of the file, newline included
+
+/// Excited surfaces
+enum excitation_surface {EXCITE_DE, EXCITE_DA, EXCITE_DR, EXCITE_DTHR, EXCITE_DF_L, EXCITE_DF_R, EXCITE_NSURF};
+
+/// Load and synthesize the signals of a file, in place of the signals loaded before.
+/*!
+ * \return 0 on success, -1 if the file is missing or invalid, the signals loaded before are kept
+ * \ingroup systemid_fcns
+ */
+int load_excitation(const char *filename	///< excitation file
+		);
+
+/// Sum of the signals active at a time of an engagement, per surface.
+/*!
+ * \return 1 if a signal is active, 0 otherwise
+ * \ingroup systemid_fcns
+ */
+int get_excitation(double time,		///< [sec], time since in autopilot mode
+		unsigned short run_num,		///< engagement counter
+		double *u					///< [rad], or [ND] for the throttle, excitation of each surface, enum excitation_surface
+		);
+
+#endif /* EXCITATION_H_ */
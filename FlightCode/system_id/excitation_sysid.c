@@ -0,0 +1,47 @@
+/*! \file excitation_sysid.c
+ *	\brief System ID excitation from a data file
+ *
+ *	\details Inject the excitation signals of EXCITATION_FILE on the elevator, aileron, rudder, throttle and flap
+ *	channels, on top of the control law commands. The file is loaded at the first call, see excitation.h.
+ *	\ingroup systemid_fcns
+ *
+ * \author University of Minnesota
+ * \author Aerospace Engineering and Mechanics
+ * \copyright Copyright 2015 Regents of the University of Minnesota. All rights reserved.
+ *
+ * $Id$
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "../globaldefs.h"
+#include AIRCRAFT_UP1DIR
+#include "../utils/misc.h"
+#include "systemid_interface.h"
+#include "excitation.h"
+
+extern void get_system_id(double time, struct sensordata *sensorData_ptr, struct nav *navData_ptr, struct control *controlData_ptr){
+	static short loaded = 0;
+	double u[EXCITE_NSURF];
+	char msg[96];
+
+	if (!loaded){
+		loaded = 1;
+		if (load_excitation(EXCITATION_FILE) != 0){
+			snprintf(msg, sizeof(msg), "excitation_sysid: %s missing or invalid, no excitation", EXCITATION_FILE);
+			send_status(msg);
+		}
+	}
+
+	if (!get_excitation(time, controlData_ptr->run_num, u))
+		return;
+
+	controlData_ptr->de   += u[EXCITE_DE];		// elevator
+	controlData_ptr->dr   += u[EXCITE_DR];		// rudder
+	controlData_ptr->da_r += u[EXCITE_DA];		// right aileron
+	controlData_ptr->da_l -= u[EXCITE_DA];		// left aileron
+	controlData_ptr->dthr += u[EXCITE_DTHR];	// throttle
+	controlData_ptr->df_l += u[EXCITE_DF_L];	// left flap, left elevator on Baldr
+	controlData_ptr->df_r += u[EXCITE_DF_R];	// right flap, top rudder on Baldr
+}
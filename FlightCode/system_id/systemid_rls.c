@@ -0,0 +1,200 @@
+/*! \file systemid_rls.c
+ *	\brief Onboard recursive least squares estimator source code
+ *
+ *	\details Stability and control derivatives of the moment equations, estimated in flight, see systemid_rls.h.
+ *	\ingroup systemid_fcns
+ *
+ * \author University of Minnesota
+ * \author Aerospace Engineering and Mechanics
+ * \copyright Copyright 2015 Regents of the University of Minnesota. All rights reserved.
+ *
+ * $Id$
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include "../globaldefs.h"
+#include AIRCRAFT_UP1DIR
+#include "systemid_rls.h"
+
+/// Data of one frame
+struct sample {
+	double p, q, r;			///< [rad/sec], body rates
+	double alpha, beta;		///< [rad], flow angles
+	double da, de, dr;		///< [rad], surface commands
+	short gap;				///< 1 if frames were dropped before this one
+};
+
+// local functions
+static void regressors(int axis, const struct sample *s0, const struct sample *s1, double *phi, double *y);
+static void rls_update(struct sysid_estimate *est, const double *phi, double y);
+
+static const int n_reg[SYSID_NAXES] = {5, 4, 5};
+static const int damping[SYSID_NAXES] = {1, 1, 2};	// index of the damping derivative
+static const int control[SYSID_NAXES] = {3, 2, 3};	// index of the control derivative
+static const char *const axis_name[SYSID_NAXES] = {"roll", "pitch", "yaw"};
+static const char *const param_name[SYSID_NAXES][SYSID_RLS_NMAX] = {
+		{"Lb", "Lp", "Lr", "Lda", "L0"},
+		{"Ma", "Mq", "Mde", "M0"},
+		{"Nb", "Np", "Nr", "Ndr", "N0"}};
+
+static struct sysid_estimate est[SYSID_NAXES];
+static struct sample buffer[SYSID_RLS_BUFFER];
+static int head, count;		// oldest stored frame, number of stored frames
+static short gap;			// frames dropped on a full buffer
+static struct sample last;	// last frame processed
+static short have_last;
+
+void reset_sysid_rls(void){
+	int k, i;
+
+	memset(est, 0, sizeof(est));
+	for (k = 0; k < SYSID_NAXES; k++){
+		est[k].n = n_reg[k];
+		for (i = 0; i < n_reg[k]; i++)
+			est[k].P[i][i] = SYSID_RLS_P0;
+	}
+	head = 0;
+	count = 0;
+	gap = 0;
+	have_last = 0;
+}
+
+void get_sysid_sample(struct sensordata *sensorData_ptr, struct control *controlData_ptr){
+	struct sample *s;
+
+	if (count == SYSID_RLS_BUFFER){
+		gap = 1;
+		return;
+	}
+
+	s = &buffer[(head + count) % SYSID_RLS_BUFFER];
+	s->p = sensorData_ptr->imuData_ptr->p;
+	s->q = sensorData_ptr->imuData_ptr->q;
+	s->r = sensorData_ptr->imuData_ptr->r;
+	s->alpha = sensorData_ptr->adData_ptr->aoa;
+	s->beta  = sensorData_ptr->adData_ptr->aos;
+	s->da = 0.5*(controlData_ptr->da_r - controlData_ptr->da_l);
+#if(defined(AIRCRAFT_BALDR) || defined(HIL_SIM))
+	s->de = 0.5*(controlData_ptr->de + controlData_ptr->df_l);	// left flap = left elevator
+	s->dr = 0.5*(controlData_ptr->dr + controlData_ptr->df_r);	// right flap = top rudder
+#else
+	s->de = controlData_ptr->de;
+	s->dr = controlData_ptr->dr;
+#endif
+	s->gap = gap;
+	gap = 0;
+	count++;
+}
+
+void update_sysid_rls(void){
+	double phi[SYSID_RLS_NMAX], y;
+	const struct sample *s;
+	int k;
+
+	for (; count > 0; count--, head = (head + 1) % SYSID_RLS_BUFFER){
+		s = &buffer[head];
+		if (have_last && !s->gap){
+			for (k = 0; k < SYSID_NAXES; k++){
+				regressors(k, &last, s, phi, &y);
+				rls_update(&est[k], phi, y);
+			}
+		}
+		last = *s;
+		have_last = 1;
+	}
+}
+
+int report_sysid_rls(int axis, unsigned short run_num, char *msg, int size){
+	const struct sysid_estimate *e;
+	double s2, err;
+	int i, n, ok;
+
+	if (axis < 0 || axis >= SYSID_NAXES)
+		return 0;
+	e = &est[axis];
+	if (e->frames == 0 || e->P[control[axis]][control[axis]] > 0.5*SYSID_RLS_P0)
+		return 0;	// not excited
+
+	s2 = e->ssr/mymax(e->weight - e->n, 1.0);
+	ok = (e->frames >= SYSID_RLS_MIN_FRAMES);
+	n = snprintf(msg, size, "Run %d %s:", run_num, axis_name[axis]);
+	for (i = 0; i < e->n - 1 && n < size; i++){	// the bias is not reported
+		err = (e->P[i][i] < SYSID_RLS_P0) ? sqrt(s2*e->P[i][i])/mymax(fabs(e->theta[i]), 1e-9) : HUGE_VAL;
+		if ((i == damping[axis] || i == control[axis]) && !(err <= SYSID_RLS_GOOD))
+			ok = 0;
+		if (err == HUGE_VAL)
+			continue;	// not excited, alpha and beta without a 5-hole Pitot probe
+		n += snprintf(msg + n, size - n, " %s %.3g %.0f%%", param_name[axis][i], e->theta[i], mymin(100.0*err, 999.0));
+	}
+	if (n < size)
+		n += snprintf(msg + n, size - n, ok ? " ok" : " repeat");
+	return (n < size) ? n : size - 1;
+}
+
+const struct sysid_estimate *get_sysid_estimate(int axis){
+	if (axis < 0 || axis >= SYSID_NAXES)
+		return NULL;
+	return &est[axis];
+}
+
+/// Regressors and rate derivative of an axis over the frame from s0 to s1.
+static void regressors(int axis, const struct sample *s0, const struct sample *s1, double *phi, double *y){
+	double alpha = 0.5*(s0->alpha + s1->alpha), beta = 0.5*(s0->beta + s1->beta);
+	double p = 0.5*(s0->p + s1->p), q = 0.5*(s0->q + s1->q), r = 0.5*(s0->r + s1->r);
+
+	switch (axis){
+	case SYSID_ROLL:
+		*y = (s1->p - s0->p)/TIMESTEP;
+		phi[0] = beta; phi[1] = p; phi[2] = r; phi[3] = s0->da; phi[4] = 1.0;
+		break;
+	case SYSID_PITCH:
+		*y = (s1->q - s0->q)/TIMESTEP;
+		phi[0] = alpha; phi[1] = q; phi[2] = s0->de; phi[3] = 1.0;
+		break;
+	default:
+		*y = (s1->r - s0->r)/TIMESTEP;
+		phi[0] = beta; phi[1] = p; phi[2] = r; phi[3] = s0->dr; phi[4] = 1.0;
+		break;
+	}
+}
+
+/// One recursive least squares step with exponential forgetting. Forgetting stops while the covariance is above its
+/// initial trace, so it cannot wind up in directions the inputs do not excite.
+static void rls_update(struct sysid_estimate *est, const double *phi, double y){
+	double Pphi[SYSID_RLS_NMAX], K[SYSID_RLS_NMAX];
+	double e = y, lambda = SYSID_RLS_LAMBDA, trace = 0.0, den;
+	int n = est->n, i, j;
+
+	for (i = 0; i < n; i++)
+		trace += est->P[i][i];
+	if (trace > n*SYSID_RLS_P0)
+		lambda = 1.0;
+
+	den = lambda;
+	for (i = 0; i < n; i++){
+		Pphi[i] = 0.0;
+		for (j = 0; j < n; j++)
+			Pphi[i] += est->P[i][j]*phi[j];
+		den += phi[i]*Pphi[i];
+		e -= phi[i]*est->theta[i];
+	}
+	for (i = 0; i < n; i++){
+		K[i] = Pphi[i]/den;
+		est->theta[i] += K[i]*e;
+	}
+
+	// P = (P - K*phi'*P)/lambda, kept symmetric
+	for (i = 0; i < n; i++){
+		for (j = i; j < n; j++){
+			est->P[i][j] = (est->P[i][j] - K[i]*Pphi[j])/lambda;
+			est->P[j][i] = est->P[i][j];
+		}
+	}
+
+	est->ssr = SYSID_RLS_LAMBDA*est->ssr + e*e;
+	est->weight = SYSID_RLS_LAMBDA*est->weight + 1.0;
+	est->frames++;
+}
@@ -0,0 +1,105 @@
+/*! \file systemid_rls.h
+ *	\brief Onboard recursive least squares estimator interface header
+ *
+ *	\details Estimates the dimensional stability and control derivatives of the three moment equations in flight,
+ *	while the system ID functions excite the aircraft, so a test point can be confirmed before landing:
+ *
+ *	\code
+ *	p_dot = Lb*beta  + Lp*p + Lr*r + Lda*da + L0
+ *	q_dot = Ma*alpha + Mq*q        + Mde*de + M0
+ *	r_dot = Nb*beta  + Np*p + Nr*r + Ndr*dr + N0
+ *	\endcode
+ *
+ *	with da = (da_r - da_l)/2, the surfaces as commanded. Each equation is solved by recursive least squares with
+ *	exponential forgetting, O(n^2) per frame for n regressors. The rate derivative over a frame is the rate difference
+ *	divided by TIMESTEP, regressed on the mean of the rates at both ends and the surface command held over the frame,
+ *	so no differentiator is needed. Alpha and beta come from the 5-hole Pitot probe; without one they read zero and
+ *	their derivatives are left unestimated. The bias terms absorb the trim.
+ *
+ *	The control loop only stores the data of each frame; the estimator runs on the stored frames in the background,
+ *	at the telemetry rate. An axis is reported once its control derivative has been excited, with the 1-sigma error
+ *	of each derivative relative to its value, and marked ok once the damping and control derivatives are all known to
+ *	within SYSID_RLS_GOOD. The settings can be overridden in aircraft/XXX_config.h.
+ *	\ingroup systemid_fcns
+ *
+ * \author University of Minnesota
+ * \author Aerospace Engineering and Mechanics
+ * \copyright Copyright 2015 Regents of the University of Minnesota. All rights reserved.
+ *
+ * $Id$
+ */
+
+#ifndef SYSTEMID_RLS_H_
+#define SYSTEMID_RLS_H_
+
+#ifndef SYSID_RLS_LAMBDA
+	#define SYSID_RLS_LAMBDA	0.999	///< forgetting factor, a memory of about 1/(1-lambda) frames
+#endif
+#ifndef SYSID_RLS_P0
+	#define SYSID_RLS_P0		1.0e4	///< initial covariance, the same on each parameter
+#endif
+#ifndef SYSID_RLS_GOOD
+	#define SYSID_RLS_GOOD		0.10	///< largest relative 1-sigma error of a damping or control derivative for ok
+#endif
+#ifndef SYSID_RLS_MIN_FRAMES
+	#define SYSID_RLS_MIN_FRAMES	250	///< frames before an axis can be ok
+#endif
+#ifndef SYSID_RLS_BUFFER
+	#define SYSID_RLS_BUFFER	64		///< frames stored between background updates
+#endif
+
+#define SYSID_RLS_NMAX	5	///< most regressors of an axis
+
+/// Moment equations
+enum sysid_axis {SYSID_ROLL, SYSID_PITCH, SYSID_YAW, SYSID_NAXES};
+
+/// Estimate of one moment equation
+struct sysid_estimate {
+	int n;								///< number of regressors
+	long frames;						///< frames processed
+	double theta[SYSID_RLS_NMAX];		///< derivatives, in the order of the equation, bias last
+	double P[SYSID_RLS_NMAX][SYSID_RLS_NMAX];	///< covariance, per unit residual variance
+	double ssr;							///< exponentially weighted sum of the squared residuals
+	double weight;						///< exponentially weighted number of frames
+};
+
+/// Clear the estimates and the stored frames, at autopilot engagement.
+/*!
+ * \ingroup systemid_fcns
+ */
+void reset_sysid_rls(void);
+
+/// Store the data of the frame. Call once per frame after set_actuators(), in autopilot mode.
+/*!
+ * \ingroup systemid_fcns
+ */
+void get_sysid_sample(struct sensordata *sensorData_ptr,	///< pointer to sensorData structure
+		struct control *controlData_ptr		///< pointer to controlData structure, surfaces as commanded
+		);
+
+/// Run the estimator on the frames stored since the last call. Background task.
+/*!
+ * \ingroup systemid_fcns
+ */
+void update_sysid_rls(void);
+
+/// Format the derivatives of an axis, at autopilot disengagement.
+/*!
+ * \return length of the message, 0 if the control derivative of the axis was not excited
+ * \ingroup systemid_fcns
+ */
+int report_sysid_rls(int axis,		///< moment equation, enum sysid_axis
+		unsigned short run_num,		///< engagement counter, for the message
+		char *msg,					///< message buffer
+		int size					///< [bytes], size of the message buffer
+		);
+
+/// Estimate of an axis, for logging.
+/*!
+ * \return pointer to the estimate, NULL for an invalid axis
+ * \ingroup systemid_fcns
+ */
+const struct sysid_estimate *get_sysid_estimate(int axis	///< moment equation, enum sysid_axis
+		);
+
+#endif /* SYSTEMID_RLS_H_ */
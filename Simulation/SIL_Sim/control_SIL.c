@@ -26,8 +26,13 @@
 
 // Include flightcode interfaces
 #include "globaldefs.h"
+#include "utils/misc.h"
+#include "navigation/nav_interface.h"
 #include "guidance/guidance_interface.h"
 #include "control/control_interface.h"
+#include "control/reference_filter.h"
+#include "control/gain_schedule.h"
+#include "control/control_allocation.h"
 #include "system_id/systemid_interface.h"
 #include "faults/fault_interface.h"
 
@@ -54,6 +59,11 @@ struct  airdata adData;
 // sensor data 
 static struct sensordata sensorData;
 
+// Status messages of the flight code go to the MATLAB command window instead of the telemetry
+void send_status(char *status_message){
+    mexPrintf("%s\n", status_message);
+}
+
 /*========================================================================*
  *                          Initialization                                *
  *========================================================================*/
@@ -96,7 +106,12 @@ static void mdlInitializeSampleTimes(SimStruct *S) {
 static void mdlStart(SimStruct *S) {
     static int run_num=0;
     run_num++;
+    init_gain_schedule();        // load the gain schedule of the aircraft configuration
+    init_control_allocation();   // precompute the surface allocation of the aircraft configuration
+    init_control(&controlData);  // create the instance of the law selected by CONTROL_LAW
     reset_control(&controlData); // reset any internal states in the controller
+    reset_reference_filter();    // shape the commands of this run from the initial state
+    navData.ltp.valid = 0;       // latch a new LTP origin at the start of this run
     controlData.run_num = run_num;
 }
 
@@ -136,6 +151,11 @@ static void mdlOutputs(SimStruct *S, int_T tid) {
     navData.phi = *ssGetInputPortRealSignalPtrs(S, 0)[0]; // phi
     navData.the = *ssGetInputPortRealSignalPtrs(S, 0)[1]; // theta
     navData.psi = *ssGetInputPortRealSignalPtrs(S, 0)[2]; // psi
+    update_nav_trig(&navData);
+    if (!navData.ltp.valid)
+        set_nav_ltp_origin(&navData);	// simulation start is the engage point
+    else
+        update_nav_ltp(&navData);
     
     //**** GUIDANCE **********************************************************
     #ifdef SIMULINK_GUIDANCE
@@ -155,7 +175,11 @@ static void mdlOutputs(SimStruct *S, int_T tid) {
 
     #else
         // Compute guidance (reference) commands for the control law
+         restore_reference_filter(&controlData);   // the guidance law sees its raw commands of the previous frame
          get_guidance(TIME, &sensorData, &navData, &controlData);   
+
+        // Rate and acceleration limit the commands for the control law
+        get_reference_filter(&sensorData, &controlData);
     #endif  
     //************************************************************************		
 
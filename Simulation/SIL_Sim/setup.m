@@ -58,7 +58,7 @@ controller_mode = 2;
 switch controller_mode
     case 1 % Baseline controller in C
         % Compile Flight Software:
-        control_code_path = '../../Software/FlightCode/control/baseline_control.c';
+        control_law = 'baseline_control';
         
     case 2 % Baseline controller in Simulink.
         baseline_gains;   % Declare baseline controller gains
@@ -70,7 +70,7 @@ switch controller_mode
         
     case 3 % Heading controller in C
         % Compile Flight Software:
-        control_code_path ='../../Software/FlightCode/control/heading_tracker.c';
+        control_law = 'heading_tracker';
         
     case 4 % Heading controller in Simulink
         baseline_gains;  % heading controller lays on top of the baseline controller        
@@ -86,7 +86,7 @@ switch controller_mode
         
     case 5 % LQR controller in C
         % Compile Flight Software:
-        control_code_path ='../../Software/FlightCode/control/lqr_control.c';
+        control_law = 'ss_control'; % LQI design of lqr_control.mdl, see ss_control.h
         
     case 6 % LQR controller in Simulink
         % Parameters defined here are identical to those in lqr_control.c
@@ -96,14 +96,14 @@ switch controller_mode
         
     case 7 % Student controller in C 
         % Compile Flight Software:
-        control_code_path ='../../Software/FlightCode/control/student_control.c'; % Specify your control code file name here       
+        control_law = 'student_control'; % Specify your control law name here, as registered in control_laws.c       
            
     case 8 % Student controller in Simulink        
         % Get control gains
         
     case 9 % Waypoint tracker in C
         % Compile Flight Software:
-        control_code_path ='../../Software/FlightCode/control/waypoint_tracker.c';
+        control_law = 'waypoint_tracker';
 end
 
 % Advanced Users: Include guidance, system ID, or fault injection codes.
@@ -114,6 +114,10 @@ end
 % input the reference commands from the simulink diagram.
 % GUIDANCE = '../../Software/FlightCode/guidance/straight_level.c';
 % GUIDANCE = '../../Software/FlightCode/guidance/doublet_phi_theta.c';
+% GUIDANCE = '../../Software/FlightCode/guidance/waypoint_guidance.c ../../Software/FlightCode/guidance/mission.c ../../Software/FlightCode/navigation/nav_functions.c ../../Software/FlightCode/navigation/nav_environment.c ../../Software/FlightCode/utils/matrix.c';
+% GUIDANCE = '../../Software/FlightCode/guidance/path_following.c ../../Software/FlightCode/guidance/path_planner.c ../../Software/FlightCode/guidance/mission.c ../../Software/FlightCode/navigation/terrain.c';
+% GUIDANCE = '../../Software/FlightCode/guidance/rectangles.c ../../Software/FlightCode/guidance/schedule.c';
+% GUIDANCE = '../../Software/FlightCode/guidance/loiter_guidance.c ../../Software/FlightCode/guidance/loiter.c';
  GUIDANCE = '-DSIMULINK_GUIDANCE';
 
 %%%%%% SYSTEM ID SELECTION %%%%%
@@ -132,12 +136,27 @@ end
 % Point to the desired fault code here
  SENSOR_FAULT = '../../Software/FlightCode/faults/sensfault_none.c';
 
-% Compile control software
-if exist('control_code_path','var')
-    eval(['mex -I../../Software/FlightCode/ control_SIL.c  ' control_code_path...
+% Compile control software. All laws are linked in, control_law selects the
+% active one from the law table of control_laws.c
+CONTROL_LAWS = [' ../../Software/FlightCode/control/control_laws.c ' ...
+                ' ../../Software/FlightCode/control/baseline_control.c ' ...
+                ' ../../Software/FlightCode/control/heading_tracker.c ' ...
+                ' ../../Software/FlightCode/control/waypoint_tracker.c ' ...
+                ' ../../Software/FlightCode/control/student_control.c ' ...
+                ' ../../Software/FlightCode/control/ss_control.c ' ...
+                ' ../../Software/FlightCode/control/manual_control.c ' ...
+                ' ../../Software/FlightCode/control/empty_control.c ' ...
+                ' ../../Software/FlightCode/control/control_functions.c ' ...
+                ' ../../Software/FlightCode/control/control_allocation.c '];
+if exist('control_law','var')
+    eval(['mex -I../../Software/FlightCode/ -DCONTROL_LAW=\"' control_law '\" control_SIL.c ' CONTROL_LAWS...
                        ' ' GUIDANCE ' ' SYSTEM_ID ' ' SURFACE_FAULT ' ' SENSOR_FAULT ...
                        ' ../../Software/FlightCode/faults/fault_functions.c ' ...
-                       ' ../../Software/FlightCode/system_id/systemid_functions.c ']);
+                       ' ../../Software/FlightCode/control/reference_filter.c ' ...
+                       ' ../../Software/FlightCode/control/gain_schedule.c ' ...
+                       ' ../../Software/FlightCode/system_id/systemid_functions.c ' ...
+                       ' ../../Software/FlightCode/navigation/nav_trig.c ' ...
+                       ' ../../Software/FlightCode/navigation/nav_ltp.c ']);
 end
 
 